@@ -0,0 +1,68 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AutonomousChooser.hpp"
+#include "Benchmark.hpp"
+
+namespace {
+
+/**
+ * Measures the time the main robot thread spends in AwaitRunAutonomous() for
+ * each yield of an autonomous mode that does nothing but yield.
+ */
+void BenchmarkYield(frc3512::bench::State& state,
+                    frc3512::AutonomousChooser::ExecutionMode mode) {
+    bool enabled = true;
+    frc3512::AutonomousChooser chooser{"No-op", [] {}, mode};
+    chooser.AddAutonomous("Yield", [&] {
+        while (enabled) {
+            chooser.YieldToMain();
+        }
+    });
+    chooser.SelectAutonomous("Yield");
+
+    chooser.AwaitStartAutonomous();
+    for (auto _ : state) {
+        chooser.AwaitRunAutonomous();
+    }
+    enabled = false;
+    chooser.EndAutonomous();
+}
+
+void BM_AutonomousChooserYieldThread(frc3512::bench::State& state) {
+    BenchmarkYield(state, frc3512::AutonomousChooser::ExecutionMode::kThread);
+}
+BENCHMARK(BM_AutonomousChooserYieldThread);
+
+void BM_AutonomousChooserYieldFiber(frc3512::bench::State& state) {
+    BenchmarkYield(state, frc3512::AutonomousChooser::ExecutionMode::kFiber);
+}
+BENCHMARK(BM_AutonomousChooserYieldFiber);
+
+/**
+ * Measures one AwaitRunAutonomous() of a sequence that's waiting on a condition
+ * inside a deadline group, to compare with the yields above.
+ */
+void BM_AutonomousChooserSequenceUpdate(frc3512::bench::State& state) {
+    using Seq = frc3512::AutonomousSequence;
+
+    bool enabled = true;
+    frc3512::AutonomousChooser chooser{
+        "No-op", [] {}, frc3512::AutonomousChooser::ExecutionMode::kFiber};
+    chooser.AddAutonomous(
+        "Sequence",
+        Seq{Seq::Sequential(
+            Seq::Instant([] {}),
+            Seq::Deadline(Seq::WaitUntil([&] { return !enabled; }),
+                          Seq::Run([] {}, [] {})))});
+    chooser.SelectAutonomous("Sequence");
+
+    chooser.AwaitStartAutonomous();
+    for (auto _ : state) {
+        chooser.AwaitRunAutonomous();
+    }
+    enabled = false;
+    chooser.EndAutonomous();
+}
+BENCHMARK(BM_AutonomousChooserSequenceUpdate);
+
+}  // namespace
@@ -0,0 +1,70 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace frc3512::bench {
+
+namespace {
+
+constexpr int kRepetitions = 5;
+
+struct Benchmark {
+    std::string name;
+    Function function;
+};
+
+std::vector<Benchmark>& GetBenchmarks() {
+    // Constructed on first use since registration happens during static
+    // initialization of other translation units
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+double Run(Function function, int64_t iterations) {
+    State state{iterations};
+    function(state);
+    return std::chrono::duration<double, std::nano>(state.Elapsed()).count();
+}
+
+}  // namespace
+
+bool RegisterBenchmark(std::string_view name, Function function) {
+    GetBenchmarks().push_back({std::string{name}, function});
+    return true;
+}
+
+void RunBenchmarks(std::string_view filter, std::chrono::nanoseconds minTime) {
+    fmt::print("{:<40} {:>12} {:>12} {:>12} {:>12}\n", "Benchmark",
+               "Iterations", "Median (ns)", "Min (ns)", "Max (ns)");
+
+    for (const auto& benchmark : GetBenchmarks()) {
+        if (benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        int64_t iterations = 1;
+        while (Run(benchmark.function, iterations) < minTime.count() &&
+               iterations < (int64_t{1} << 40)) {
+            iterations *= 2;
+        }
+
+        std::array<double, kRepetitions> perIteration;
+        for (auto& sample : perIteration) {
+            sample = Run(benchmark.function, iterations) / iterations;
+        }
+        std::sort(perIteration.begin(), perIteration.end());
+
+        fmt::print("{:<40} {:>12} {:>12.1f} {:>12.1f} {:>12.1f}\n",
+                   benchmark.name, iterations, perIteration[kRepetitions / 2],
+                   perIteration.front(), perIteration.back());
+    }
+}
+
+}  // namespace frc3512::bench
@@ -0,0 +1,17 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+// Runs the microbenchmarks of the robot's control loop hot paths.
+//
+// Usage: frcUserProgramBench [filter]
+//
+// Only benchmarks whose names contain the filter are run.
+
+#include <hal/HAL.h>
+
+#include "Benchmark.hpp"
+
+int main(int argc, char* argv[]) {
+    HAL_Initialize(500, 0);
+
+    frc3512::bench::RunBenchmarks(argc > 1 ? argv[1] : "");
+}
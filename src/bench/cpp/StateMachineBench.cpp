@@ -0,0 +1,83 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <optional>
+
+#include "Benchmark.hpp"
+#include "StateMachine.hpp"
+
+namespace {
+
+enum class BenchState { kFirst, kSecond, kNumStates };
+
+/**
+ * Returns a state machine with two states. If toggle is true, each state
+ * transitions to the other every time it runs.
+ */
+StateMachine<BenchState> MakeStateMachine(const bool& toggle) {
+    StateMachine<BenchState> sm{"Bench"};
+
+    State<BenchState> state;
+    state.transition = [&toggle]() -> std::optional<BenchState> {
+        if (toggle) {
+            return BenchState::kSecond;
+        } else {
+            return std::nullopt;
+        }
+    };
+    sm.AddState(BenchState::kFirst, "FIRST", state);
+
+    state.transition = [&toggle]() -> std::optional<BenchState> {
+        if (toggle) {
+            return BenchState::kFirst;
+        } else {
+            return std::nullopt;
+        }
+    };
+    sm.AddState(BenchState::kSecond, "SECOND", state);
+
+    sm.Validate();
+    sm.SetInitialState(BenchState::kFirst);
+    sm.Enter();
+
+    return sm;
+}
+
+void BM_StateMachineRun(frc3512::bench::State& state) {
+    bool toggle = false;
+    auto sm = MakeStateMachine(toggle);
+    for (auto _ : state) {
+        sm.Run();
+    }
+}
+BENCHMARK(BM_StateMachineRun);
+
+void BM_StateMachineRunTransition(frc3512::bench::State& state) {
+    bool toggle = true;
+    auto sm = MakeStateMachine(toggle);
+    for (auto _ : state) {
+        sm.Run();
+    }
+}
+BENCHMARK(BM_StateMachineRunTransition);
+
+void BM_StateMachineSetState(frc3512::bench::State& state) {
+    bool toggle = false;
+    auto sm = MakeStateMachine(toggle);
+    for (auto _ : state) {
+        sm.SetState(BenchState::kSecond);
+        sm.SetState(BenchState::kFirst);
+    }
+}
+BENCHMARK(BM_StateMachineSetState);
+
+void BM_StateMachineSetStateByName(frc3512::bench::State& state) {
+    bool toggle = false;
+    auto sm = MakeStateMachine(toggle);
+    for (auto _ : state) {
+        frc3512::bench::DoNotOptimize(sm.SetState("SECOND"));
+        frc3512::bench::DoNotOptimize(sm.SetState("FIRST"));
+    }
+}
+BENCHMARK(BM_StateMachineSetStateByName);
+
+}  // namespace
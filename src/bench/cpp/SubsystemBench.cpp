@@ -0,0 +1,183 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stddef.h>
+
+#include <array>
+
+#include <ctre/phoenix/motorcontrol/can/WPI_TalonSRX.h>
+
+#include "Benchmark.hpp"
+#include "CANSensorSnapshot.hpp"
+#include "DrivetrainEstimator.hpp"
+#include "TalonSRXGroup.hpp"
+#include "subsystems/Drivetrain.hpp"
+#include "subsystems/Elevator.hpp"
+
+// The subsystems run against the HAL's simulated CAN bus on desktop. On the
+// roboRIO, they talk to whatever Talons are attached, so don't run this with
+// the robot enabled.
+
+namespace {
+
+/**
+ * Overwrites a buffer larger than the Cortex-A9's 32 KiB L1 data cache
+ * without timing it, so the next iteration starts with a cold cache like a
+ * controller tick does after the rest of the robot loop has run.
+ */
+void EvictCache(frc3512::bench::State& state) {
+    static std::array<unsigned char, 64 * 1024> buffer;
+
+    state.PauseTiming();
+    for (size_t i = 0; i < buffer.size(); i += 32) {
+        ++buffer[i];
+    }
+    frc3512::bench::DoNotOptimize(buffer);
+    state.ResumeTiming();
+}
+
+void BM_CANSensorSnapshotUpdate(frc3512::bench::State& state) {
+    Drivetrain drivetrain;
+    Elevator elevator;
+    for (auto _ : state) {
+        CANSensorSnapshot::GetInstance().Update();
+    }
+}
+BENCHMARK(BM_CANSensorSnapshotUpdate);
+
+void BM_ElevatorUpdateStateIdle(frc3512::bench::State& state) {
+    Elevator elevator;
+    for (auto _ : state) {
+        elevator.UpdateState();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateStateIdle);
+
+void BM_ElevatorUpdateStateStacking(frc3512::bench::State& state) {
+    // The elevator never reaches its goal without the controller running, so
+    // the auto-stack state machine stays in its first state and polls its
+    // transition every call
+    Elevator elevator;
+    elevator.StackTotes();
+    elevator.UpdateState();
+    for (auto _ : state) {
+        elevator.UpdateState();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateStateStacking);
+
+void BM_ElevatorUpdateController(frc3512::bench::State& state) {
+    Elevator elevator;
+    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
+    for (auto _ : state) {
+        elevator.UpdateController();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateController);
+
+void BM_ElevatorUpdateControllerLQR(frc3512::bench::State& state) {
+    Elevator elevator{Elevator::FeedbackMode::kLQR};
+    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
+    for (auto _ : state) {
+        elevator.UpdateController();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateControllerLQR);
+
+void BM_ElevatorUpdateControllerTalon(frc3512::bench::State& state) {
+    Elevator elevator{Elevator::FeedbackMode::kPD,
+                      TalonSRXGroup::ControllerLocation::kTalon};
+    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
+    for (auto _ : state) {
+        elevator.UpdateController();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateControllerTalon);
+
+void BM_ElevatorUpdateControllerColdCache(frc3512::bench::State& state) {
+    Elevator elevator;
+    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
+    for (auto _ : state) {
+        EvictCache(state);
+        elevator.UpdateController();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateControllerColdCache);
+
+void BM_DrivetrainUpdateControllers(frc3512::bench::State& state) {
+    Drivetrain drivetrain;
+    drivetrain.SetControllersEnabled(true);
+    drivetrain.SetLeftGoal(10_ft);
+    drivetrain.SetRightGoal(10_ft);
+    for (auto _ : state) {
+        drivetrain.UpdateControllers();
+    }
+}
+BENCHMARK(BM_DrivetrainUpdateControllers);
+
+void BM_DrivetrainUpdateControllersTalon(frc3512::bench::State& state) {
+    Drivetrain drivetrain{TalonSRXGroup::ControllerLocation::kTalon};
+    drivetrain.SetControllersEnabled(true);
+    drivetrain.SetLeftGoal(10_ft);
+    drivetrain.SetRightGoal(10_ft);
+    for (auto _ : state) {
+        drivetrain.UpdateControllers();
+    }
+}
+BENCHMARK(BM_DrivetrainUpdateControllersTalon);
+
+void BM_DrivetrainUpdateControllersColdCache(frc3512::bench::State& state) {
+    Drivetrain drivetrain;
+    drivetrain.SetControllersEnabled(true);
+    drivetrain.SetLeftGoal(10_ft);
+    drivetrain.SetRightGoal(10_ft);
+    for (auto _ : state) {
+        EvictCache(state);
+        drivetrain.UpdateControllers();
+    }
+}
+BENCHMARK(BM_DrivetrainUpdateControllersColdCache);
+
+/**
+ * Measures one estimator update including the replay from the encoder
+ * measurement's time.
+ */
+void BM_DrivetrainEstimatorUpdate(frc3512::bench::State& state) {
+    frc3512::DrivetrainEstimator estimator{
+        frc::LinearSystemId::DrivetrainVelocitySystem(
+            frc::DCMotor::CIM(2), Drivetrain::kMass, Drivetrain::kWheelRadius,
+            Drivetrain::kTrackWidth / 2.0, Drivetrain::kMomentOfInertia,
+            Drivetrain::kGearing),
+        Drivetrain::kTrackWidth};
+    units::second_t time = 0_s;
+    for (auto _ : state) {
+        time += frc3512::Constants::kControllerPeriod;
+        estimator.Update(time, 6_V, 6_V, 0_rad_per_s);
+        estimator.CorrectEncoders(time - 5_ms, 0_m, 0_m);
+    }
+}
+BENCHMARK(BM_DrivetrainEstimatorUpdate);
+
+void BM_TalonSRXGroupSetUnchanged(frc3512::bench::State& state) {
+    // Device IDs that aren't used by the subsystems
+    ctre::phoenix::motorcontrol::can::WPI_TalonSRX leader{20};
+    ctre::phoenix::motorcontrol::can::WPI_TalonSRX follower{21};
+    TalonSRXGroup group{leader, follower};
+    for (auto _ : state) {
+        group.Set(0.5);
+    }
+}
+BENCHMARK(BM_TalonSRXGroupSetUnchanged);
+
+void BM_TalonSRXGroupSetChanging(frc3512::bench::State& state) {
+    ctre::phoenix::motorcontrol::can::WPI_TalonSRX leader{20};
+    ctre::phoenix::motorcontrol::can::WPI_TalonSRX follower{21};
+    TalonSRXGroup group{leader, follower};
+    double speed = 0.5;
+    for (auto _ : state) {
+        group.Set(speed);
+        speed = -speed;
+    }
+}
+BENCHMARK(BM_TalonSRXGroupSetChanging);
+
+}  // namespace
@@ -0,0 +1,158 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <string_view>
+
+namespace frc3512::bench {
+
+/**
+ * Controls the timed loop of one benchmark run.
+ *
+ * The benchmark function sets up what it needs, then iterates over the State.
+ * Only the loop body is timed:
+ *
+ * @code
+ * void BM_Example(frc3512::bench::State& state) {
+ *     Widget widget;
+ *     for (auto _ : state) {
+ *         frc3512::bench::DoNotOptimize(widget.Update());
+ *     }
+ * }
+ * BENCHMARK(BM_Example);
+ * @endcode
+ */
+class State {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Iterator {
+    public:
+        // Marked unused so "for (auto _ : state)" doesn't warn
+        struct [[maybe_unused]] Value {};
+
+        Value operator*() const { return {}; }
+
+        Iterator& operator++() {
+            --m_remaining;
+            return *this;
+        }
+
+        bool operator!=(const Iterator&) {
+            if (m_remaining != 0) {
+                return true;
+            }
+            m_state->StopTiming();
+            return false;
+        }
+
+    private:
+        friend class State;
+
+        State* m_state;
+        int64_t m_remaining;
+
+        Iterator(State* state, int64_t remaining)
+            : m_state{state}, m_remaining{remaining} {}
+    };
+
+    /**
+     * Constructs a State that runs the loop body the given number of times.
+     *
+     * @param iterations Number of iterations.
+     */
+    explicit State(int64_t iterations) : m_iterations{iterations} {}
+
+    Iterator begin() {
+        m_start = Clock::now();
+        return Iterator{this, m_iterations};
+    }
+
+    Iterator end() { return Iterator{this, 0}; }
+
+    /**
+     * Stops the clock for work inside the loop that shouldn't be measured.
+     */
+    void PauseTiming() { StopTiming(); }
+
+    /**
+     * Restarts the clock stopped by PauseTiming().
+     */
+    void ResumeTiming() { m_start = Clock::now(); }
+
+    /**
+     * Returns the number of loop iterations.
+     */
+    int64_t Iterations() const { return m_iterations; }
+
+    /**
+     * Returns the time spent in the loop body.
+     */
+    Clock::duration Elapsed() const { return m_elapsed; }
+
+private:
+    int64_t m_iterations;
+    Clock::time_point m_start;
+    Clock::duration m_elapsed{0};
+
+    void StopTiming() { m_elapsed += Clock::now() - m_start; }
+};
+
+/**
+ * Prevents the compiler from optimizing away the computation of a value.
+ *
+ * @param value The value.
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#ifdef _MSC_VER
+    const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+    static_cast<void>(*sink);
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+using Function = void (*)(State& state);
+
+/**
+ * Adds a benchmark to the list run by RunBenchmarks().
+ *
+ * Use the BENCHMARK() macro instead of calling this directly.
+ *
+ * @param name     Name of the benchmark.
+ * @param function The benchmark function.
+ * @return Always true so it can initialize a static variable.
+ */
+bool RegisterBenchmark(std::string_view name, Function function);
+
+/**
+ * Runs every registered benchmark whose name contains the filter and prints
+ * the results.
+ *
+ * Each benchmark's iteration count is doubled until one run takes at least
+ * minTime. That count is then run several times, and the median time per
+ * iteration is reported along with the fastest and slowest runs.
+ *
+ * @param filter  Substring of the benchmark names to run. Empty runs all.
+ * @param minTime Minimum duration of one run.
+ */
+void RunBenchmarks(std::string_view filter = "",
+                   std::chrono::nanoseconds minTime =
+                       std::chrono::milliseconds{100});
+
+}  // namespace frc3512::bench
+
+#define FRC3512_BENCH_CONCAT_IMPL(a, b) a##b
+#define FRC3512_BENCH_CONCAT(a, b) FRC3512_BENCH_CONCAT_IMPL(a, b)
+
+/**
+ * Registers a benchmark function with the signature
+ * void(frc3512::bench::State&).
+ */
+#define BENCHMARK(function)                                         \
+    static const bool FRC3512_BENCH_CONCAT(kRegistered, __LINE__) = \
+        frc3512::bench::RegisterBenchmark(#function, function)
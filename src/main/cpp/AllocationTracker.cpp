@@ -0,0 +1,302 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AllocationTracker.hpp"
+
+#ifdef __linux__
+#include <link.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// The innermost scope of each thread
+thread_local AllocationTracker::Site* t_site = nullptr;
+
+/**
+ * An address and the loaded object containing it. If the object isn't known,
+ * the offset is the raw address.
+ */
+struct Location {
+    uintptr_t address;
+    const char* object = "unknown";
+    uintptr_t offset = address;
+};
+
+#ifdef __linux__
+int FindObject(dl_phdr_info* info, size_t, void* data) {
+    auto& location = *static_cast<Location*>(data);
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const auto& header = info->dlpi_phdr[i];
+        if (header.p_type != PT_LOAD) {
+            continue;
+        }
+
+        uintptr_t start = info->dlpi_addr + header.p_vaddr;
+        if (location.address >= start &&
+            location.address < start + header.p_memsz) {
+            // The executable is the only object without a name
+            location.object =
+                info->dlpi_name[0] != '\0' ? info->dlpi_name : "robot program";
+            location.offset = location.address - info->dlpi_addr;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+Location Locate(uintptr_t address) {
+    Location location{address};
+    dl_iterate_phdr(FindObject, &location);
+    return location;
+}
+#else
+Location Locate(uintptr_t address) {
+    // The loaded objects can't be listed here
+    return Location{address};
+}
+#endif
+
+}  // namespace
+
+const std::string& AllocationTracker::Site::GetName() const { return m_name; }
+
+uint64_t AllocationTracker::Site::GetCount() const {
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::Site::GetBytes() const {
+    return m_bytes.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::Site::Reset() {
+    m_count.store(0, std::memory_order_relaxed);
+    m_bytes.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < kMaxCallers; ++i) {
+        m_callers[i].store(0, std::memory_order_relaxed);
+        m_callerCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void AllocationTracker::Site::Record(size_t size, uintptr_t caller) {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < kMaxCallers; ++i) {
+        uintptr_t recorded = m_callers[i].load(std::memory_order_relaxed);
+        if (recorded == 0 && m_callers[i].compare_exchange_strong(
+                                 recorded, caller, std::memory_order_relaxed)) {
+            recorded = caller;
+        }
+        if (recorded == caller) {
+            m_callerCounts[i].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+AllocationTracker::Scope::Scope(Site& site) : m_previous{t_site} {
+    t_site = &site;
+}
+
+AllocationTracker::Scope::~Scope() { t_site = m_previous; }
+
+AllocationTracker& AllocationTracker::GetInstance() {
+    static AllocationTracker instance;
+    return instance;
+}
+
+AllocationTracker::Site& AllocationTracker::AddSite(std::string_view name) {
+    auto end = m_sites.begin() + m_numSites;
+    auto it = std::find_if(m_sites.begin(), end, [&](const Site& site) {
+        return site.GetName() == name;
+    });
+    if (it != end) {
+        return *it;
+    }
+
+    if (m_numSites == kMaxSites) {
+        throw std::length_error{"AllocationTracker: too many sites"};
+    }
+
+    auto& site = m_sites[m_numSites];
+    site.m_name = name;
+    ++m_numSites;
+
+    return site;
+}
+
+void AllocationTracker::SetMode(Mode mode) {
+    m_mode.store(mode, std::memory_order_relaxed);
+}
+
+void AllocationTracker::Report() const {
+    for (size_t i = 0; i < m_numSites; ++i) {
+        const auto& site = m_sites[i];
+        if (site.GetCount() == 0) {
+            continue;
+        }
+
+        PrintFixed(FMT_COMPILE("Allocations in {}: {} ({} bytes)\n"),
+                   site.GetName(), site.GetCount(), site.GetBytes());
+
+        uint64_t attributed = 0;
+        for (size_t j = 0; j < Site::kMaxCallers; ++j) {
+            uintptr_t caller =
+                site.m_callers[j].load(std::memory_order_relaxed);
+            if (caller == 0) {
+                break;
+            }
+
+            uint64_t count =
+                site.m_callerCounts[j].load(std::memory_order_relaxed);
+            attributed += count;
+
+            auto location = Locate(caller);
+            PrintFixed(FMT_COMPILE("  {:>8} from {}+{:#x}\n"), count,
+                       location.object, location.offset);
+        }
+        if (attributed < site.GetCount()) {
+            PrintFixed(FMT_COMPILE("  {:>8} from other callers\n"),
+                       site.GetCount() - attributed);
+        }
+    }
+}
+
+void AllocationTracker::Reset() {
+    for (size_t i = 0; i < m_numSites; ++i) {
+        m_sites[i].Reset();
+    }
+}
+
+void AllocationTracker::OnAllocate(size_t size, void* caller) {
+    Site* site = t_site;
+    if (site == nullptr) {
+        return;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(caller);
+    site->Record(size, address);
+
+    if (GetInstance().m_mode.load(std::memory_order_relaxed) == Mode::kAbort) {
+        // Reporting doesn't allocate, but don't let it recurse if it does
+        t_site = nullptr;
+        auto location = Locate(address);
+        PrintFixed(stderr,
+                   FMT_COMPILE("AllocationTracker: {} allocated {} bytes from "
+                               "{}+{:#x}\n"),
+                   site->GetName(), size, location.object, location.offset);
+        std::abort();
+    }
+}
+
+}  // namespace frc3512
+
+#ifdef __linux__
+
+namespace {
+
+void* Allocate(size_t size, void* caller) {
+    frc3512::AllocationTracker::OnAllocate(size, caller);
+
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        void* ptr = std::malloc(size);
+        if (ptr != nullptr) {
+            return ptr;
+        }
+
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment, void* caller) {
+    frc3512::AllocationTracker::OnAllocate(size, caller);
+
+    // posix_memalign() needs at least pointer alignment
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, align, size) == 0) {
+            return ptr;
+        }
+
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+}  // namespace
+
+// Replacements for the global allocation functions, so allocations can be
+// charged to the caller's AllocationTracker::Scope. The library forwards the
+// remaining variants to these. MSVC's runtime doesn't forward them the same
+// way, so they're only replaced on Linux.
+
+void* operator new(size_t size) {
+    return Allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size) {
+    return Allocate(size, __builtin_return_address(0));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size, __builtin_return_address(0));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size, __builtin_return_address(0));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment, __builtin_return_address(0));
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+#endif  // __linux__
@@ -0,0 +1,54 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Arena.hpp"
+
+#include "ThreadPolicy.hpp"
+
+namespace frc3512 {
+
+Arena& Arena::GetInstance() {
+    static Arena instance{kDefaultCapacity};
+    return instance;
+}
+
+Arena::Arena(size_t capacity)
+    : m_block{std::make_unique<std::byte[]>(capacity)}, m_capacity{capacity} {
+    ThreadPolicy::LockRegion(m_block.get(), m_capacity);
+}
+
+Arena::~Arena() = default;
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+    auto start = reinterpret_cast<uintptr_t>(m_block.get());
+
+    size_t used = m_used.load(std::memory_order_relaxed);
+    while (true) {
+        // Round the end of the used space up to the alignment
+        size_t offset =
+            ((start + used + alignment - 1) & ~(alignment - 1)) - start;
+        if (offset + size > m_capacity || size > m_capacity) {
+            break;
+        }
+        if (m_used.compare_exchange_weak(used, offset + size,
+                                         std::memory_order_relaxed)) {
+            return m_block.get() + offset;
+        }
+    }
+
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size, std::align_val_t{alignment});
+}
+
+void Arena::Deallocate(void* ptr, size_t size, size_t alignment) {
+    if (!Contains(ptr)) {
+        ::operator delete(ptr, size, std::align_val_t{alignment});
+    }
+}
+
+size_t Arena::GetUsed() const { return m_used.load(std::memory_order_relaxed); }
+
+size_t Arena::GetOverflowCount() const {
+    return m_overflows.load(std::memory_order_relaxed);
+}
+
+}  // namespace frc3512
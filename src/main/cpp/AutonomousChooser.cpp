@@ -2,20 +2,34 @@
 
 #include "AutonomousChooser.hpp"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <algorithm>
+#include <utility>
 
-#include <fmt/core.h>
+#include <frc/RobotController.h>
+#include <frc/Threads.h>
 #include <frc/smartdashboard/SmartDashboard.h>
 
+#include "EventLog.hpp"
+#include "FixedFormat.hpp"
+#include "Futex.hpp"
+#include "ThreadPolicy.hpp"
+
 namespace frc3512 {
 
 AutonomousChooser::AutonomousChooser(wpi::StringRef name,
-                                     std::function<void()> func) {
+                                     std::function<void()> func,
+                                     ExecutionMode mode)
+    : m_executionMode{mode} {
     m_defaultChoice = name;
-    m_choices[name] = func;
+    m_choices[name].func = func;
     m_names.emplace_back(name);
 
-    m_selectedChoice = name;
+    m_selectedChoice.Store(Name{{name.data(), name.size()}});
     m_selectedAuton = &m_choices[name];
 
     frc::SmartDashboard::PutData("Autonomous modes", this);
@@ -26,25 +40,55 @@ AutonomousChooser::AutonomousChooser(wpi::StringRef name,
                 return;
             }
 
-            {
-                std::scoped_lock lock{m_mutex};
-                m_selectedChoice = event.value->GetString();
-            }
-
-            m_activeEntry.SetString(m_selectedChoice);
+            auto name = event.value->GetString();
+            m_selectedChoice.Store(Name{{name.data(), name.size()}});
         },
         NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
             NT_NOTIFY_LOCAL);
+
+    m_publisherHandle = TelemetryPublisher::GetInstance().AddPublisher(
+        [=] { PublishActive(); });
+
+    // The worker is spawned once up front so thread creation doesn't delay
+    // the start of the match
+    if (m_executionMode == ExecutionMode::kThread) {
+        m_autonThread = std::thread{[=] { RunWorker(); }};
+    }
 }
 
 AutonomousChooser::~AutonomousChooser() {
     EndAutonomous();
+
+    if (m_autonThread.joinable()) {
+        HandOff(kExit);
+        m_autonThread.join();
+    }
+
     m_selectedEntry.RemoveListener(m_selectedListenerHandle);
+    TelemetryPublisher::GetInstance().RemovePublisher(m_publisherHandle);
 }
 
 void AutonomousChooser::AddAutonomous(wpi::StringRef name,
-                                      std::function<void()> func) {
-    m_choices[name] = func;
+                                      std::function<void()> func,
+                                      std::function<void()> warmUp) {
+    auto& choice = m_choices[name];
+    choice.func = func;
+    choice.warmUp = std::move(warmUp);
+    m_names.emplace_back(name);
+
+    // Unlike std::map, wpi::StringMap elements are not sorted
+    std::sort(m_names.begin(), m_names.end());
+
+    m_optionsEntry.SetStringArray(m_names);
+}
+
+void AutonomousChooser::AddAutonomous(wpi::StringRef name,
+                                      AutonomousSequence sequence,
+                                      std::function<void()> warmUp) {
+    auto& choice = m_choices[name];
+    choice.sequence = std::move(sequence);
+    choice.isSequence = true;
+    choice.warmUp = std::move(warmUp);
     m_names.emplace_back(name);
 
     // Unlike std::map, wpi::StringMap elements are not sorted
@@ -54,10 +98,7 @@ void AutonomousChooser::AddAutonomous(wpi::StringRef name,
 }
 
 void AutonomousChooser::SelectAutonomous(wpi::StringRef name) {
-    {
-        std::scoped_lock lock{m_mutex};
-        m_selectedChoice = name;
-    }
+    m_selectedChoice.Store(Name{{name.data(), name.size()}});
     m_selectedEntry.SetString(name);
 }
 
@@ -65,53 +106,210 @@ const std::vector<std::string>& AutonomousChooser::GetAutonomousNames() const {
     return m_names;
 }
 
+bool AutonomousChooser::WarmUpSelected() {
+    auto selected = m_selectedChoice.Load();
+    auto name = selected.View();
+    uint64_t now = frc::RobotController::GetFPGATime();
+
+    bool changed = name != m_warmedChoice;
+    if (!changed && units::microsecond_t{static_cast<double>(
+                        now - m_lastWarmUpTime)} < kWarmUpPeriod) {
+        return false;
+    }
+
+    auto it = m_choices.find(wpi::StringRef{name.data(), name.size()});
+    if (it == m_choices.end()) {
+        return false;
+    }
+
+    m_warmedChoice = name;
+    m_lastWarmUpTime = now;
+
+    const auto& warmUp = it->second.warmUp;
+    if (!warmUp) {
+        return false;
+    }
+    warmUp();
+
+    if (changed) {
+        PrintFixed(FMT_COMPILE("Warmed up autonomous mode '{}' in {} us\n"),
+                   m_warmedChoice,
+                   frc::RobotController::GetFPGATime() - now);
+    }
+    return true;
+}
+
 void AutonomousChooser::YieldToMain() {
-    m_awaitingAuton = false;
-    m_cond.notify_one();
-    m_cond.wait(m_autonLock, [&] { return m_awaitingAuton; });
+    if (m_executionMode == ExecutionMode::kFiber) {
+        m_autonFiber.Yield();
+        return;
+    }
+
+    HandOff(kMain);
+    AwaitHandOff(kMain);
 }
 
 void AutonomousChooser::Return() {
-    m_awaitingAuton = false;
-    m_cond.notify_one();
+    // The fiber returns to the main robot thread when its function does
+    if (m_executionMode == ExecutionMode::kFiber) {
+        return;
+    }
+
+    HandOff(kMain);
 }
 
 void AutonomousChooser::AwaitStartAutonomous() {
-    {
-        std::scoped_lock lock{m_mutex};
-        fmt::print("{} autonomous\n", m_selectedChoice);
-        m_selectedAuton = &m_choices[m_selectedChoice];
+    // Finish the previous autonomous mode if it's still running
+    EndAutonomous();
+
+    auto selected = m_selectedChoice.Load();
+    EventLog::GetInstance().LogText(Event::kAutonomousStart, selected.View());
+    m_selectedAuton = &m_choices[selected.View()];
+
+    // Sequences run their first step now like the functions below do
+    if (m_selectedAuton->isSequence) {
+        m_selectedAuton->sequence.Start();
+        m_selectedAuton->sequence.Update();
+        return;
     }
 
-    m_awaitingAuton = true;
-    m_autonThread = std::thread{[=] {
-        m_autonLock.lock();
-        m_autonRunning = true;
-        (*m_selectedAuton)();
-        m_autonRunning = false;
-        Return();
-        m_autonLock.unlock();
-    }};
-    m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+    if (m_executionMode == ExecutionMode::kFiber) {
+        m_autonFiber.Start(m_selectedAuton->func);
+        return;
+    }
+
+    m_autonRunning = true;
+    HandOff(kAuton);
+    AwaitHandOff(kAuton);
 }
 
 void AutonomousChooser::AwaitRunAutonomous() {
+    if (m_selectedAuton->isSequence) {
+        m_selectedAuton->sequence.Update();
+        return;
+    }
+
+    if (m_executionMode == ExecutionMode::kFiber) {
+        if (m_autonFiber.IsRunning()) {
+            m_autonFiber.Resume();
+        }
+        return;
+    }
+
     if (m_autonRunning) {
-        m_awaitingAuton = true;
-        m_cond.notify_one();
-        m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+        HandOff(kAuton);
+        AwaitHandOff(kAuton);
     }
 }
 
 void AutonomousChooser::EndAutonomous() {
-    if (m_autonRunning) {
-        m_awaitingAuton = true;
-        m_cond.notify_one();
-        m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+    if (m_selectedAuton->isSequence) {
+        m_selectedAuton->sequence.Cancel();
+        return;
     }
-    if (m_autonThread.joinable()) {
-        m_autonThread.join();
+
+    // The autonomous mode should notice it's no longer enabled and return
+    if (m_executionMode == ExecutionMode::kFiber) {
+        while (m_autonFiber.IsRunning()) {
+            m_autonFiber.Resume();
+        }
+    } else {
+        while (m_autonRunning) {
+            HandOff(kAuton);
+            AwaitHandOff(kAuton);
+        }
+    }
+}
+
+bool AutonomousChooser::IsAutonomousRunning() const {
+    if (m_selectedAuton->isSequence) {
+        return m_selectedAuton->sequence.IsRunning();
     }
+
+    if (m_executionMode == ExecutionMode::kFiber) {
+        return m_autonFiber.IsRunning();
+    } else {
+        return m_autonRunning;
+    }
+}
+
+bool AutonomousChooser::SetThreadPriority(bool realTime, int priority) {
+    if (!m_autonThread.joinable()) {
+        return false;
+    }
+
+    return frc::SetThreadPriority(m_autonThread, realTime, priority);
+}
+
+bool AutonomousChooser::SetThreadAffinity(int cpu) {
+#ifdef __linux__
+    if (!m_autonThread.joinable()) {
+        return false;
+    }
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return pthread_setaffinity_np(m_autonThread.native_handle(),
+                                  sizeof(cpuset), &cpuset) == 0;
+#else
+    return false;
+#endif
+}
+
+void AutonomousChooser::HandOff(uint32_t turn) {
+    if (turn == kAuton) {
+        m_handOffTime.store(frc::RobotController::GetFPGATime(),
+                            std::memory_order_relaxed);
+    }
+    m_turn.store(turn, std::memory_order_release);
+    FutexWakeOne(m_turn);
+}
+
+void AutonomousChooser::AwaitHandOff(uint32_t turn) {
+    while (m_turn.load(std::memory_order_acquire) == turn) {
+        FutexWait(m_turn, turn);
+    }
+
+    // Only the worker waits for the main thread
+    if (turn == kMain && m_turn.load(std::memory_order_relaxed) == kAuton) {
+        ThreadPolicy::GetInstance().RecordLatency(
+            ThreadRole::kAutonomous,
+            frc::RobotController::GetFPGATime() -
+                m_handOffTime.load(std::memory_order_relaxed));
+    }
+}
+
+void AutonomousChooser::RunWorker() {
+    ThreadPolicy::Apply(ThreadRole::kAutonomous);
+
+    while (true) {
+        AwaitHandOff(kMain);
+        if (m_turn.load(std::memory_order_acquire) == kExit) {
+            return;
+        }
+
+        m_selectedAuton->func();
+        m_autonRunning = false;
+        Return();
+    }
+}
+
+void AutonomousChooser::PublishActive() {
+    auto selected = m_selectedChoice.Load();
+    if (selected.View() != m_publishedActive) {
+        m_publishedActive = selected.View();
+        m_activeEntry.SetString(m_publishedActive);
+    }
+}
+
+AutonomousChooser::Name::Name(std::string_view name)
+    : length{std::min(name.size(), kMaxNameLength)} {
+    std::copy_n(name.data(), length, chars.begin());
+}
+
+std::string_view AutonomousChooser::Name::View() const {
+    return {chars.data(), length};
 }
 
 void AutonomousChooser::InitSendable(frc::SendableBuilder& builder) {
@@ -127,6 +325,7 @@ void AutonomousChooser::InitSendable(frc::SendableBuilder& builder) {
 
     m_activeEntry = builder.GetEntry("active");
     m_activeEntry.SetString(m_defaultChoice);
+    m_publishedActive = m_defaultChoice;
 }
 
 }  // namespace frc3512
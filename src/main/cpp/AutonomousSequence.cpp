@@ -0,0 +1,208 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AutonomousSequence.hpp"
+
+#include <frc2/Timer.h>
+
+namespace frc3512 {
+
+using Command = AutonomousSequence::Command;
+
+Command AutonomousSequence::Instant(std::function<void()> action) {
+    Command command;
+    command.m_type = Command::Type::kInstant;
+    command.m_action = std::move(action);
+    return command;
+}
+
+Command AutonomousSequence::Run(std::function<void()> execute,
+                                std::function<void()> end) {
+    Command command;
+    command.m_type = Command::Type::kRun;
+    command.m_action = std::move(execute);
+    command.m_end = std::move(end);
+    return command;
+}
+
+Command AutonomousSequence::WaitUntil(std::function<bool()> condition,
+                                      std::function<void()> end) {
+    Command command;
+    command.m_type = Command::Type::kWaitUntil;
+    command.m_condition = std::move(condition);
+    command.m_end = std::move(end);
+    return command;
+}
+
+Command AutonomousSequence::Wait(units::second_t duration) {
+    return Wait([=] { return duration; });
+}
+
+Command AutonomousSequence::Wait(std::function<units::second_t()> duration) {
+    Command command;
+    command.m_type = Command::Type::kWait;
+    command.m_duration = std::move(duration);
+    return command;
+}
+
+AutonomousSequence::AutonomousSequence(Command command) {
+    // The nodes are allocated once at their final size since the arena
+    // doesn't reuse memory from a reallocation
+    m_nodes.reserve(CountNodes(command));
+    m_nodes.resize(1);
+    Flatten(command, 0);
+}
+
+void AutonomousSequence::Start() {
+    Cancel();
+
+    for (auto& node : m_nodes) {
+        node.status = Status::kIdle;
+    }
+    m_running = !m_nodes.empty();
+}
+
+bool AutonomousSequence::Update() {
+    if (!m_running) {
+        return true;
+    }
+
+    m_now = frc2::Timer::GetFPGATimestamp();
+    if (Step(0)) {
+        m_running = false;
+    }
+
+    return !m_running;
+}
+
+void AutonomousSequence::Cancel() {
+    if (m_running) {
+        Interrupt(0);
+        m_running = false;
+    }
+}
+
+bool AutonomousSequence::IsRunning() const { return m_running; }
+
+size_t AutonomousSequence::CountNodes(const Command& command) {
+    size_t count = 1;
+    for (const auto& child : command.m_children) {
+        count += CountNodes(child);
+    }
+    return count;
+}
+
+void AutonomousSequence::Flatten(Command& command, size_t index) {
+    size_t firstChild = m_nodes.size();
+    size_t numChildren = command.m_children.size();
+
+    // Reserve the children's slots before descending so they're contiguous
+    m_nodes.resize(firstChild + numChildren);
+
+    auto& node = m_nodes[index];
+    node.type = command.m_type;
+    node.firstChild = firstChild;
+    node.numChildren = numChildren;
+    node.action = std::move(command.m_action);
+    node.end = std::move(command.m_end);
+    node.condition = std::move(command.m_condition);
+    node.durationSource = std::move(command.m_duration);
+
+    for (size_t i = 0; i < numChildren; ++i) {
+        Flatten(command.m_children[i], firstChild + i);
+    }
+}
+
+bool AutonomousSequence::Step(size_t index) {
+    auto& node = m_nodes[index];
+    if (node.status == Status::kFinished) {
+        return true;
+    }
+
+    if (node.status == Status::kIdle) {
+        node.status = Status::kRunning;
+        node.startTime = m_now;
+        node.current = 0;
+        if (node.durationSource) {
+            node.duration = node.durationSource();
+        }
+    }
+
+    size_t first = node.firstChild;
+    size_t last = first + node.numChildren;
+    bool finished = false;
+
+    switch (node.type) {
+        case Command::Type::kInstant:
+            node.action();
+            finished = true;
+            break;
+        case Command::Type::kRun:
+            node.action();
+            break;
+        case Command::Type::kWaitUntil:
+            finished = node.condition();
+            break;
+        case Command::Type::kWait:
+            finished = m_now - node.startTime >= node.duration;
+            break;
+        case Command::Type::kSequential:
+            while (first + node.current < last &&
+                   Step(first + node.current)) {
+                ++node.current;
+            }
+            finished = first + node.current == last;
+            break;
+        case Command::Type::kParallel:
+            finished = true;
+            for (size_t child = first; child < last; ++child) {
+                finished &= Step(child);
+            }
+            break;
+        case Command::Type::kRace:
+            for (size_t child = first; child < last; ++child) {
+                finished |= Step(child);
+            }
+            break;
+        case Command::Type::kDeadline:
+            for (size_t child = first; child < last; ++child) {
+                bool childFinished = Step(child);
+                if (child == first) {
+                    finished = childFinished;
+                }
+            }
+            break;
+    }
+
+    if (finished) {
+        // Stop the children that are still running in a race or deadline
+        for (size_t child = first; child < last; ++child) {
+            Interrupt(child);
+        }
+
+        node.status = Status::kFinished;
+        if (node.end) {
+            node.end();
+        }
+    }
+
+    return finished;
+}
+
+void AutonomousSequence::Interrupt(size_t index) {
+    auto& node = m_nodes[index];
+    if (node.status != Status::kRunning) {
+        return;
+    }
+
+    size_t first = node.firstChild;
+    for (size_t child = first; child < first + node.numChildren; ++child) {
+        Interrupt(child);
+    }
+
+    node.status = Status::kFinished;
+    if (node.end) {
+        node.end();
+    }
+}
+
+}  // namespace frc3512
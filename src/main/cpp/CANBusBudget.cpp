@@ -0,0 +1,156 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "CANBusBudget.hpp"
+
+#include <stdint.h>
+
+#include <iterator>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "FixedFormat.hpp"
+
+using ctre::phoenix::motorcontrol::StatusFrameEnhanced;
+
+namespace {
+
+struct FrameInfo {
+    StatusFrameEnhanced frame;
+    const char* name;
+    units::millisecond_t defaultPeriod;
+};
+
+// The status frames broadcast by a Talon SRX and their default periods
+constexpr FrameInfo kFrameInfo[] = {
+    {StatusFrameEnhanced::Status_1_General, "General", 10_ms},
+    {StatusFrameEnhanced::Status_2_Feedback0, "Feedback0", 20_ms},
+    {StatusFrameEnhanced::Status_3_Quadrature, "Quadrature", 160_ms},
+    {StatusFrameEnhanced::Status_4_AinTempVbat, "AinTempVbat", 160_ms},
+    {StatusFrameEnhanced::Status_8_PulseWidth, "PulseWidth", 160_ms},
+    {StatusFrameEnhanced::Status_10_MotionMagic, "MotionMagic", 160_ms},
+    {StatusFrameEnhanced::Status_12_Feedback1, "Feedback1", 250_ms},
+    {StatusFrameEnhanced::Status_13_Base_PIDF0, "PIDF0", 160_ms},
+    {StatusFrameEnhanced::Status_14_Turn_PIDF1, "PIDF1", 250_ms}};
+
+}  // namespace
+
+CANBusBudget& CANBusBudget::GetInstance() {
+    static CANBusBudget instance;
+    return instance;
+}
+
+void CANBusBudget::SetStatusFramePeriod(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+    StatusFrameEnhanced frame, units::millisecond_t period) {
+    if (period > kMaxFramePeriod) {
+        period = kMaxFramePeriod;
+    }
+
+    motor.SetStatusFramePeriod(frame,
+                               static_cast<uint8_t>(period.to<double>()), 0);
+    GetFrame(motor, frame).period = period;
+}
+
+void CANBusBudget::RequireStatusFrame(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+    StatusFrameEnhanced frame, units::millisecond_t period) {
+    auto& entry = GetFrame(motor, frame);
+    if (entry.required && entry.period <= period) {
+        return;
+    }
+
+    entry.required = true;
+    SetStatusFramePeriod(motor, frame, period);
+}
+
+void CANBusBudget::SlowUnrequiredFrames(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor) {
+    for (auto& entry : GetDevice(motor).frames) {
+        if (!entry.required) {
+            SetStatusFramePeriod(motor, entry.frame, kMaxFramePeriod);
+        }
+    }
+}
+
+double CANBusBudget::GetEstimatedUtilization() const {
+    double bitsPerSecond = 0.0;
+    for (const auto& device : m_devices) {
+        if (device.deviceID != -1) {
+            bitsPerSecond += GetBitsPerSecond(device);
+        }
+    }
+
+    return bitsPerSecond / kBitRate;
+}
+
+void CANBusBudget::Report() const {
+    for (const auto& device : m_devices) {
+        if (device.deviceID == -1) {
+            continue;
+        }
+
+        frc3512::PrintFixed(FMT_COMPILE("CAN Talon {:>2}:"), device.deviceID);
+        for (size_t i = 0; i < kNumFrames; ++i) {
+            frc3512::PrintFixed(FMT_COMPILE(" {}={}ms"), kFrameInfo[i].name,
+                                device.frames[i].period.to<double>());
+        }
+        frc3512::PrintFixed(FMT_COMPILE(" ({:.1f}% of bus)\n"),
+                            GetBitsPerSecond(device) / kBitRate * 100.0);
+    }
+
+    frc3512::PrintFixed(
+        FMT_COMPILE("CAN estimated bus utilization: {:.1f}%\n"),
+        GetEstimatedUtilization() * 100.0);
+}
+
+CANBusBudget::Frame& CANBusBudget::GetFrame(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+    StatusFrameEnhanced frame) {
+    for (auto& entry : GetDevice(motor).frames) {
+        if (entry.frame == frame) {
+            return entry;
+        }
+    }
+
+    throw std::invalid_argument{"CANBusBudget: untracked status frame"};
+}
+
+CANBusBudget::Device& CANBusBudget::GetDevice(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor) {
+    static_assert(std::size(kFrameInfo) == kNumFrames,
+                  "kNumFrames must match the number of status frames");
+
+    int deviceID = motor.GetDeviceID();
+
+    for (auto& device : m_devices) {
+        if (device.deviceID == deviceID) {
+            return device;
+        }
+    }
+
+    for (auto& device : m_devices) {
+        if (device.deviceID == -1) {
+            device.deviceID = deviceID;
+            for (size_t i = 0; i < kNumFrames; ++i) {
+                device.frames[i] = {kFrameInfo[i].frame,
+                                    kFrameInfo[i].defaultPeriod};
+            }
+            return device;
+        }
+    }
+
+    throw std::length_error{"CANBusBudget: too many Talons registered"};
+}
+
+double CANBusBudget::GetBitsPerSecond(const Device& device) {
+    double framesPerSecond = 1.0 / kControlFramePeriod.to<double>();
+    for (const auto& entry : device.frames) {
+        framesPerSecond += 1.0 / entry.period.to<double>();
+    }
+
+    // The periods are in milliseconds
+    framesPerSecond *= 1000.0;
+
+    return framesPerSecond * kBitsPerFrame;
+}
@@ -1,9 +1,26 @@
-// Copyright (c) 2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2020-2021 FRC Team 3512. All Rights Reserved.
 
 #include "CANDigitalInput.hpp"
 
+#include <ctre/phoenix/motorcontrol/StatusFrame.h>
+
+#include "CANBusBudget.hpp"
+#include "Constants.hpp"
+
 CANDigitalInput::CANDigitalInput(
     ctre::phoenix::motorcontrol::can::TalonSRX& motor)
-    : m_motor(motor) {}
+    : m_motor(motor),
+      m_sensors(CANSensorSnapshot::GetInstance().Register(motor)) {
+    // The limit switch states are in Status_1. Send it once per controller
+    // tick so controllers see switch edges promptly.
+    CANBusBudget::GetInstance().RequireStatusFrame(
+        motor,
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_1_General,
+        frc3512::Constants::kControllerPeriod);
+}
+
+CANDigitalInput::~CANDigitalInput() {
+    CANSensorSnapshot::GetInstance().Unregister(m_motor);
+}
 
-bool CANDigitalInput::Get() { return m_sensor.IsRevLimitSwitchClosed(); }
+bool CANDigitalInput::Get() const { return m_sensors.isRevLimitSwitchClosed; }
@@ -3,25 +3,67 @@
 #include "CANEncoder.hpp"
 
 #include <ctre/phoenix/motorcontrol/FeedbackDevice.h>
+#include <ctre/phoenix/motorcontrol/StatusFrame.h>
+
+#include "CANBusBudget.hpp"
+#include "Constants.hpp"
 
 CANEncoder::CANEncoder(ctre::phoenix::motorcontrol::can::TalonSRX& motor,
                        double distancePerPulse, bool reverseDirection)
-    : m_motor{motor}, m_distancePerPulse{distancePerPulse} {
+    : m_motor{motor},
+      m_sensors{CANSensorSnapshot::GetInstance().Register(motor)},
+      m_distancePerPulse{distancePerPulse},
+      m_sensorSign{reverseDirection ? -1.0 : 1.0} {
     motor.ConfigSelectedFeedbackSensor(
         ctre::phoenix::motorcontrol::FeedbackDevice::QuadEncoder, 0, 0);
     motor.SetSensorPhase(reverseDirection);
+
+    // The quadrature position and velocity are in Status_3, which defaults to
+    // 160 ms. Send it once per controller tick so every snapshot is fresh.
+    CANBusBudget::GetInstance().RequireStatusFrame(
+        motor,
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_3_Quadrature,
+        frc3512::Constants::kControllerPeriod);
+}
+
+CANEncoder::~CANEncoder() {
+    CANSensorSnapshot::GetInstance().Unregister(m_motor);
 }
 
-double CANEncoder::GetDistance() {
-    return m_motor.GetSensorCollection().GetQuadraturePosition() *
-           m_distancePerPulse;
+double CANEncoder::GetDistance() const {
+    return (m_sensors.quadraturePosition - m_offset) * m_distancePerPulse;
+}
+
+double CANEncoder::GetDistance(units::second_t time) const {
+    return GetDistance() + GetRate() * (time - GetTimestamp()).to<double>();
+}
+
+double CANEncoder::GetRate() const {
+    // The Talon reports velocity in pulses per 100 ms
+    return m_sensors.quadratureVelocity * m_distancePerPulse * 10.0;
+}
+
+units::second_t CANEncoder::GetTimestamp() const {
+    // The frame is required at the controller period, so the reading is at
+    // most that old if it's still the latest one
+    units::second_t changed = units::microsecond_t{
+        static_cast<double>(m_sensors.quadratureTimestamp)};
+    units::second_t resent =
+        units::microsecond_t{static_cast<double>(m_sensors.snapshotTimestamp)} -
+        frc3512::Constants::kControllerPeriod;
+    return changed > resent ? changed : resent;
+}
+
+void CANEncoder::Reset() { m_offset = m_sensors.quadraturePosition; }
+
+double CANEncoder::ToSensorPosition(double distance) const {
+    return m_sensorSign * (distance / m_distancePerPulse + m_offset);
 }
 
-double CANEncoder::GetRate() {
-    return m_motor.GetSensorCollection().GetQuadratureVelocity() *
-           m_distancePerPulse;
+double CANEncoder::ToSensorDistance(double distance) const {
+    return m_sensorSign * distance / m_distancePerPulse;
 }
 
-void CANEncoder::Reset() {
-    m_motor.GetSensorCollection().SetQuadraturePosition(0);
+double CANEncoder::ToSensorVelocity(double rate) const {
+    return m_sensorSign * rate / m_distancePerPulse / 10.0;
 }
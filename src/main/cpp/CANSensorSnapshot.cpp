@@ -0,0 +1,132 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "CANSensorSnapshot.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <frc/RobotController.h>
+
+CANSensorSnapshot& CANSensorSnapshot::GetInstance() {
+    static CANSensorSnapshot instance;
+    return instance;
+}
+
+TalonSRXSensorData& CANSensorSnapshot::Register(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor) {
+    for (size_t i = 0; i < kMaxDevices; ++i) {
+        if (m_devices[i].motor == &motor) {
+            ++m_devices[i].refCount;
+            return m_data[i];
+        }
+    }
+
+    for (size_t i = 0; i < kMaxDevices; ++i) {
+        if (m_devices[i].motor == nullptr) {
+            m_devices[i] = {&motor, 1};
+            m_data[i] = {};
+            return m_data[i];
+        }
+    }
+
+    throw std::length_error{"CANSensorSnapshot: too many Talons registered"};
+}
+
+void CANSensorSnapshot::Unregister(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor) {
+    for (auto& device : m_devices) {
+        if (device.motor == &motor) {
+            if (--device.refCount == 0) {
+                device.motor = nullptr;
+            }
+            return;
+        }
+    }
+}
+
+void CANSensorSnapshot::Update() {
+    uint64_t now = frc::RobotController::GetFPGATime();
+    // Readings that changed arrived sometime since the last update
+    uint64_t arrivalTime = now;
+    if (m_lastUpdateTime != 0) {
+        arrivalTime = m_lastUpdateTime + (now - m_lastUpdateTime) / 2;
+    }
+    m_lastUpdateTime = now;
+
+    for (size_t i = 0; i < kMaxDevices; ++i) {
+        if (m_devices[i].motor == nullptr) {
+            continue;
+        }
+
+        Reading reading;
+        if (m_source) {
+            reading = m_source(m_devices[i].motor->GetDeviceID());
+        } else {
+            auto& sensors = m_devices[i].motor->GetSensorCollection();
+            reading.quadraturePosition = sensors.GetQuadraturePosition();
+            reading.quadratureVelocity = sensors.GetQuadratureVelocity();
+            reading.isFwdLimitSwitchClosed = sensors.IsFwdLimitSwitchClosed();
+            reading.isRevLimitSwitchClosed = sensors.IsRevLimitSwitchClosed();
+        }
+
+        auto& data = m_data[i];
+        if (reading.quadraturePosition != data.quadraturePosition ||
+            reading.quadratureVelocity != data.quadratureVelocity ||
+            data.quadratureTimestamp == 0) {
+            data.quadraturePosition = reading.quadraturePosition;
+            data.quadratureVelocity = reading.quadratureVelocity;
+            data.quadratureTimestamp = arrivalTime;
+        }
+        data.snapshotTimestamp = now;
+
+        data.isFwdLimitSwitchClosed = reading.isFwdLimitSwitchClosed;
+        data.isRevLimitSwitchClosed = reading.isRevLimitSwitchClosed;
+    }
+
+    if (m_recorder) {
+        // Encoder counts stay exact in a float up to 2^24
+        std::array<float, kMaxDevices * 3> values;
+        for (size_t i = 0; i < m_numRecordedDevices; ++i) {
+            const auto& data = m_data[m_recordedDevices[i]];
+            values[i * 3] = static_cast<float>(data.quadraturePosition);
+            values[i * 3 + 1] = static_cast<float>(data.quadratureVelocity);
+            values[i * 3 + 2] = static_cast<float>(
+                (data.isFwdLimitSwitchClosed ? 1 : 0) |
+                (data.isRevLimitSwitchClosed ? 2 : 0));
+        }
+        m_recorder->Record(values.data(), m_numRecordedDevices * 3);
+    }
+}
+
+void CANSensorSnapshot::SetReadingSource(ReadingSource source) {
+    m_source = std::move(source);
+}
+
+void CANSensorSnapshot::StartRecording() {
+    std::vector<std::string> signals;
+    m_numRecordedDevices = 0;
+    for (size_t i = 0; i < kMaxDevices; ++i) {
+        if (m_devices[i].motor == nullptr) {
+            continue;
+        }
+
+        int id = m_devices[i].motor->GetDeviceID();
+        signals.emplace_back(fmt::format("talon{} position", id));
+        signals.emplace_back(fmt::format("talon{} velocity", id));
+        signals.emplace_back(fmt::format("talon{} limit switches", id));
+        m_recordedDevices[m_numRecordedDevices] = i;
+        ++m_numRecordedDevices;
+    }
+
+    m_recorder = std::make_unique<frc3512::SignalRecorder>(
+        "cansensors", std::move(signals));
+}
+
+void CANSensorSnapshot::FlushRecording(std::string_view directory) {
+    if (m_recorder) {
+        m_recorder->Flush(directory);
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "CoalescedTalonOutput.hpp"
+
+#include <cmath>
+
+#include <frc/RobotController.h>
+
+std::atomic<uint64_t> CoalescedTalonOutput::s_totalWrites{0};
+std::atomic<uint64_t> CoalescedTalonOutput::s_totalSuppressed{0};
+
+CoalescedTalonOutput::CoalescedTalonOutput(
+    ctre::phoenix::motorcontrol::can::TalonSRX& motor, double deadband,
+    units::millisecond_t keepAlive)
+    : m_motor{&motor},
+      m_deadband{deadband},
+      m_keepAlive{static_cast<uint64_t>(
+          units::microsecond_t{keepAlive}.to<double>())},
+      m_lastMode{ctre::phoenix::motorcontrol::ControlMode::PercentOutput},
+      m_lastDemandType{ctre::phoenix::motorcontrol::DemandType::Neutral} {}
+
+bool CoalescedTalonOutput::Set(ctre::phoenix::motorcontrol::ControlMode mode,
+                               double value) {
+    return Set(mode, value, ctre::phoenix::motorcontrol::DemandType::Neutral,
+               0.0);
+}
+
+bool CoalescedTalonOutput::Set(
+    ctre::phoenix::motorcontrol::ControlMode mode, double value,
+    ctre::phoenix::motorcontrol::DemandType demandType, double demandValue) {
+    uint64_t now = frc::RobotController::GetFPGATime();
+
+    if (m_hasLastCommand && mode == m_lastMode &&
+        std::abs(value - m_lastValue) <= m_deadband &&
+        demandType == m_lastDemandType &&
+        std::abs(demandValue - m_lastDemandValue) <= m_deadband &&
+        now - m_lastWriteTime < m_keepAlive) {
+        ++m_suppressed;
+        s_totalSuppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (demandType == ctre::phoenix::motorcontrol::DemandType::Neutral) {
+        m_motor->Set(mode, value);
+    } else {
+        m_motor->Set(mode, value, demandType, demandValue);
+    }
+
+    m_lastMode = mode;
+    m_lastValue = value;
+    m_lastDemandType = demandType;
+    m_lastDemandValue = demandValue;
+    m_hasLastCommand = true;
+    m_lastWriteTime = now;
+    ++m_writes;
+    s_totalWrites.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void CoalescedTalonOutput::Invalidate() { m_hasLastCommand = false; }
+
+uint64_t CoalescedTalonOutput::GetWriteCount() const { return m_writes; }
+
+uint64_t CoalescedTalonOutput::GetSuppressedCount() const {
+    return m_suppressed;
+}
+
+uint64_t CoalescedTalonOutput::GetTotalWriteCount() {
+    return s_totalWrites.load(std::memory_order_relaxed);
+}
+
+uint64_t CoalescedTalonOutput::GetTotalSuppressedCount() {
+    return s_totalSuppressed.load(std::memory_order_relaxed);
+}
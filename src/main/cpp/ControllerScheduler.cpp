@@ -0,0 +1,47 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "ControllerScheduler.hpp"
+
+#include <mutex>
+#include <utility>
+
+#include "CANSensorSnapshot.hpp"
+
+namespace frc3512 {
+
+ControllerScheduler::ControllerScheduler(units::second_t period)
+    : m_period{period}, m_wakeups{ThreadRole::kControllers, period} {}
+
+void ControllerScheduler::AddController(std::function<void()> controller) {
+    std::scoped_lock lock{m_mutex};
+    m_controllers.emplace_back(std::move(controller));
+}
+
+void ControllerScheduler::Start() { m_notifier.StartPeriodic(m_period); }
+
+void ControllerScheduler::Stop() { m_notifier.Stop(); }
+
+units::second_t ControllerScheduler::GetPeriod() const { return m_period; }
+
+wpi::mutex& ControllerScheduler::GetMutex() { return m_mutex; }
+
+void ControllerScheduler::Tick() {
+    m_wakeups.Record();
+
+    // The notifier thread is created lazily, so its policy can only be set
+    // from within it
+    if (!m_appliedPolicy) {
+        ThreadPolicy::Apply(ThreadRole::kControllers);
+        m_appliedPolicy = true;
+    }
+
+    std::scoped_lock lock{m_mutex};
+
+    CANSensorSnapshot::GetInstance().Update();
+
+    for (auto& controller : m_controllers) {
+        controller();
+    }
+}
+
+}  // namespace frc3512
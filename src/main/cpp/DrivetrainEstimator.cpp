@@ -0,0 +1,216 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "DrivetrainEstimator.hpp"
+
+#include <algorithm>
+
+#include <Eigen/Cholesky>
+#include <frc/system/Discretization.h>
+
+using namespace frc3512;
+
+namespace {
+
+// Continuous process noise of the distances in m/sqrt(s) and the velocities in
+// m/s/sqrt(s). The velocity noise covers wheel slip and pushing.
+constexpr double kDistanceProcessStdDev = 0.05;
+constexpr double kVelocityProcessStdDev = 1.0;
+
+// Measurement noise of the encoders in m and the gyro in rad/s
+constexpr double kDistanceMeasurementStdDev = 0.002;
+constexpr double kGyroMeasurementStdDev = 0.02;
+
+// Initial uncertainty of the velocities after a reset in m/s
+constexpr double kInitialVelocityStdDev = 0.1;
+
+template <int Rows>
+void Correct(Eigen::Matrix<double, 4, 1>& x, Eigen::Matrix<double, 4, 4>& P,
+             const Eigen::Matrix<double, Rows, 4>& C,
+             const Eigen::Matrix<double, Rows, 1>& y,
+             const Eigen::Matrix<double, Rows, Rows>& R) {
+    Eigen::Matrix<double, Rows, Rows> S = C * P * C.transpose() + R;
+
+    // K = P Cᵀ S⁻¹, solved as Sᵀ Kᵀ = C Pᵀ
+    Eigen::Matrix<double, 4, Rows> K =
+        S.transpose().ldlt().solve(C * P.transpose()).transpose();
+
+    x += K * (y - C * x);
+    P = (Eigen::Matrix<double, 4, 4>::Identity() - K * C) * P;
+}
+
+}  // namespace
+
+DrivetrainEstimator::DrivetrainEstimator(
+    const frc::LinearSystem<2, 2, 2>& plant, units::meter_t trackWidth)
+    : m_trackWidth{trackWidth.to<double>()} {
+    m_contA.setZero();
+    m_contA.block<2, 2>(0, 2) = Eigen::Matrix2d::Identity();
+    m_contA.block<2, 2>(2, 2) = plant.A();
+
+    m_contB.setZero();
+    m_contB.block<2, 2>(2, 0) = plant.B();
+
+    Reset(0_s, 0_m, 0_m);
+}
+
+void DrivetrainEstimator::Reset(units::second_t timestamp,
+                                units::meter_t leftDistance,
+                                units::meter_t rightDistance) {
+    Entry entry;
+    entry.timestamp = timestamp.to<double>();
+    entry.x << leftDistance.to<double>(), rightDistance.to<double>(), 0.0,
+        0.0;
+    entry.P.diagonal() << kDistanceMeasurementStdDev *
+                              kDistanceMeasurementStdDev,
+        kDistanceMeasurementStdDev * kDistanceMeasurementStdDev,
+        kInitialVelocityStdDev * kInitialVelocityStdDev,
+        kInitialVelocityStdDev * kInitialVelocityStdDev;
+
+    m_history[0] = entry;
+    m_newest = 0;
+    m_size = 1;
+    m_lastEncoderTimestamp = entry.timestamp;
+}
+
+void DrivetrainEstimator::Update(units::second_t timestamp,
+                                 units::volt_t leftVoltage,
+                                 units::volt_t rightVoltage,
+                                 units::radians_per_second_t angularVelocity) {
+    Update(timestamp, leftVoltage, rightVoltage);
+
+    auto& entry = At(0);
+    entry.angularVelocity = angularVelocity.to<double>();
+    entry.hasAngularVelocity = true;
+    CorrectGyro(entry.x, entry.P, entry.angularVelocity);
+}
+
+void DrivetrainEstimator::Update(units::second_t timestamp,
+                                 units::volt_t leftVoltage,
+                                 units::volt_t rightVoltage) {
+    Entry entry = At(0);
+    entry.u << leftVoltage.to<double>(), rightVoltage.to<double>();
+    entry.angularVelocity = 0.0;
+    entry.hasAngularVelocity = false;
+
+    Predict(entry.x, entry.P, entry.u,
+            timestamp.to<double>() - entry.timestamp);
+    entry.timestamp = timestamp.to<double>();
+
+    m_newest = (m_newest + 1) % kHistorySize;
+    m_history[m_newest] = entry;
+    m_size = std::min(m_size + 1, kHistorySize);
+}
+
+void DrivetrainEstimator::CorrectEncoders(units::second_t timestamp,
+                                          units::meter_t leftDistance,
+                                          units::meter_t rightDistance) {
+    double time = timestamp.to<double>();
+    if (time <= m_lastEncoderTimestamp) {
+        return;
+    }
+    m_lastEncoderTimestamp = time;
+
+    // Find the newest state at or before the measurement
+    size_t age = 0;
+    while (age + 1 < m_size && At(age).timestamp > time) {
+        ++age;
+    }
+    Entry& base = At(age);
+    time = std::clamp(time, base.timestamp, At(0).timestamp);
+
+    StateVector x = base.x;
+    StateMatrix P = base.P;
+    if (age > 0) {
+        Predict(x, P, At(age - 1).u, time - base.timestamp);
+    }
+    CorrectDistances(x, P, leftDistance.to<double>(),
+                     rightDistance.to<double>());
+
+    if (age == 0) {
+        base.x = x;
+        base.P = P;
+        return;
+    }
+
+    // Replay the updates since the measurement
+    for (size_t i = age; i-- > 0;) {
+        Entry& entry = At(i);
+        Predict(x, P, entry.u, entry.timestamp - time);
+        if (entry.hasAngularVelocity) {
+            CorrectGyro(x, P, entry.angularVelocity);
+        }
+        entry.x = x;
+        entry.P = P;
+        time = entry.timestamp;
+    }
+}
+
+DrivetrainEstimator::Estimate DrivetrainEstimator::GetEstimate() const {
+    const auto& entry = At(0);
+
+    Estimate estimate;
+    estimate.timestamp = units::second_t{entry.timestamp};
+    estimate.leftDistance = units::meter_t{entry.x(0)};
+    estimate.rightDistance = units::meter_t{entry.x(1)};
+    estimate.leftVelocity = units::meters_per_second_t{entry.x(2)};
+    estimate.rightVelocity = units::meters_per_second_t{entry.x(3)};
+    estimate.angularVelocity =
+        units::radians_per_second_t{(entry.x(3) - entry.x(2)) / m_trackWidth};
+    return estimate;
+}
+
+DrivetrainEstimator::Entry& DrivetrainEstimator::At(size_t age) {
+    return m_history[(m_newest + kHistorySize - age) % kHistorySize];
+}
+
+const DrivetrainEstimator::Entry& DrivetrainEstimator::At(size_t age) const {
+    return m_history[(m_newest + kHistorySize - age) % kHistorySize];
+}
+
+void DrivetrainEstimator::Predict(StateVector& x, StateMatrix& P,
+                                  const InputVector& u, double dt) const {
+    if (dt <= 0.0) {
+        return;
+    }
+
+    StateMatrix discA;
+    Eigen::Matrix<double, 4, 2> discB;
+    frc::DiscretizeAB<4, 2>(m_contA, m_contB, units::second_t{dt}, &discA,
+                            &discB);
+
+    // Over a few milliseconds, the discrete process noise is close to the
+    // continuous one times the period
+    StateVector q;
+    q << kDistanceProcessStdDev * kDistanceProcessStdDev,
+        kDistanceProcessStdDev * kDistanceProcessStdDev,
+        kVelocityProcessStdDev * kVelocityProcessStdDev,
+        kVelocityProcessStdDev * kVelocityProcessStdDev;
+
+    x = discA * x + discB * u;
+    P = discA * P * discA.transpose();
+    P.diagonal() += q * dt;
+}
+
+void DrivetrainEstimator::CorrectGyro(StateVector& x, StateMatrix& P,
+                                      double angularVelocity) const {
+    // The yaw rate is the difference between the wheel velocities over the
+    // track width
+    Eigen::Matrix<double, 1, 4> C;
+    C << 0.0, 0.0, -1.0 / m_trackWidth, 1.0 / m_trackWidth;
+    Eigen::Matrix<double, 1, 1> y{angularVelocity};
+    Eigen::Matrix<double, 1, 1> R{kGyroMeasurementStdDev *
+                                  kGyroMeasurementStdDev};
+    Correct<1>(x, P, C, y, R);
+}
+
+void DrivetrainEstimator::CorrectDistances(StateVector& x, StateMatrix& P,
+                                           double leftDistance,
+                                           double rightDistance) const {
+    Eigen::Matrix<double, 2, 4> C;
+    C << 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0;
+    Eigen::Matrix<double, 2, 1> y{leftDistance, rightDistance};
+    Eigen::Matrix<double, 2, 2> R = Eigen::Matrix2d::Identity() *
+                                    kDistanceMeasurementStdDev *
+                                    kDistanceMeasurementStdDev;
+    Correct<2>(x, P, C, y, R);
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "EventLog.hpp"
+
+#include <sys/stat.h>
+
+#include <array>
+#include <chrono>
+#include <ctime>
+
+#include <fmt/format.h>
+
+#include "FixedFormat.hpp"
+#include "ThreadPolicy.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// Indexed by Event
+constexpr std::array<const char*, static_cast<size_t>(Event::kNumEvents)>
+    kFormats = {
+        "{} autonomous",                                   // kAutonomousStart
+        "Seeking to {} m",                                 // kElevatorSeek
+        "Drive limited at {:.2f} V, predicted {:.2f} V"   // kDriveLimited
+};
+
+constexpr char kMagic[8] = {'F', '3', '5', '1', '2', 'E', 'V', 'T'};
+
+// How long the writer sleeps between draining the queue
+constexpr auto kWriterPeriod = std::chrono::milliseconds{20};
+
+/**
+ * The start of a log file. The event table follows it, then the records
+ * start at recordsOffset. All fields are little-endian.
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t recordsOffset;
+    uint32_t numEvents;
+};
+
+void Print(const EventRecord& record) {
+    if (record.event >= kFormats.size()) {
+        PrintFixed(FMT_COMPILE("[{:.6f}] unknown event {}\n"),
+                   record.timestamp / 1e6, record.event);
+        return;
+    }
+
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    if (record.textLength > 0) {
+        store.push_back(std::string_view{record.text, record.textLength});
+    }
+    for (size_t i = 0; i < record.numArgs; ++i) {
+        store.push_back(record.args[i]);
+    }
+
+    try {
+        PrintFixed(FMT_COMPILE("[{:.6f}] {}\n"), record.timestamp / 1e6,
+                   fmt::vformat(kFormats[record.event], store));
+    } catch (const fmt::format_error& e) {
+        PrintFixed(FMT_COMPILE("[{:.6f}] bad format for event {}: {}\n"),
+                   record.timestamp / 1e6, record.event, e.what());
+    }
+}
+
+}  // namespace
+
+EventLog& EventLog::GetInstance() {
+    static EventLog instance;
+    return instance;
+}
+
+EventLog::~EventLog() { Stop(); }
+
+bool EventLog::Start(std::string_view directory) {
+    if (m_running) {
+        return m_file != nullptr;
+    }
+
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S",
+                  std::localtime(&now));
+    std::string filename =
+        fmt::format("{}/events-{}.bin", directory, timestamp);
+
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (m_file != nullptr) {
+        WriteHeader();
+    } else {
+        PrintFixed(stderr, FMT_COMPILE("EventLog: couldn't open {}\n"),
+                   filename);
+    }
+
+    m_running = true;
+    m_thread = std::thread{[=] { RunWriter(); }};
+
+    return m_file != nullptr;
+}
+
+void EventLog::Stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    m_thread.join();
+
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+uint64_t EventLog::GetDroppedCount() const {
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+const char* EventLog::GetFormat(Event event) {
+    return kFormats[static_cast<size_t>(event)];
+}
+
+std::string EventLog::GetDefaultDirectory() {
+#ifdef __FRC_ROBORIO__
+    struct stat info;
+    if (stat("/u", &info) == 0 && S_ISDIR(info.st_mode)) {
+        return "/u";
+    }
+    return "/home/lvuser";
+#else
+    return ".";
+#endif
+}
+
+void EventLog::WriteHeader() {
+    // Event table entries are a uint16_t length followed by the format string
+    std::string table;
+    for (const char* format : kFormats) {
+        auto length = static_cast<uint16_t>(std::strlen(format));
+        table.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        table.append(format, length);
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recordSize = sizeof(EventRecord);
+    header.numEvents = kFormats.size();
+
+    // Records are aligned to their size so the file can be memory-mapped and
+    // indexed as an array
+    size_t headerSize = sizeof(header) + table.size();
+    header.recordsOffset = (headerSize + sizeof(EventRecord) - 1) /
+                           sizeof(EventRecord) * sizeof(EventRecord);
+    table.resize(header.recordsOffset - sizeof(header), '\0');
+
+    std::fwrite(&header, sizeof(header), 1, m_file);
+    std::fwrite(table.data(), 1, table.size(), m_file);
+    std::fflush(m_file);
+}
+
+void EventLog::Drain() {
+    EventRecord record;
+    bool wrote = false;
+
+    while (m_queue.Pop(record)) {
+        if (m_file != nullptr) {
+            std::fwrite(&record, sizeof(record), 1, m_file);
+            wrote = true;
+        }
+        Print(record);
+    }
+
+    if (wrote) {
+        std::fflush(m_file);
+    }
+}
+
+void EventLog::RunWriter() {
+    ThreadPolicy::Apply(ThreadRole::kLogging);
+
+    while (m_running) {
+        Drain();
+        std::this_thread::sleep_for(kWriterPeriod);
+    }
+
+    // Write anything logged before Stop()
+    Drain();
+}
+
+}  // namespace frc3512
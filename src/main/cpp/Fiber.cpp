@@ -0,0 +1,135 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+// macOS only exposes the ucontext routines if _XOPEN_SOURCE is defined
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600
+#endif
+
+#include "Fiber.hpp"
+
+#include <stdint.h>
+
+#include <cassert>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+// winbase.h defines Yield() as an empty macro for Win16 compatibility
+#undef Yield
+#else
+#include <ucontext.h>
+#endif
+
+#ifdef __APPLE__
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+namespace frc3512 {
+
+#ifdef _WIN32
+
+struct Fiber::Context {
+    LPVOID caller = nullptr;
+    LPVOID fiber = nullptr;
+
+    static void CALLBACK Entry(LPVOID param) {
+        static_cast<Fiber*>(param)->Run();
+    }
+};
+
+#else
+
+struct Fiber::Context {
+    ucontext_t caller;
+    ucontext_t fiber;
+    std::unique_ptr<char[]> stack;
+
+    // makecontext() only passes int arguments, so the Fiber pointer is split
+    // into two 32-bit halves
+    static void Entry(int hi, int lo) {
+        uint64_t ptr =
+            (static_cast<uint64_t>(static_cast<uint32_t>(hi)) << 32) |
+            static_cast<uint32_t>(lo);
+        reinterpret_cast<Fiber*>(static_cast<uintptr_t>(ptr))->Run();
+    }
+};
+
+#endif
+
+Fiber::Fiber(size_t stackSize) : m_context{std::make_unique<Context>()} {
+#ifdef _WIN32
+    m_context->fiber = CreateFiber(stackSize, Context::Entry, this);
+#else
+    m_context->stack = std::make_unique<char[]>(stackSize);
+
+    getcontext(&m_context->fiber);
+    m_context->fiber.uc_stack.ss_sp = m_context->stack.get();
+    m_context->fiber.uc_stack.ss_size = stackSize;
+    m_context->fiber.uc_link = nullptr;
+
+    auto ptr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this));
+    makecontext(&m_context->fiber,
+                reinterpret_cast<void (*)()>(Context::Entry), 2,
+                static_cast<int>(ptr >> 32), static_cast<int>(ptr));
+#endif
+}
+
+Fiber::~Fiber() {
+#ifdef _WIN32
+    DeleteFiber(m_context->fiber);
+#endif
+}
+
+void Fiber::Start(std::function<void()> func) {
+    assert(!m_running);
+
+    m_func = std::move(func);
+    m_running = true;
+    Resume();
+}
+
+void Fiber::Resume() {
+#ifdef _WIN32
+    if (!IsThreadAFiber()) {
+        ConvertThreadToFiber(nullptr);
+    }
+    m_context->caller = GetCurrentFiber();
+    SwitchToFiber(m_context->fiber);
+#else
+    swapcontext(&m_context->caller, &m_context->fiber);
+#endif
+
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void Fiber::Yield() {
+#ifdef _WIN32
+    SwitchToFiber(m_context->caller);
+#else
+    swapcontext(&m_context->fiber, &m_context->caller);
+#endif
+}
+
+bool Fiber::IsRunning() const { return m_running; }
+
+void Fiber::Run() {
+    // The fiber's entry point never returns. Once a function finishes, the
+    // fiber parks here until the next call to Start().
+    while (true) {
+        try {
+            m_func();
+        } catch (...) {
+            m_exception = std::current_exception();
+        }
+        m_func = nullptr;
+        m_running = false;
+
+        Yield();
+    }
+}
+
+}  // namespace frc3512
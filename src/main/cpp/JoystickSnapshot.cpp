@@ -0,0 +1,26 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "JoystickSnapshot.hpp"
+
+#include <frc/DriverStation.h>
+#include <frc/Joystick.h>
+#include <frc/RobotController.h>
+
+namespace frc3512 {
+
+JoystickSnapshot::JoystickSnapshot(int port) : m_port{port} {}
+
+void JoystickSnapshot::Update() {
+    auto& ds = frc::DriverStation::GetInstance();
+    m_timestamp = frc::RobotController::GetFPGATime();
+
+    uint32_t buttons = static_cast<uint32_t>(ds.GetStickButtons(m_port));
+    m_pressed = buttons & ~m_buttons;
+    m_buttons = buttons;
+
+    m_pov = ds.GetStickPOV(m_port, 0);
+    m_x = ds.GetStickAxis(m_port, frc::Joystick::kDefaultXChannel);
+    m_y = ds.GetStickAxis(m_port, frc::Joystick::kDefaultYChannel);
+}
+
+}  // namespace frc3512
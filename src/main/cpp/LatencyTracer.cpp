@@ -0,0 +1,61 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "LatencyTracer.hpp"
+
+#include <frc/RobotController.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// The names of the outputs' sections, in Output order
+constexpr std::array<const char*, LatencyTracer::kNumOutputs> kOutputNames{
+    {"Lift goal", "Lift", "Tines", "Intake arms", "Intake stow",
+     "Container grabber"}};
+
+// The input time of each thread's innermost scope
+thread_local uint64_t t_inputTime = 0;
+
+}  // namespace
+
+LatencyTracer::Scope::Scope(uint64_t inputTime) : m_previous{t_inputTime} {
+    t_inputTime = inputTime;
+}
+
+LatencyTracer::Scope::~Scope() { t_inputTime = m_previous; }
+
+LatencyTracer& LatencyTracer::GetInstance() {
+    static LatencyTracer instance;
+    return instance;
+}
+
+uint64_t LatencyTracer::GetCurrentInputTime() { return t_inputTime; }
+
+void LatencyTracer::Record(Output output, uint64_t inputTime) {
+    if (inputTime == 0) {
+        return;
+    }
+
+    uint64_t now = frc::RobotController::GetFPGATime();
+    m_sections[static_cast<size_t>(output)]->Record(
+        now > inputTime ? now - inputTime : 0);
+}
+
+LoopProfiler& LatencyTracer::GetProfiler() { return m_latencies; }
+
+void LatencyTracer::Report() const {
+    PrintFixed(FMT_COMPILE("Input-to-output latency:\n"));
+    m_latencies.Print();
+}
+
+void LatencyTracer::Reset() { m_latencies.Reset(); }
+
+LatencyTracer::LatencyTracer() {
+    for (size_t i = 0; i < kNumOutputs; ++i) {
+        m_sections[i] = &m_latencies.AddSection(kOutputNames[i]);
+    }
+}
+
+}  // namespace frc3512
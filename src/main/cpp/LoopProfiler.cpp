@@ -0,0 +1,153 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "LoopProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+units::second_t FromMicroseconds(uint64_t us) {
+    return units::microsecond_t{static_cast<double>(us)};
+}
+
+double ToMicroseconds(units::second_t time) {
+    return units::microsecond_t{time}.to<double>();
+}
+
+}  // namespace
+
+const std::string& LoopProfiler::Section::GetName() const { return m_name; }
+
+uint32_t LoopProfiler::Section::GetCount() const {
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint32_t LoopProfiler::Section::GetOverruns() const {
+    return m_overruns.load(std::memory_order_relaxed);
+}
+
+units::second_t LoopProfiler::Section::GetMin() const {
+    if (GetCount() == 0) {
+        return 0_s;
+    }
+
+    return FromMicroseconds(m_min.load(std::memory_order_relaxed));
+}
+
+units::second_t LoopProfiler::Section::GetMax() const {
+    return FromMicroseconds(m_max.load(std::memory_order_relaxed));
+}
+
+units::second_t LoopProfiler::Section::GetPercentile(double percentile) const {
+    // The buckets are summed instead of using m_count so a concurrent Record()
+    // can't make the target unreachable
+    uint64_t total = 0;
+    for (const auto& bucket : m_buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0_s;
+    }
+
+    auto target = static_cast<uint64_t>(std::ceil(percentile * total));
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t count = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        count += m_buckets[i].load(std::memory_order_relaxed);
+        if (count >= target) {
+            // The bucket may extend past the longest run
+            return std::min(FromMicroseconds(BucketUpperBound(i)), GetMax());
+        }
+    }
+
+    return GetMax();
+}
+
+void LoopProfiler::Section::Reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_overruns.store(0, std::memory_order_relaxed);
+    m_min.store(UINT32_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+LoopProfiler::Section& LoopProfiler::AddSection(std::string_view name,
+                                                units::second_t budget) {
+    if (m_numSections == kMaxSections) {
+        throw std::length_error{"LoopProfiler: too many sections"};
+    }
+
+    auto& section = m_sections[m_numSections];
+    section.m_name = name;
+    section.m_budget = static_cast<uint32_t>(ToMicroseconds(budget));
+    ++m_numSections;
+
+    return section;
+}
+
+void LoopProfiler::Print() const {
+    PrintFixed(FMT_COMPILE("{:<24} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}\n"),
+               "Section", "Count", "Min(us)", "p50(us)", "p99(us)", "Max(us)",
+               "Overruns");
+    for (size_t i = 0; i < m_numSections; ++i) {
+        const auto& section = m_sections[i];
+        if (section.GetCount() == 0) {
+            continue;
+        }
+
+        PrintFixed(FMT_COMPILE("{:<24} {:>8} {:>8.0f} {:>8.0f} {:>8.0f} "
+                               "{:>8.0f} {:>8}\n"),
+                   section.GetName(), section.GetCount(),
+                   ToMicroseconds(section.GetMin()),
+                   ToMicroseconds(section.GetPercentile(0.5)),
+                   ToMicroseconds(section.GetPercentile(0.99)),
+                   ToMicroseconds(section.GetMax()), section.GetOverruns());
+    }
+}
+
+void LoopProfiler::Reset() {
+    for (size_t i = 0; i < m_numSections; ++i) {
+        m_sections[i].Reset();
+    }
+}
+
+void LoopProfiler::InitSendable(frc::SendableBuilder& builder) {
+    for (size_t i = 0; i < m_numSections; ++i) {
+        const auto& name = m_sections[i].GetName();
+
+        builder.AddDoubleProperty(
+            name + "/Count", [=] { return m_sections[i].GetCount(); }, nullptr);
+        builder.AddDoubleProperty(
+            name + "/Min (us)",
+            [=] { return ToMicroseconds(m_sections[i].GetMin()); }, nullptr);
+        builder.AddDoubleProperty(
+            name + "/p50 (us)",
+            [=] { return ToMicroseconds(m_sections[i].GetPercentile(0.5)); },
+            nullptr);
+        builder.AddDoubleProperty(
+            name + "/p99 (us)",
+            [=] { return ToMicroseconds(m_sections[i].GetPercentile(0.99)); },
+            nullptr);
+        builder.AddDoubleProperty(
+            name + "/Max (us)",
+            [=] { return ToMicroseconds(m_sections[i].GetMax()); }, nullptr);
+        builder.AddDoubleProperty(
+            name + "/Overruns", [=] { return m_sections[i].GetOverruns(); },
+            nullptr);
+    }
+}
+
+}  // namespace frc3512
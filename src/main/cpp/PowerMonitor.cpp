@@ -0,0 +1,69 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "PowerMonitor.hpp"
+
+#include <algorithm>
+
+#include <frc/RobotController.h>
+
+#include "EventLog.hpp"
+
+PowerMonitor& PowerMonitor::GetInstance() {
+    static PowerMonitor instance;
+    return instance;
+}
+
+void PowerMonitor::Update() {
+    uint64_t now = frc::RobotController::GetFPGATime();
+    double voltage = frc::RobotController::GetBatteryVoltage().to<double>();
+    double current = m_pdp.GetTotalCurrent();
+
+    double dt = 0.0;
+    if (m_lastTimestamp != 0 && now > m_lastTimestamp) {
+        dt = (now - m_lastTimestamp) / 1e6;
+        double slope =
+            (voltage - m_voltage.load(std::memory_order_relaxed)) / dt;
+        m_slope += dt / (kSlopeTimeConstant.to<double>() + dt) *
+                   (slope - m_slope);
+    }
+    m_lastTimestamp = now;
+
+    // Only sag is extrapolated. A recovering voltage is taken as it is.
+    double predicted =
+        voltage + std::min(m_slope, 0.0) * kLookahead.to<double>();
+
+    double fraction = std::clamp(
+        (predicted - kLimitFullVoltage.to<double>()) /
+            (kLimitStartVoltage - kLimitFullVoltage).to<double>(),
+        0.0, 1.0);
+    double target = kMinDriveScale + (1.0 - kMinDriveScale) * fraction;
+    double scale = std::min(
+        target, m_driveScale.load(std::memory_order_relaxed) +
+                    kRecoveryRate * dt);
+
+    bool limited = scale < 1.0;
+    if (limited && !m_limited) {
+        frc3512::EventLog::GetInstance().Log(frc3512::Event::kDriveLimited,
+                                             voltage, predicted);
+    }
+    m_limited = limited;
+
+    m_voltage.store(voltage, std::memory_order_relaxed);
+    m_current.store(current, std::memory_order_relaxed);
+    m_predictedVoltage.store(predicted, std::memory_order_relaxed);
+    m_driveScale.store(scale, std::memory_order_relaxed);
+
+    m_telemetry.Set(kVoltage, voltage);
+    m_telemetry.Set(kCurrent, current);
+    m_telemetry.Set(kPredictedVoltage, predicted);
+    m_telemetry.Set(kDriveScale, scale);
+    m_telemetry.Commit();
+}
+
+units::ampere_t PowerMonitor::GetTotalCurrent() const {
+    return units::ampere_t{m_current.load(std::memory_order_relaxed)};
+}
+
+units::volt_t PowerMonitor::GetPredictedVoltage() const {
+    return units::volt_t{m_predictedVoltage.load(std::memory_order_relaxed)};
+}
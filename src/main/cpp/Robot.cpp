@@ -2,95 +2,376 @@
 
 #include "Robot.hpp"
 
-Robot::Robot() {
-    autonChooser.AddAutonomous("DriveForward", [=] { AutoDriveForward(); });
-    autonChooser.AddAutonomous("ResetElevator", [=] { AutoResetElevator(); });
-    autonChooser.AddAutonomous("OneCanLeft", [=] { AutoOneCanLeft(); });
-    autonChooser.AddAutonomous("OneCanCenter", [=] { AutoOneCanCenter(); });
-    autonChooser.AddAutonomous("OneCanRight", [=] { AutoOneCanRight(); });
-    autonChooser.AddAutonomous("OneTote", [=] { AutoOneTote(); });
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <frc/smartdashboard/SmartDashboard.h>
+
+#include "Arena.hpp"
+#include "CANBusBudget.hpp"
+#include "CANSensorSnapshot.hpp"
+#include "CoalescedTalonOutput.hpp"
+#include "EventLog.hpp"
+#include "FixedFormat.hpp"
+#include "LatencyTracer.hpp"
+#include "PowerMonitor.hpp"
+#include "StartupProfiler.hpp"
+#include "TelemetryPublisher.hpp"
+#include "Tunables.hpp"
+
+namespace {
+
+std::vector<std::string> GetTeleopSignals() {
+    std::vector<std::string> signals;
+    for (auto signal : Robot::kTeleopInputSignals) {
+        signals.emplace_back(signal);
+    }
+    for (auto signal : Robot::kTeleopOutputSignals) {
+        signals.emplace_back(signal);
+    }
+    return signals;
 }
 
-void Robot::TeleopPeriodic() {
-    drivetrain.Drive(driveStick1.GetY(), driveStick2.GetX(),
-                     driveStick2.GetRawButton(2));
+/**
+ * An elevator action run when a button is pressed.
+ */
+struct ButtonBinding {
+    int button;
+
+    // pipelinedStacking is the dashboard's "Pipelined stacking" setting
+    void (*onPress)(Elevator& elevator, bool pipelinedStacking);
+};
 
+// Appendage stick buttons. When several are pressed in the same loop, their
+// actions run in this order.
+constexpr std::array<ButtonBinding, 12> kAppendageBindings{{
     // Open/close tines
-    if (appendageStick.GetRawButtonPressed(1)) {
-        elevator.ElevatorGrab(!elevator.IsElevatorGrabbed());
-    }
+    {1, [](Elevator& e, bool) { e.ElevatorGrab(!e.IsElevatorGrabbed()); }},
 
     // Open/close intake
-    if (appendageStick.GetRawButtonPressed(2)) {
-        elevator.IntakeGrab(!elevator.IsIntakeGrabbed());
-    }
+    {2, [](Elevator& e, bool) { e.IntakeGrab(!e.IsIntakeGrabbed()); }},
 
     // Start auto-stacking mode
-    if (appendageStick.GetRawButtonPressed(3)) {
-        elevator.StackTotes();
-    }
+    {3,
+     [](Elevator& e, bool pipelinedStacking) {
+         e.SetPipelinedStacking(pipelinedStacking);
+         e.StackTotes();
+     }},
 
     // Manual height control
-    if (appendageStick.GetRawButtonPressed(4)) {
-        elevator.SetManualMode(!elevator.IsManualMode());
-    }
+    {4, [](Elevator& e, bool) { e.SetManualMode(!e.IsManualMode()); }},
 
     // Stow intake
-    if (appendageStick.GetRawButtonPressed(5)) {
-        elevator.StowIntake(!elevator.IsIntakeStowed());
-    }
+    {5, [](Elevator& e, bool) { e.StowIntake(!e.IsIntakeStowed()); }},
 
     // Open/close container grabber
-    if (appendageStick.GetRawButtonPressed(6)) {
-        elevator.ContainerGrab(!elevator.IsContainerGrabbed());
-    }
+    {6, [](Elevator& e, bool) { e.ContainerGrab(!e.IsContainerGrabbed()); }},
 
     // Automatic preset buttons (7-12)
-    if (appendageStick.GetRawButtonPressed(8)) {
-        elevator.RaiseElevator(Elevator::kGroundHeight);
-    }
-    if (appendageStick.GetRawButtonPressed(7)) {
-        elevator.RaiseElevator(Elevator::kToteHeight1);
-    }
-    if (appendageStick.GetRawButtonPressed(10)) {
-        elevator.RaiseElevator(Elevator::kToteHeight2);
-    }
-    if (appendageStick.GetRawButtonPressed(9)) {
-        elevator.RaiseElevator(Elevator::kToteHeight3);
-    }
-    if (appendageStick.GetRawButtonPressed(12)) {
-        elevator.RaiseElevator(Elevator::kToteHeight4);
+    {8, [](Elevator& e, bool) { e.RaiseElevator(Elevator::kGroundHeight); }},
+    {7, [](Elevator& e, bool) { e.RaiseElevator(e.toteHeight1.Get()); }},
+    {10, [](Elevator& e, bool) { e.RaiseElevator(e.toteHeight2.Get()); }},
+    {9, [](Elevator& e, bool) { e.RaiseElevator(e.toteHeight3.Get()); }},
+    {12, [](Elevator& e, bool) { e.RaiseElevator(e.toteHeight4.Get()); }},
+    {11, [](Elevator& e, bool) { e.RaiseElevator(e.toteHeight5.Get()); }},
+}};
+
+constexpr uint32_t GetBindingMask() {
+    uint32_t mask = 0;
+    for (const auto& binding : kAppendageBindings) {
+        mask |= frc3512::JoystickSnapshot::ButtonMask(binding.button);
     }
-    if (appendageStick.GetRawButtonPressed(11)) {
-        elevator.RaiseElevator(Elevator::kToteHeight5);
+    return mask;
+}
+
+// The buttons with actions, for skipping the table when none were pressed
+constexpr uint32_t kAppendageMask = GetBindingMask();
+
+}  // namespace
+
+Robot::Robot()
+    : teleopRecorder{"teleop", GetTeleopSignals(), kTeleopRecorderCapacity} {
+    frc3512::EventLog::GetInstance().Start();
+    frc3512::TelemetryPublisher::GetInstance().Start();
+
+    // Trajectories are loaded first since the sequences look them up
+    AddTrajectories(trajectories);
+    trajectories.Load();
+    frc3512::StartupProfiler::GetInstance().Record("Trajectories");
+
+    // The warm-ups run while the mode is selected before the match
+    using Seq = frc3512::AutonomousSequence;
+    auto warmUpElevator = [=] { elevator.WarmUp(); };
+    autonChooser.AddAutonomous("DriveForward", Seq{AutoDriveForward()});
+    autonChooser.AddAutonomous("ResetElevator", Seq{AutoResetElevator()},
+                               warmUpElevator);
+    autonChooser.AddAutonomous("OneCanLeft", Seq{AutoOneCanLeft()},
+                               warmUpElevator);
+    autonChooser.AddAutonomous("OneCanCenter", Seq{AutoOneCanCenter()},
+                               warmUpElevator);
+    autonChooser.AddAutonomous("OneCanRight", Seq{AutoOneCanRight()},
+                               warmUpElevator);
+    autonChooser.AddAutonomous("OneTote", Seq{AutoOneTote()}, warmUpElevator);
+    autonChooser.AddAutonomous(
+        "DriveForwardTrajectory", Seq{AutoDriveForwardTrajectory()},
+        [=] { drivetrain.WarmUp(trajectories.Get("DriveForward")); });
+
+    controllerScheduler.AddController([=] {
+        frc3512::AllocationTracker::Scope allocations{controllerAllocations};
+        frc3512::LoopProfiler::ScopedTimer timer{elevatorControllerSection};
+        elevator.UpdateController();
+    });
+    controllerScheduler.AddController([=] {
+        frc3512::AllocationTracker::Scope allocations{controllerAllocations};
+        frc3512::LoopProfiler::ScopedTimer timer{drivetrainControllerSection};
+        drivetrain.UpdateControllers();
+    });
+
+    frc::SmartDashboard::PutData("Loop profiler", &loopProfiler);
+    frc::SmartDashboard::PutData(
+        "Thread latency",
+        &frc3512::ThreadPolicy::GetInstance().GetLatencyProfiler());
+    frc::SmartDashboard::PutData(
+        "Input latency",
+        &frc3512::LatencyTracer::GetInstance().GetProfiler());
+    frc::SmartDashboard::SetDefaultBoolean("Pipelined stacking", false);
+    pipelinedStackingEntry =
+        frc::SmartDashboard::GetEntry("Pipelined stacking");
+    pipelinedStackingListener = pipelinedStackingEntry.AddListener(
+        [=](const nt::EntryNotification& event) {
+            if (event.value->IsBoolean()) {
+                pipelinedStacking.store(event.value->GetBoolean(),
+                                        std::memory_order_relaxed);
+            }
+        },
+        NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
+            NT_NOTIFY_LOCAL);
+
+    // All subsystems have configured their status frames and registered their
+    // Talons by now
+    CANBusBudget::GetInstance().Report();
+    CANSensorSnapshot::GetInstance().StartRecording();
+
+    // Every Tunable has been registered by the subsystems now
+    frc3512::Tunables::GetInstance().ReportUnknownNames();
+
+    auto& startupProfiler = frc3512::StartupProfiler::GetInstance();
+    startupProfiler.Record("Rest of Robot()");
+    startupProfiler.Report();
+
+    auto& arena = frc3512::Arena::GetInstance();
+    frc3512::PrintFixed(
+        FMT_COMPILE("Arena: {} bytes used, {} allocations didn't fit\n"),
+        arena.GetUsed(), arena.GetOverflowCount());
+}
+
+Robot::~Robot() {
+    pipelinedStackingEntry.RemoveListener(pipelinedStackingListener);
+}
+
+void Robot::RobotInit() {
+    // StartCompetition() calls this on the thread that runs the robot loop
+    frc3512::ThreadPolicy::RetainHeap();
+    frc3512::ThreadPolicy::Apply(frc3512::ThreadRole::kMainLoop);
+
+    // The autonomous sequences, their commands and frc2::Timer first run in
+    // the match and can't be dry-run without moving the robot, so the code
+    // they're in is kept in RAM instead of being faulted in from flash then
+    frc3512::ThreadPolicy::LockObject("");
+    frc3512::ThreadPolicy::LockObject("libwpilibc.so");
+    frc3512::ThreadPolicy::LockObject("libwpiHal.so");
+}
+
+void Robot::DisabledInit() {
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+
+    // The profiles would keep advancing while the motors are disabled
+    controllerScheduler.Stop();
+
+    autonChooser.EndAutonomous();
+
+    // Picks up changes to tunables.txt made since the last enable
+    frc3512::Tunables::GetInstance().Load();
+
+    auto directory = frc3512::EventLog::GetDefaultDirectory();
+    teleopRecorder.Flush(directory);
+    drivetrain.FlushSignals(directory);
+    elevator.FlushSignals(directory);
+    CANSensorSnapshot::GetInstance().FlushRecording(directory);
+
+    frc3512::PrintFixed(
+        FMT_COMPILE("CAN motor writes: {} sent, {} suppressed\n"),
+        CoalescedTalonOutput::GetTotalWriteCount(),
+        CoalescedTalonOutput::GetTotalSuppressedCount());
+
+    // Each mode's loop timings are reported separately
+    loopProfiler.Print();
+    loopProfiler.Reset();
+
+    auto& allocationTracker = frc3512::AllocationTracker::GetInstance();
+    allocationTracker.Report();
+    allocationTracker.Reset();
+
+    frc3512::ThreadPolicy::GetInstance().Report();
+
+    auto& latencyTracer = frc3512::LatencyTracer::GetInstance();
+    latencyTracer.Report();
+    latencyTracer.Reset();
+}
+
+void Robot::DisabledPeriodic() {
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+
+    autonChooser.WarmUpSelected();
+}
+
+void Robot::TeleopInit() {
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+
+    autonChooser.EndAutonomous();
+    drivetrain.StopTrajectory();
+    drivetrain.SetControllersEnabled(false);
+    controllerScheduler.Start();
+}
+
+void Robot::TeleopPeriodic() {
+    mainLoopWakeups.Record();
+
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+    frc3512::AllocationTracker::Scope allocations{teleopAllocations};
+    frc3512::LoopProfiler::ScopedTimer timer{teleopSection};
+
+    CANSensorSnapshot::GetInstance().Update();
+    PowerMonitor::GetInstance().Update();
+
+    driveStick1.Update();
+    driveStick2.Update();
+    appendageStick.Update();
+
+    std::array<float, kTeleopInputSignals.size() + kTeleopOutputSignals.size()>
+        sample;
+    sample[0] = driveStick1.GetY();
+    sample[1] = driveStick2.GetX();
+    sample[2] = driveStick2.GetButtons();
+    sample[3] = driveStick2.GetPOV();
+    sample[4] = appendageStick.GetY();
+    sample[5] = appendageStick.GetButtons();
+    sample[6] = appendageStick.GetPOV();
+    sample[8] = PowerMonitor::GetInstance().GetBatteryVoltage().to<double>();
+
+    drivetrain.Drive(driveStick1.GetY(), driveStick2.GetX(),
+                     driveStick2.GetButton(2));
+
+    uint32_t pressed = appendageStick.GetPressedButtons() & kAppendageMask;
+    if (pressed != 0) {
+        // The outputs the actions write, now or through the elevator's queue,
+        // are traced back to when the press was read
+        frc3512::LatencyTracer::Scope trace{appendageStick.GetTimestamp()};
+        bool pipelined = pipelinedStacking.load(std::memory_order_relaxed);
+        for (const auto& binding : kAppendageBindings) {
+            if ((pressed & frc3512::JoystickSnapshot::ButtonMask(
+                               binding.button)) != 0) {
+                binding.onPress(elevator, pipelined);
+            }
+        }
     }
 
     // Set manual value
     elevator.SetManualLiftSpeed(appendageStick.GetY() * 12_V);
 
     // Controls intake
-    if (driveStick2.GetPOV() == 0 || appendageStick.GetPOV() == 0) {
+    int drivePOV = driveStick2.GetPOV();
+    int appendagePOV = appendageStick.GetPOV();
+    if (drivePOV == 0 || appendagePOV == 0) {
         elevator.SetIntakeDirection(Elevator::S_FORWARD);
-    } else if (driveStick2.GetPOV() == 90 || appendageStick.GetPOV() == 90) {
+    } else if (drivePOV == 90 || appendagePOV == 90) {
         elevator.SetIntakeDirection(Elevator::S_ROTATE_CCW);
-    } else if (driveStick2.GetPOV() == 180 || appendageStick.GetPOV() == 180 ||
-               driveStick2.GetRawButton(1)) {
+    } else if (drivePOV == 180 || appendagePOV == 180 ||
+               driveStick2.GetButton(1)) {
         elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    } else if (driveStick2.GetPOV() == 270 || appendageStick.GetPOV() == 270) {
+    } else if (drivePOV == 270 || appendagePOV == 270) {
         elevator.SetIntakeDirection(Elevator::S_ROTATE_CW);
     } else {
         elevator.SetIntakeDirection(Elevator::S_STOPPED);
     }
 
-    elevator.UpdateState();
+    {
+        frc3512::LoopProfiler::ScopedTimer elevatorTimer{elevatorStateSection};
+        elevator.UpdateState();
+    }
+
+    // The dashboard setting is only read when stacking starts, so the value
+    // it left in the elevator is recorded instead
+    sample[7] = elevator.IsPipelinedStacking();
+    auto outputs = GetTeleopOutputs();
+    std::copy(outputs.begin(), outputs.end(),
+              sample.begin() + kTeleopInputSignals.size());
+    teleopRecorder.Record(sample.data(), sample.size());
 }
 
-void Robot::AutonomousInit() { drivetrain.ResetEncoders(); }
+void Robot::AutonomousInit() {
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+
+    CANSensorSnapshot::GetInstance().Update();
+
+    drivetrain.ResetEncoders();
+    controllerScheduler.Start();
+    autonChooser.AwaitStartAutonomous();
+}
 
 void Robot::AutonomousPeriodic() {
-    autonChooser.AwaitRunAutonomous();
+    mainLoopWakeups.Record();
+
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+    frc3512::AllocationTracker::Scope allocations{autonAllocations};
+    frc3512::LoopProfiler::ScopedTimer timer{autonSection};
+
+    CANSensorSnapshot::GetInstance().Update();
+    PowerMonitor::GetInstance().Update();
+
+    {
+        frc3512::LoopProfiler::ScopedTimer autonRunTimer{autonRunSection};
+        autonChooser.AwaitRunAutonomous();
+    }
+
+    {
+        frc3512::LoopProfiler::ScopedTimer elevatorTimer{elevatorStateSection};
+        elevator.UpdateState();
+    }
+}
+
+void Robot::SimulationPeriodic() {
+    std::scoped_lock lock{controllerScheduler.GetMutex()};
+
+    drivetrain.SimulationPeriodic(GetPeriod());
+    elevator.SimulationPeriodic(GetPeriod());
+}
+
+void Robot::SelectAutonomous(wpi::StringRef name) {
+    autonChooser.SelectAutonomous(name);
+}
+
+const std::vector<std::string>& Robot::GetAutonomousNames() const {
+    return autonChooser.GetAutonomousNames();
+}
+
+bool Robot::IsAutonomousRunning() const {
+    return autonChooser.IsAutonomousRunning();
+}
 
-    elevator.UpdateState();
+std::array<float, Robot::kTeleopOutputSignals.size()> Robot::GetTeleopOutputs()
+    const {
+    return {static_cast<float>(drivetrain.GetLeftOutput()),
+            static_cast<float>(drivetrain.GetRightOutput()),
+            static_cast<float>(elevator.GetGoal().to<double>()),
+            static_cast<float>(elevator.IsManualMode()),
+            static_cast<float>(elevator.IsStacking()),
+            static_cast<float>(elevator.IsElevatorGrabbed()),
+            static_cast<float>(elevator.IsIntakeGrabbed()),
+            static_cast<float>(elevator.IsIntakeStowed()),
+            static_cast<float>(elevator.IsContainerGrabbed())};
 }
 
 #ifndef RUNNING_FRC_TESTS
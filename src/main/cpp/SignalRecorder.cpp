@@ -0,0 +1,174 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "SignalRecorder.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include <fmt/format.h>
+#include <frc/RobotController.h>
+
+#include "FixedFormat.hpp"
+#include "ThreadPolicy.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// Longest file path Flush() can create
+constexpr size_t kMaxFilenameLength = 255;
+
+constexpr char kMagic[8] = {'F', '3', '5', '1', '2', 'S', 'I', 'G'};
+
+/**
+ * The start of a signal file. It's followed by the signal names, each a
+ * uint16_t length and the string, then the timestamp column as uint32_t
+ * microseconds, then one float column per signal. All fields are
+ * little-endian.
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numSignals;
+    uint32_t numSamples;
+    uint32_t reserved;
+    uint64_t startTime;
+};
+
+}  // namespace
+
+SignalRecorder::SignalRecorder(std::string_view name,
+                               std::initializer_list<std::string_view> signals,
+                               size_t capacity)
+    : SignalRecorder{name, std::vector<std::string>(signals.begin(),
+                                                    signals.end()),
+                     capacity} {}
+
+SignalRecorder::SignalRecorder(std::string_view name,
+                               std::vector<std::string> signals,
+                               size_t capacity)
+    : m_name{name}, m_signals{std::move(signals)}, m_capacity{capacity} {
+    for (auto& buffer : m_buffers) {
+        buffer.timestamps.resize(capacity);
+        buffer.columns.resize(m_signals.size());
+        for (auto& column : buffer.columns) {
+            column.resize(capacity);
+        }
+
+        // The controller thread records into the buffers
+        ThreadPolicy::LockRegion(buffer.timestamps.data(),
+                                 capacity * sizeof(uint32_t));
+        for (auto& column : buffer.columns) {
+            ThreadPolicy::LockRegion(column.data(), capacity * sizeof(float));
+        }
+    }
+}
+
+SignalRecorder::~SignalRecorder() {
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+void SignalRecorder::Record(std::initializer_list<float> values) {
+    Record(values.begin(), values.size());
+}
+
+void SignalRecorder::Record(const float* values, size_t count) {
+    assert(count == m_signals.size());
+
+    auto& buffer = m_buffers[m_active];
+    if (buffer.size == m_capacity) {
+        ++m_dropped;
+        return;
+    }
+
+    uint64_t now = frc::RobotController::GetFPGATime();
+    if (buffer.size == 0) {
+        buffer.startTime = now;
+    }
+    buffer.timestamps[buffer.size] =
+        static_cast<uint32_t>(now - buffer.startTime);
+
+    for (size_t signal = 0; signal < count; ++signal) {
+        buffer.columns[signal][buffer.size] = values[signal];
+    }
+
+    ++buffer.size;
+}
+
+bool SignalRecorder::Flush(std::string_view directory) {
+    if (m_buffers[m_active].size == 0 || m_writing) {
+        return false;
+    }
+
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S",
+                  std::localtime(&now));
+    auto filename = FormatFixed<kMaxFilenameLength>(
+        FMT_COMPILE("{}/{}-{}.sig"), directory, m_name, timestamp);
+    if (filename.IsTruncated()) {
+        PrintFixed(stderr, FMT_COMPILE("SignalRecorder: {} is too long\n"),
+                   filename.View());
+        return false;
+    }
+
+    auto& buffer = m_buffers[m_active];
+    m_active = 1 - m_active;
+
+    m_writing = true;
+    m_writer = std::thread{[=, &buffer] {
+        ThreadPolicy::Apply(ThreadRole::kLogging);
+        Write(buffer, filename.CStr());
+        m_writing = false;
+    }};
+
+    return true;
+}
+
+size_t SignalRecorder::GetSize() const { return m_buffers[m_active].size; }
+
+uint64_t SignalRecorder::GetDroppedCount() const { return m_dropped; }
+
+void SignalRecorder::Write(Buffer& buffer, const char* filename) {
+    std::FILE* file = std::fopen(filename, "wb");
+    if (file == nullptr) {
+        PrintFixed(stderr, FMT_COMPILE("SignalRecorder: couldn't open {}\n"),
+                   filename);
+        buffer.size = 0;
+        return;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.numSignals = m_signals.size();
+    header.numSamples = buffer.size;
+    header.reserved = 0;
+    header.startTime = buffer.startTime;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    for (const auto& signal : m_signals) {
+        auto length = static_cast<uint16_t>(signal.size());
+        std::fwrite(&length, sizeof(length), 1, file);
+        std::fwrite(signal.data(), 1, length, file);
+    }
+
+    std::fwrite(buffer.timestamps.data(), sizeof(uint32_t), buffer.size, file);
+    for (const auto& column : buffer.columns) {
+        std::fwrite(column.data(), sizeof(float), buffer.size, file);
+    }
+
+    std::fclose(file);
+    buffer.size = 0;
+}
+
+}  // namespace frc3512
@@ -0,0 +1,54 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "StartupProfiler.hpp"
+
+#include <fmt/format.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// Starts the clock during static initialization instead of at the first
+// checkpoint
+[[maybe_unused]] const StartupProfiler& kStartupProfiler =
+    StartupProfiler::GetInstance();
+
+double ToMilliseconds(StartupProfiler::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>{duration}.count();
+}
+
+}  // namespace
+
+StartupProfiler::Checkpoint::Checkpoint(std::string_view name) {
+    StartupProfiler::GetInstance().Record(name);
+}
+
+StartupProfiler& StartupProfiler::GetInstance() {
+    static StartupProfiler instance;
+    return instance;
+}
+
+StartupProfiler::StartupProfiler() : m_start{Clock::now()}, m_last{m_start} {}
+
+void StartupProfiler::Record(std::string_view name) {
+    auto now = Clock::now();
+    m_steps.push_back({std::string{name}, now - m_last});
+    m_last = now;
+}
+
+void StartupProfiler::Report() {
+    PrintFixed(FMT_COMPILE("Startup times:\n"));
+    for (const auto& step : m_steps) {
+        PrintFixed(FMT_COMPILE("  {:<32} {:>9.3f} ms\n"), step.name,
+                   ToMilliseconds(step.duration));
+    }
+    PrintFixed(FMT_COMPILE("  {:<32} {:>9.3f} ms\n"), "Total",
+               ToMilliseconds(m_last - m_start));
+
+    m_steps.clear();
+    m_start = m_last;
+}
+
+}  // namespace frc3512
@@ -2,11 +2,13 @@
 
 #include "TalonSRXGroup.hpp"
 
+#include "PowerMonitor.hpp"
+
 void TalonSRXGroup::Set(double speed) {
     using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput,
-                  m_isInverted ? -speed : speed);
+    m_output.Set(ControlMode::PercentOutput, m_isInverted ? -speed : speed);
     m_speed = speed;
+    m_inMotionMagic = false;
 }
 
 double TalonSRXGroup::Get() const { return m_isInverted ? -m_speed : m_speed; }
@@ -17,14 +19,85 @@ bool TalonSRXGroup::GetInverted() const { return m_isInverted; }
 
 void TalonSRXGroup::Disable() {
     using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput, 0.0);
+    m_output.Set(ControlMode::PercentOutput, 0.0);
     m_speed = 0.0;
+    m_inMotionMagic = false;
 }
 
 void TalonSRXGroup::StopMotor() {
     using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput, 0.0);
+    m_output.Set(ControlMode::PercentOutput, 0.0);
     m_speed = 0.0;
+    m_inMotionMagic = false;
 }
 
 void TalonSRXGroup::PIDWrite(double output) { Set(output); }
+
+void TalonSRXGroup::SetVoltage(units::volt_t output) {
+    if (m_voltageCompensated) {
+        Set(output / kNominalVoltage);
+    } else {
+        Set(output / PowerMonitor::GetInstance().GetBatteryVoltage());
+    }
+}
+
+void TalonSRXGroup::EnableVoltageCompensation() {
+    if (m_voltageCompensated) {
+        return;
+    }
+
+    m_leader->ConfigVoltageCompSaturation(kNominalVoltage.to<double>(), 0);
+    m_leader->EnableVoltageCompensation(true);
+    m_voltageCompensated = true;
+}
+
+void TalonSRXGroup::ConfigClosedLoop(const ClosedLoopGains& gains) {
+    // A timeout of zero doesn't wait for the Talon to acknowledge each setting
+    m_leader->SelectProfileSlot(0, 0);
+    m_leader->Config_kP(0, gains.kP, 0);
+    m_leader->Config_kI(0, gains.kI, 0);
+    m_leader->Config_kD(0, gains.kD, 0);
+    m_leader->Config_kF(0, gains.kF, 0);
+
+    EnableVoltageCompensation();
+}
+
+void TalonSRXGroup::ConfigMotionMagic(double cruiseVelocity,
+                                      double acceleration,
+                                      int sCurveStrength) {
+    m_leader->ConfigMotionCruiseVelocity(cruiseVelocity, 0);
+    m_leader->ConfigMotionAcceleration(acceleration, 0);
+    m_leader->ConfigMotionSCurveStrength(sCurveStrength, 0);
+}
+
+void TalonSRXGroup::SetMotionMagic(double position,
+                                   units::volt_t arbitraryFeedforward) {
+    using namespace ctre::phoenix::motorcontrol;
+    m_output.Set(ControlMode::MotionMagic, position,
+                 DemandType::ArbitraryFeedForward,
+                 arbitraryFeedforward / kNominalVoltage);
+    m_inMotionMagic = true;
+}
+
+units::volt_t TalonSRXGroup::GetVoltage() const {
+    if (m_inMotionMagic) {
+        units::volt_t voltage{m_leader->GetMotorOutputVoltage()};
+        return m_isInverted ? -voltage : voltage;
+    }
+
+    if (m_voltageCompensated) {
+        return m_speed * kNominalVoltage;
+    } else {
+        return m_speed * PowerMonitor::GetInstance().GetBatteryVoltage();
+    }
+}
+
+void TalonSRXGroup::RequireStatusFrame(
+    ctre::phoenix::motorcontrol::StatusFrameEnhanced frame,
+    units::millisecond_t period) {
+    CANBusBudget::GetInstance().RequireStatusFrame(*m_leader, frame, period);
+}
+
+const CoalescedTalonOutput& TalonSRXGroup::GetOutput() const {
+    return m_output;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "TelemetryPublisher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#include <networktables/NetworkTable.h>
+#include <networktables/NetworkTableInstance.h>
+
+#include "ThreadPolicy.hpp"
+
+namespace frc3512 {
+
+TelemetryPublisher& TelemetryPublisher::GetInstance() {
+    static TelemetryPublisher instance;
+    return instance;
+}
+
+TelemetryPublisher::~TelemetryPublisher() { Stop(); }
+
+void TelemetryPublisher::Start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+
+    m_thread = std::thread{[=] { RunPublisher(); }};
+}
+
+void TelemetryPublisher::Stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    m_thread.join();
+}
+
+TelemetryPublisher::Handle TelemetryPublisher::AddPublisher(
+    std::function<void()> publish) {
+    std::scoped_lock lock{m_mutex};
+    Handle handle = m_nextHandle++;
+    m_publishers.push_back({handle, std::move(publish)});
+    return handle;
+}
+
+void TelemetryPublisher::RemovePublisher(Handle handle) {
+    std::scoped_lock lock{m_mutex};
+    m_publishers.erase(
+        std::remove_if(m_publishers.begin(), m_publishers.end(),
+                       [=](const auto& p) { return p.handle == handle; }),
+        m_publishers.end());
+}
+
+void TelemetryPublisher::PublishAll() {
+    std::scoped_lock lock{m_mutex};
+    for (auto& publisher : m_publishers) {
+        publisher.publish();
+    }
+}
+
+void TelemetryPublisher::RunPublisher() {
+    ThreadPolicy::Apply(ThreadRole::kTelemetry);
+
+    while (m_running) {
+        PublishAll();
+        std::this_thread::sleep_for(kPeriod);
+    }
+
+    // Publish anything committed before Stop()
+    PublishAll();
+}
+
+TelemetrySource::TelemetrySource(
+    std::string_view table, std::initializer_list<std::string_view> names)
+    : m_numFields{names.size()} {
+    assert(names.size() <= kMaxFields);
+
+    auto ntTable = nt::NetworkTableInstance::GetDefault().GetTable(
+        wpi::StringRef{table.data(), table.size()});
+    size_t i = 0;
+    for (auto name : names) {
+        m_entries[i] =
+            ntTable->GetEntry(wpi::StringRef{name.data(), name.size()});
+        ++i;
+    }
+
+    // NaN never compares equal, so every field is published the first time
+    m_published.fill(std::numeric_limits<double>::quiet_NaN());
+
+    m_handle = TelemetryPublisher::GetInstance().AddPublisher(
+        [=] { Publish(); });
+}
+
+TelemetrySource::~TelemetrySource() {
+    TelemetryPublisher::GetInstance().RemovePublisher(m_handle);
+}
+
+void TelemetrySource::Publish() {
+    if (m_front.GetVersion() == m_publishedVersion) {
+        return;
+    }
+    m_publishedVersion = m_front.GetVersion();
+
+    auto snapshot = m_front.Load();
+    for (size_t i = 0; i < m_numFields; ++i) {
+        if (snapshot[i] != m_published[i]) {
+            m_entries[i].SetDouble(snapshot[i]);
+            m_published[i] = snapshot[i];
+        }
+    }
+}
+
+}  // namespace frc3512
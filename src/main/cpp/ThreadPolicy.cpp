@@ -0,0 +1,203 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "ThreadPolicy.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#ifdef __FRC_ROBORIO__
+#include <link.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
+#include <frc/RobotController.h>
+#include <frc/Threads.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+// The number of periods a wakeup may be late by before it's treated as a gap
+constexpr uint64_t kMaxLatePeriods = 4;
+
+/**
+ * Touches and locks the next kStackPrefaultSize bytes of the calling thread's
+ * stack so using them later doesn't fault.
+ */
+[[gnu::noinline]] void PrefaultStack() {
+    volatile unsigned char stack[ThreadPolicy::kStackPrefaultSize];
+    std::memset(const_cast<unsigned char*>(stack), 0, sizeof(stack));
+    ThreadPolicy::LockRegion(const_cast<unsigned char*>(stack), sizeof(stack));
+}
+
+#ifdef __FRC_ROBORIO__
+/**
+ * A loaded object to lock, and the outcome.
+ */
+struct ObjectLock {
+    std::string_view name;
+    bool found = false;
+    bool locked = true;
+    size_t size = 0;
+};
+
+int LockObjectSegments(dl_phdr_info* info, size_t, void* data) {
+    auto& lock = *static_cast<ObjectLock*>(data);
+
+    // The robot program is the only object without a name. Libraries are
+    // matched by file name.
+    std::string_view path{info->dlpi_name};
+    auto slash = path.rfind('/');
+    std::string_view file =
+        slash == std::string_view::npos ? path : path.substr(slash + 1);
+    if (file != lock.name) {
+        return 0;
+    }
+
+    lock.found = true;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const auto& header = info->dlpi_phdr[i];
+        if (header.p_type != PT_LOAD) {
+            continue;
+        }
+
+        auto start =
+            reinterpret_cast<const void*>(info->dlpi_addr + header.p_vaddr);
+        lock.locked &= ThreadPolicy::LockRegion(start, header.p_memsz);
+        lock.size += header.p_memsz;
+    }
+    return 1;
+}
+#endif
+
+}  // namespace
+
+ThreadPolicy& ThreadPolicy::GetInstance() {
+    static ThreadPolicy instance;
+    return instance;
+}
+
+ThreadPolicy::ThreadPolicy() {
+    for (size_t i = 0; i < kPolicies.size(); ++i) {
+        m_sections[i] = &m_latencies.AddSection(kPolicies[i].name);
+    }
+}
+
+void ThreadPolicy::RetainHeap() {
+#ifdef __FRC_ROBORIO__
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+#endif
+}
+
+bool ThreadPolicy::LockRegion(const void* data, size_t size) {
+#ifdef __FRC_ROBORIO__
+    if (mlock(data, size) != 0) {
+        PrintFixed(stderr,
+                   FMT_COMPILE("ThreadPolicy: mlock() of {} bytes failed: "
+                               "{}\n"),
+                   size, std::strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    static_cast<void>(data);
+    static_cast<void>(size);
+    return false;
+#endif
+}
+
+bool ThreadPolicy::LockObject(std::string_view name) {
+#ifdef __FRC_ROBORIO__
+    ObjectLock lock{name};
+    dl_iterate_phdr(LockObjectSegments, &lock);
+    if (!lock.found) {
+        PrintFixed(stderr, FMT_COMPILE("ThreadPolicy: '{}' isn't loaded\n"),
+                   name);
+        return false;
+    }
+
+    PrintFixed(FMT_COMPILE("ThreadPolicy: locked {} bytes of '{}'\n"),
+               lock.size, name.empty() ? "robot program" : name);
+    return lock.locked;
+#else
+    static_cast<void>(name);
+    return false;
+#endif
+}
+
+bool ThreadPolicy::Apply(ThreadRole role) {
+    const auto& policy = GetPolicy(role);
+
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), policy.name);
+#endif
+
+    bool applied =
+        frc::SetCurrentThreadPriority(policy.realTime, policy.priority);
+
+#ifdef __FRC_ROBORIO__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(policy.cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) !=
+        0) {
+        applied = false;
+    }
+
+    if (policy.realTime) {
+        PrefaultStack();
+    }
+
+    if (!applied) {
+        PrintFixed(stderr,
+                   FMT_COMPILE("ThreadPolicy: couldn't apply the policy of "
+                               "'{}'\n"),
+                   policy.name);
+    }
+#endif
+
+    return applied;
+}
+
+LoopProfiler& ThreadPolicy::GetLatencyProfiler() { return m_latencies; }
+
+void ThreadPolicy::Report() const {
+    PrintFixed(FMT_COMPILE("Thread wakeup latency:\n"));
+    m_latencies.Print();
+}
+
+WakeupMonitor::WakeupMonitor(ThreadRole role, units::second_t period)
+    : m_role{role},
+      m_period{static_cast<uint64_t>(
+          units::microsecond_t{period}.to<double>())} {}
+
+void WakeupMonitor::Record() {
+    uint64_t now = frc::RobotController::GetFPGATime();
+
+    if (m_expected == 0 || now > m_expected + kMaxLatePeriods * m_period) {
+        m_expected = now + m_period;
+        return;
+    }
+
+    // An early wakeup means the phase seen so far was late, so the
+    // extrapolation restarts from it
+    if (now < m_expected) {
+        m_expected = now;
+    }
+    ThreadPolicy::GetInstance().RecordLatency(m_role, now - m_expected);
+
+    // Skip the periods missed by a late wakeup
+    do {
+        m_expected += m_period;
+    } while (m_expected <= now);
+}
+
+}  // namespace frc3512
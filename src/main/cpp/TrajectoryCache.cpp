@@ -0,0 +1,242 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "TrajectoryCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+#include <frc/Filesystem.h>
+#include <frc/kinematics/DifferentialDriveKinematics.h>
+#include <frc/trajectory/TrajectoryConfig.h>
+#include <frc/trajectory/TrajectoryGenerator.h>
+#include <frc/trajectory/constraint/DifferentialDriveVoltageConstraint.h>
+#include <units/curvature.h>
+#include <wpi/SmallString.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', '3', '5', '1', '2', 'T', 'R', 'J'};
+constexpr uint32_t kVersion = 1;
+
+/**
+ * The start of a trajectory file. numStates FileStates follow it. All fields
+ * are little-endian.
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numStates;
+    uint64_t hash;
+};
+
+/**
+ * One sample of a trajectory in SI units.
+ */
+struct FileState {
+    double t;
+    double velocity;
+    double acceleration;
+    double x;
+    double y;
+    double heading;
+    double curvature;
+};
+
+/**
+ * Accumulates a 64-bit FNV-1a hash.
+ */
+class Hasher {
+public:
+    void Add(const void* data, size_t size) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash = (m_hash ^ bytes[i]) * 1099511628211u;
+        }
+    }
+
+    void Add(double value) { Add(&value, sizeof(value)); }
+
+    void Add(const frc::Translation2d& translation) {
+        Add(translation.X().to<double>());
+        Add(translation.Y().to<double>());
+    }
+
+    void Add(const frc::Pose2d& pose) {
+        Add(pose.Translation());
+        Add(pose.Rotation().Radians().to<double>());
+    }
+
+    uint64_t Get() const { return m_hash; }
+
+private:
+    uint64_t m_hash = 14695981039346656037u;
+};
+
+std::optional<frc::Trajectory> Read(const std::string& path, uint64_t hash) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return std::nullopt;
+    }
+
+    FileHeader header;
+    std::vector<FileState> states;
+    if (std::fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+        header.version == kVersion && header.hash == hash) {
+        states.resize(header.numStates);
+        if (std::fread(states.data(), sizeof(FileState), states.size(),
+                       file) != states.size()) {
+            states.clear();
+        }
+    }
+    std::fclose(file);
+
+    if (states.empty()) {
+        return std::nullopt;
+    }
+
+    std::vector<frc::Trajectory::State> trajectoryStates;
+    trajectoryStates.reserve(states.size());
+    for (const auto& state : states) {
+        trajectoryStates.push_back(
+            {units::second_t{state.t},
+             units::meters_per_second_t{state.velocity},
+             units::meters_per_second_squared_t{state.acceleration},
+             frc::Pose2d{units::meter_t{state.x}, units::meter_t{state.y},
+                         units::radian_t{state.heading}},
+             units::curvature_t{state.curvature}});
+    }
+    return frc::Trajectory{trajectoryStates};
+}
+
+bool Write(const std::string& path, uint64_t hash,
+           const frc::Trajectory& trajectory) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.numStates = static_cast<uint32_t>(trajectory.States().size());
+    header.hash = hash;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    for (const auto& state : trajectory.States()) {
+        FileState fileState{state.t.to<double>(),
+                            state.velocity.to<double>(),
+                            state.acceleration.to<double>(),
+                            state.pose.X().to<double>(),
+                            state.pose.Y().to<double>(),
+                            state.pose.Rotation().Radians().to<double>(),
+                            state.curvature.to<double>()};
+        std::fwrite(&fileState, sizeof(fileState), 1, file);
+    }
+
+    return std::fclose(file) == 0;
+}
+
+}  // namespace
+
+std::string TrajectoryCache::GetDefaultDirectory() {
+    wpi::SmallString<128> path;
+    frc::filesystem::GetDeployDirectory(path);
+    return std::string{path.data(), path.size()} + "/trajectories";
+}
+
+TrajectoryCache::TrajectoryCache(std::string directory)
+    : m_directory{std::move(directory)} {}
+
+void TrajectoryCache::Add(std::string_view name,
+                          const TrajectoryDefinition& definition) {
+    m_entries[std::string{name}] = Entry{definition, {}, false};
+}
+
+int TrajectoryCache::Load() {
+    int generated = 0;
+
+    for (auto& [name, entry] : m_entries) {
+        if (entry.loaded) {
+            continue;
+        }
+
+        uint64_t hash = Hash(entry.definition);
+        std::string path = GetPath(name);
+        if (auto trajectory = Read(path, hash)) {
+            entry.trajectory = std::move(*trajectory);
+        } else {
+            PrintFixed(FMT_COMPILE("TrajectoryCache: generating {} since {} "
+                                   "is missing or out of date\n"),
+                       name, path);
+            entry.trajectory = Generate(entry.definition);
+            ++generated;
+
+            if (!Write(path, hash, entry.trajectory)) {
+                PrintFixed(stderr,
+                           FMT_COMPILE("TrajectoryCache: couldn't write {}\n"),
+                           path);
+            }
+        }
+        entry.loaded = true;
+    }
+
+    return generated;
+}
+
+const frc::Trajectory& TrajectoryCache::Get(std::string_view name) const {
+    auto it = m_entries.find(name);
+    if (it == m_entries.end() || !it->second.loaded) {
+        throw std::out_of_range{
+            fmt::format("TrajectoryCache: {} isn't loaded", name)};
+    }
+    return it->second.trajectory;
+}
+
+uint64_t TrajectoryCache::Hash(const TrajectoryDefinition& definition) {
+    Hasher hasher;
+    hasher.Add(&kVersion, sizeof(kVersion));
+    hasher.Add(definition.start);
+    for (const auto& waypoint : definition.interiorWaypoints) {
+        hasher.Add(waypoint);
+    }
+    hasher.Add(definition.end);
+    hasher.Add(definition.maxVelocity.to<double>());
+    hasher.Add(definition.maxAcceleration.to<double>());
+    hasher.Add(definition.reversed ? 1.0 : 0.0);
+    hasher.Add(definition.trackWidth.to<double>());
+    hasher.Add(definition.feedforward.kS.to<double>());
+    hasher.Add(definition.feedforward.kV.to<double>());
+    hasher.Add(definition.feedforward.kA.to<double>());
+    hasher.Add(definition.maxVoltage.to<double>());
+    return hasher.Get();
+}
+
+frc::Trajectory TrajectoryCache::Generate(
+    const TrajectoryDefinition& definition) {
+    frc::DifferentialDriveKinematics kinematics{definition.trackWidth};
+
+    frc::TrajectoryConfig config{definition.maxVelocity,
+                                 definition.maxAcceleration};
+    config.SetKinematics(kinematics);
+    config.SetReversed(definition.reversed);
+    config.AddConstraint(frc::DifferentialDriveVoltageConstraint{
+        definition.feedforward, kinematics, definition.maxVoltage});
+
+    return frc::TrajectoryGenerator::GenerateTrajectory(
+        definition.start, definition.interiorWaypoints, definition.end, config);
+}
+
+std::string TrajectoryCache::GetPath(std::string_view name) const {
+    return fmt::format("{}/{}.traj", m_directory, name);
+}
+
+}  // namespace frc3512
@@ -0,0 +1,225 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Tunables.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+#include <fmt/format.h>
+#include <frc/Filesystem.h>
+#include <wpi/SmallString.h>
+
+#include "FixedFormat.hpp"
+
+namespace frc3512 {
+
+namespace {
+
+std::string_view Trim(std::string_view text) {
+    constexpr std::string_view kWhitespace = " \t\r";
+
+    size_t start = text.find_first_not_of(kWhitespace);
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(kWhitespace);
+    return text.substr(start, end - start + 1);
+}
+
+/**
+ * Parses "name = value" lines into values. Returns false if a line is
+ * malformed.
+ */
+bool Parse(std::string_view text, std::string_view path,
+           std::map<std::string, double, std::less<>>& values) {
+    size_t lineNumber = 0;
+    while (!text.empty()) {
+        ++lineNumber;
+        size_t newline = text.find('\n');
+        std::string_view line = Trim(text.substr(0, newline));
+        text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                             : newline + 1);
+
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            PrintFixed(
+                FMT_COMPILE("Tunables: {}:{}: expected 'name = value'\n"),
+                path, lineNumber);
+            return false;
+        }
+
+        // strtod() needs a terminated string, and values are short
+        std::string value{Trim(line.substr(equals + 1))};
+        char* end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0') {
+            PrintFixed(FMT_COMPILE("Tunables: {}:{}: '{}' isn't a number\n"),
+                       path, lineNumber, value);
+            return false;
+        }
+
+        values[std::string{Trim(line.substr(0, equals))}] = number;
+    }
+
+    return true;
+}
+
+/**
+ * Reads and parses a file into values. Returns false if it couldn't be read
+ * or a line is malformed.
+ */
+bool ParseFile(std::string_view path,
+               std::map<std::string, double, std::less<>>& values) {
+    std::string pathString{path};
+
+#ifndef _WIN32
+    int fd = open(pathString.c_str(), O_RDONLY);
+    if (fd == -1) {
+        PrintFixed(
+            FMT_COMPILE("Tunables: couldn't open {}, so defaults are used\n"),
+            path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return false;
+    }
+
+    bool parsed = true;
+    if (info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        parsed = Parse({static_cast<const char*>(data), size}, path, values);
+        munmap(data, size);
+    }
+    close(fd);
+    return parsed;
+#else
+    // Windows has no mmap(), and only the desktop builds run there
+    std::ifstream file{pathString, std::ios::binary};
+    if (!file) {
+        PrintFixed(
+            FMT_COMPILE("Tunables: couldn't open {}, so defaults are used\n"),
+            path);
+        return false;
+    }
+
+    std::string text{std::istreambuf_iterator<char>{file},
+                     std::istreambuf_iterator<char>{}};
+    return Parse(text, path, values);
+#endif
+}
+
+}  // namespace
+
+Tunables& Tunables::GetInstance() {
+    static Tunables instance;
+    return instance;
+}
+
+Tunables::Tunables() {
+    Publish();
+
+    // Nothing is registered yet, so unknown names are reported later
+    Read(GetDefaultPath());
+}
+
+std::string Tunables::GetDefaultPath() {
+    wpi::SmallString<128> path;
+    frc::filesystem::GetDeployDirectory(path);
+    return std::string{path.data(), path.size()} + "/tunables.txt";
+}
+
+bool Tunables::Load(std::string_view path) {
+    if (!Read(path)) {
+        return false;
+    }
+
+    ReportUnknownNames();
+    return true;
+}
+
+void Tunables::ReportUnknownNames() {
+    std::scoped_lock lock{m_mutex};
+
+    for (const auto& [name, value] : m_fileValues) {
+        if (std::find(m_names.begin(), m_names.end(), name) == m_names.end()) {
+            PrintFixed(
+                FMT_COMPILE("Tunables: unknown name '{}' is ignored\n"), name);
+        }
+    }
+}
+
+size_t Tunables::Register(std::string_view name, double defaultValue) {
+    std::scoped_lock lock{m_mutex};
+
+    auto it = std::find(m_names.begin(), m_names.end(), name);
+    if (it != m_names.end()) {
+        return static_cast<size_t>(it - m_names.begin());
+    }
+
+    m_names.emplace_back(name);
+    m_defaults.emplace_back(defaultValue);
+    Publish();
+    return m_names.size() - 1;
+}
+
+bool Tunables::Read(std::string_view path) {
+    std::map<std::string, double, std::less<>> values;
+    if (!ParseFile(path, values)) {
+        return false;
+    }
+
+    std::scoped_lock lock{m_mutex};
+    m_fileValues = std::move(values);
+    Publish();
+    return true;
+}
+
+void Tunables::Publish() {
+    // The array is never empty so Get() always has a valid pointer to read
+    auto table =
+        std::make_unique<double[]>(std::max<size_t>(m_names.size(), 1));
+    for (size_t i = 0; i < m_names.size(); ++i) {
+        auto it = m_fileValues.find(m_names[i]);
+        table[i] = it != m_fileValues.end() ? it->second : m_defaults[i];
+    }
+
+    m_values.store(table.get(), std::memory_order_release);
+
+    // A reader only holds the pointer for one array access, so arrays retired
+    // longer than the grace period ago can't be in use anymore
+    auto now = std::chrono::steady_clock::now();
+    m_retired.erase(
+        std::remove_if(m_retired.begin(), m_retired.end(),
+                       [&](const RetiredTable& retired) {
+                           return now - retired.time > kGracePeriod;
+                       }),
+        m_retired.end());
+    if (m_table) {
+        m_retired.push_back({std::move(m_table), now});
+    }
+    m_table = std::move(table);
+}
+
+}  // namespace frc3512
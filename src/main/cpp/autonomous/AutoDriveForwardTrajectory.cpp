@@ -0,0 +1,9 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Robot.hpp"
+
+using Seq = frc3512::AutonomousSequence;
+
+Seq::Command Robot::AutoDriveForwardTrajectory() {
+    return FollowTrajectory("DriveForward");
+}
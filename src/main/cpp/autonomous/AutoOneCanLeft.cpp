@@ -1,52 +1,23 @@
 // Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
-#include <frc2/Timer.h>
-
 #include "Robot.hpp"
 
-void Robot::AutoOneCanLeft() {
-    elevator.SetManualMode(false);
-    elevator.SetIntakeDirection(Elevator::S_STOPPED);
-
-    // Seek ground
-    elevator.RaiseElevator(Elevator::kGroundHeight);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-
-    // Grab can
-    frc2::Timer timer;
-    timer.Start();
-    elevator.ElevatorGrab(true);
-    while (!timer.HasPeriodPassed(0.2_s)) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+using Seq = frc3512::AutonomousSequence;
 
-    // Seek garbage can up
-    elevator.RaiseElevator(Elevator::kToteHeight4);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+Seq::Command Robot::AutoOneCanLeft() {
+    return Seq::Sequential(
+        Seq::Instant([=] {
+            elevator.SetManualMode(false);
+            elevator.SetIntakeDirection(Elevator::S_STOPPED);
+        }),
 
-    // Drive forward
-    timer.Reset();
-    while (!timer.HasPeriodPassed(0.8_s)) {
-        drivetrain.Drive(-0.3, 0, false);
+        // Seek ground
+        ElevatorTo(Elevator::kGroundHeight),
 
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+        // Grab can
+        Seq::Instant([=] { elevator.ElevatorGrab(true); }), Seq::Wait(0.2_s),
 
-    drivetrain.Drive(0, 0, false);
+        // Drive forward while the can is lifted
+        Seq::Parallel(ElevatorTo(elevator.toteHeight4),
+                      DriveFor(0.8_s, -0.3, 0.0, false)));
 }
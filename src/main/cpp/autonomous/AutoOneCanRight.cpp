@@ -1,39 +1,22 @@
 // Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
-#include <frc2/Timer.h>
-
 #include "Robot.hpp"
 
-void Robot::AutoOneCanRight() {
-    elevator.SetManualMode(false);
-    elevator.SetIntakeDirection(Elevator::S_STOPPED);
+using Seq = frc3512::AutonomousSequence;
+
+Seq::Command Robot::AutoOneCanRight() {
+    return Seq::Sequential(
+        Seq::Instant([=] {
+            elevator.SetManualMode(false);
+            elevator.SetIntakeDirection(Elevator::S_STOPPED);
+        }),
 
-    // Seek ground
-    elevator.RaiseElevator(Elevator::kGroundHeight);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+        // Seek ground
+        ElevatorTo(Elevator::kGroundHeight),
 
-    // Grab can
-    frc2::Timer timer;
-    timer.Start();
-    elevator.ElevatorGrab(true);
-    while (!timer.HasPeriodPassed(0.2_s)) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+        // Grab can
+        Seq::Instant([=] { elevator.ElevatorGrab(true); }), Seq::Wait(0.2_s),
 
-    // Seek garbage can up
-    elevator.RaiseElevator(Elevator::kToteHeight4);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+        // Seek garbage can up
+        ElevatorTo(elevator.toteHeight4));
 }
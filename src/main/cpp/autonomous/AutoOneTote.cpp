@@ -2,66 +2,46 @@
 
 #include "Robot.hpp"
 
-void Robot::AutoOneTote() {
-    elevator.SetManualMode(false);
-    elevator.SetIntakeDirection(Elevator::S_STOPPED);
-
-    // Seek garbage can up
-    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
-    elevator.StowIntake(false);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-
-    // Move to tote
-    frc2::Timer timer;
-    timer.Start();
-    while (!timer.HasPeriodPassed(1_s)) {
-        drivetrain.Drive(-0.3, 0, false);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-
-    // Autostack
-    timer.Reset();
-    elevator.IntakeGrab(true);
-    elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(1_s)) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-
-    // Turn
-    timer.Reset();
-    elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(1_s)) {
-        drivetrain.Drive(-0.3, -0.3, true);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-    drivetrain.Drive(0.0, 0.0, false);
-
-    // Run away
-    timer.Reset();
-    elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(3_s)) {
-        drivetrain.Drive(-0.3, 0, false);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-    drivetrain.Drive(0, 0, false);
+using Seq = frc3512::AutonomousSequence;
+
+// autoOneToteConfig is read as each step starts so the simulation parameter
+// sweep can change it after the sequence is built
+Seq::Command Robot::AutoOneTote() {
+    return Seq::Sequential(
+        Seq::Instant([=] {
+            elevator.SetManualMode(false);
+            elevator.SetIntakeDirection(Elevator::S_STOPPED);
+        }),
+
+        // Seek garbage can up
+        Seq::Instant([=] { elevator.StowIntake(false); }),
+        ElevatorTo(elevator.garbageCanHeight),
+
+        // Move to tote
+        DriveFor([=] { return autoOneToteConfig.approachTime; },
+                 [=] {
+                     drivetrain.Drive(autoOneToteConfig.approachPower, 0,
+                                      false);
+                 }),
+
+        // Autostack
+        Seq::Instant([=] {
+            elevator.IntakeGrab(true);
+            elevator.SetIntakeDirection(Elevator::S_REVERSE);
+        }),
+        Seq::Wait([=] { return autoOneToteConfig.intakeTime; }),
+
+        // Turn
+        DriveFor([=] { return autoOneToteConfig.turnTime; },
+                 [=] {
+                     drivetrain.Drive(autoOneToteConfig.turnThrottle,
+                                      autoOneToteConfig.turnRate, true);
+                 }),
+
+        // Run away
+        DriveFor([=] { return autoOneToteConfig.retreatTime; },
+                 [=] {
+                     drivetrain.Drive(autoOneToteConfig.retreatPower, 0,
+                                      false);
+                 }));
 }
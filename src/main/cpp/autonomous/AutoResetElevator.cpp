@@ -2,17 +2,15 @@
 
 #include "Robot.hpp"
 
-void Robot::AutoResetElevator() {
-    elevator.SetManualMode(false);
-    elevator.StowIntake(true);
-    elevator.SetIntakeDirection(Elevator::S_STOPPED);
+using Seq = frc3512::AutonomousSequence;
 
-    // Seek ground
-    elevator.RaiseElevator(Elevator::kGroundHeight);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+Seq::Command Robot::AutoResetElevator() {
+    return Seq::Sequential(Seq::Instant([=] {
+                               elevator.SetManualMode(false);
+                               elevator.StowIntake(true);
+                               elevator.SetIntakeDirection(Elevator::S_STOPPED);
+                           }),
+
+                           // Seek ground
+                           ElevatorTo(Elevator::kGroundHeight));
 }
@@ -0,0 +1,41 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Robot.hpp"
+
+using Seq = frc3512::AutonomousSequence;
+
+Seq::Command Robot::ElevatorTo(units::meter_t height) {
+    return Seq::Sequential(
+        Seq::Instant([=] { elevator.RaiseElevator(height); }),
+        Seq::WaitUntil([=] { return elevator.AtGoal(); }));
+}
+
+Seq::Command Robot::ElevatorTo(const frc3512::Tunable<units::inch_t>& height) {
+    return Seq::Sequential(
+        Seq::Instant([=, &height] { elevator.RaiseElevator(height.Get()); }),
+        Seq::WaitUntil([=] { return elevator.AtGoal(); }));
+}
+
+Seq::Command Robot::DriveFor(units::second_t duration, double throttle,
+                             double turn, bool isQuickTurn) {
+    return DriveFor([=] { return duration; },
+                    [=] { drivetrain.Drive(throttle, turn, isQuickTurn); });
+}
+
+Seq::Command Robot::DriveFor(std::function<units::second_t()> duration,
+                             std::function<void()> drive) {
+    return Seq::Deadline(
+        Seq::Wait(std::move(duration)),
+        Seq::Run(std::move(drive), [=] { drivetrain.Drive(0.0, 0.0, false); }));
+}
+
+Seq::Command Robot::FollowTrajectory(std::string_view name) {
+    // Looked up now so a missing trajectory throws at construction instead of
+    // during a match
+    const frc::Trajectory* trajectory = &trajectories.Get(name);
+
+    return Seq::Sequential(
+        Seq::Instant([=] { drivetrain.FollowTrajectory(*trajectory); }),
+        Seq::WaitUntil([=] { return !drivetrain.IsFollowingTrajectory(); },
+                       [=] { drivetrain.StopTrajectory(); }));
+}
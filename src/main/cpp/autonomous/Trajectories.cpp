@@ -0,0 +1,9 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Robot.hpp"
+
+void Robot::AddTrajectories(frc3512::TrajectoryCache& cache) {
+    cache.Add("DriveForward",
+              Drivetrain::MakeTrajectory(frc::Pose2d{0_m, 0_m, 0_rad}, {},
+                                         frc::Pose2d{3_m, 0_m, 0_rad}));
+}
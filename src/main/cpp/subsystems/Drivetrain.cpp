@@ -2,57 +2,497 @@
 
 #include "subsystems/Drivetrain.hpp"
 
+#include <chrono>
 #include <cmath>
 
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <frc/DriverStation.h>
+#include <frc/RobotController.h>
+#include <frc2/Timer.h>
+#include <units/math.h>
 
-Drivetrain::Drivetrain() { m_leftGrbx.SetInverted(true); }
+#include "FixedFormat.hpp"
+#include "PowerMonitor.hpp"
+
+namespace {
+
+// Written by WarmUp() so its results aren't optimized away
+volatile double warmUpSink;
+
+}  // namespace
+
+Drivetrain::Drivetrain(TalonSRXGroup::ControllerLocation controllerLocation) {
+    m_state.controllerLocation = controllerLocation;
+
+    m_leftGrbx.SetInverted(true);
+
+    // Start the estimate now so the first update doesn't predict across the
+    // time since boot
+    m_estimator.Reset(frc2::Timer::GetFPGATimestamp(), 0_m, 0_m);
+
+    m_gyroThread = std::thread{[=] { CalibrateGyro(); }};
+
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        ConfigTalonController(m_leftGrbx, m_leftEncoder,
+                              m_controllers.GetGains(kLeft));
+        ConfigTalonController(m_rightGrbx, m_rightEncoder,
+                              m_controllers.GetGains(kRight));
+    }
+}
+
+Drivetrain::~Drivetrain() {
+    m_stopGyroThread = true;
+    m_gyroThread.join();
+}
+
+bool Drivetrain::IsGyroReady() const {
+    return m_gyroReady.load(std::memory_order_acquire);
+}
 
 void Drivetrain::Drive(double throttle, double turn, bool isQuickTurn) {
+    m_drive.SetMaxOutput(PowerMonitor::GetInstance().GetDriveScale());
     m_drive.CurvatureDrive(throttle, turn, isQuickTurn);
 }
 
+double Drivetrain::GetLeftOutput() const { return m_leftGrbx.Get(); }
+
+double Drivetrain::GetRightOutput() const { return m_rightGrbx.Get(); }
+
 void Drivetrain::ResetEncoders() {
     m_leftEncoder.Reset();
     m_rightEncoder.Reset();
+    m_estimator.Reset(frc2::Timer::GetFPGATimestamp(), 0_m, 0_m);
+
+    m_state.leftOdometryOffset = 0_m;
+    m_state.rightOdometryOffset = 0_m;
+    m_odometry.ResetPosition(frc::Pose2d{}, GetGyroHeading());
 }
 
 units::inch_t Drivetrain::GetLeftDistance() {
-    return units::inch_t{m_leftEncoder.GetDistance()};
+    return m_estimator.GetEstimate().leftDistance;
 }
 
 units::inch_t Drivetrain::GetRightDistance() {
-    return units::inch_t{m_rightEncoder.GetDistance()};
+    return m_estimator.GetEstimate().rightDistance;
+}
+
+frc3512::DrivetrainEstimator::Estimate Drivetrain::GetStateEstimate() const {
+    return m_estimator.GetEstimate();
 }
 
 void Drivetrain::SetLeftGoal(units::foot_t goal) {
-    m_leftController.SetGoal(goal);
+    m_state.leftGoal = goal;
+    m_controllers.SetGoal(kLeft, goal);
 }
 
 void Drivetrain::SetRightGoal(units::foot_t goal) {
-    m_rightController.SetGoal(goal);
+    m_state.rightGoal = goal;
+    m_controllers.SetGoal(kRight, goal);
 }
 
 void Drivetrain::SetLeftVoltage(units::volt_t voltage) {
-    m_leftGrbx.SetVoltage(voltage);
+    // The left gearbox is inverted to cancel DifferentialDrive's right-side
+    // inversion, so forward is negative on it
+    m_leftGrbx.SetVoltage(-voltage);
 }
 
 void Drivetrain::SetRightVoltage(units::volt_t voltage) {
     m_rightGrbx.SetVoltage(voltage);
 }
 
-bool Drivetrain::LeftAtGoal() const { return m_leftController.AtGoal(); }
+bool Drivetrain::LeftAtGoal() const {
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        return units::math::abs(units::inch_t{m_leftEncoder.GetDistance()} -
+                                m_state.leftGoal) < kTalonGoalTolerance;
+    }
+    return m_controllers.AtGoal(kLeft);
+}
 
-bool Drivetrain::RightAtGoal() const { return m_rightController.AtGoal(); }
+bool Drivetrain::RightAtGoal() const {
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        return units::math::abs(units::inch_t{m_rightEncoder.GetDistance()} -
+                                m_state.rightGoal) < kTalonGoalTolerance;
+    }
+    return m_controllers.AtGoal(kRight);
+}
 
 void Drivetrain::SetSetpointsToMeasurements() {
-    m_leftController.Reset(units::inch_t{m_leftEncoder.GetDistance()});
-    m_rightController.Reset(units::inch_t{m_rightEncoder.GetDistance()});
+    auto estimate = m_estimator.GetEstimate();
+    m_controllers.Reset(kLeft, estimate.leftDistance);
+    m_controllers.Reset(kRight, estimate.rightDistance);
+}
+
+void Drivetrain::SetControllersEnabled(bool enabled) {
+    m_state.controllersEnabled = enabled;
+}
+
+bool Drivetrain::AreControllersEnabled() const {
+    return m_state.controllersEnabled;
+}
+
+frc3512::TrajectoryDefinition Drivetrain::MakeTrajectory(
+    const frc::Pose2d& start, const std::vector<frc::Translation2d>& interior,
+    const frc::Pose2d& end, bool reversed) {
+    frc3512::TrajectoryDefinition definition;
+    definition.start = start;
+    definition.interiorWaypoints = interior;
+    definition.end = end;
+    definition.maxVelocity = kMaxTrajectoryV;
+    definition.maxAcceleration = kMaxTrajectoryA;
+    definition.reversed = reversed;
+    definition.trackWidth = kTrackWidth;
+    definition.feedforward = kFeedforward;
+    definition.maxVoltage = kMaxTrajectoryVoltage;
+    return definition;
+}
+
+frc::Pose2d Drivetrain::GetPose() const { return m_odometry.GetPose(); }
+
+void Drivetrain::ResetOdometry(const frc::Pose2d& pose) {
+    // The encoders aren't reset because the Talons don't report the new
+    // position until their next status frame
+    auto estimate = m_estimator.GetEstimate();
+    m_state.leftOdometryOffset = estimate.leftDistance;
+    m_state.rightOdometryOffset = estimate.rightDistance;
+    m_odometry.ResetPosition(pose, GetGyroHeading());
+}
+
+void Drivetrain::FollowTrajectory(const frc::Trajectory& trajectory) {
+    ResetOdometry(trajectory.InitialPose());
+    m_state.trajectory = &trajectory;
+    m_state.trajectoryStartTime = frc2::Timer::GetFPGATimestamp();
+    m_state.lastWheelSpeeds = {};
+}
+
+void Drivetrain::StopTrajectory() {
+    if (m_state.trajectory != nullptr) {
+        m_state.trajectory = nullptr;
+        SetLeftVoltage(0_V);
+        SetRightVoltage(0_V);
+    }
+}
+
+bool Drivetrain::IsFollowingTrajectory() const {
+    return m_state.trajectory != nullptr;
+}
+
+void Drivetrain::WarmUp(const frc::Trajectory& trajectory) const {
+    // Track each sample from where the previous one was instead of from the
+    // pose estimate, as if the drivetrain followed the trajectory exactly
+    constexpr auto dt = frc3512::Constants::kControllerPeriod;
+    frc::RamseteController ramsete;
+    frc::Pose2d pose = trajectory.InitialPose();
+    frc::DifferentialDriveWheelSpeeds lastWheelSpeeds;
+    for (auto t = 0_s; t <= trajectory.TotalTime(); t += dt) {
+        auto reference = trajectory.Sample(t);
+        auto wheelSpeeds =
+            kKinematics.ToWheelSpeeds(ramsete.Calculate(pose, reference));
+        units::volt_t leftVoltage = kFeedforward.Calculate(
+            wheelSpeeds.left, (wheelSpeeds.left - lastWheelSpeeds.left) / dt);
+        units::volt_t rightVoltage = kFeedforward.Calculate(
+            wheelSpeeds.right,
+            (wheelSpeeds.right - lastWheelSpeeds.right) / dt);
+        lastWheelSpeeds = wheelSpeeds;
+        pose = reference.pose;
+
+        warmUpSink = (leftVoltage + rightVoltage).to<double>();
+    }
 }
 
 void Drivetrain::UpdateControllers() {
-    m_leftGrbx.Set(
-        m_leftController.Calculate(units::inch_t{m_leftEncoder.GetDistance()}));
-    m_rightGrbx.Set(m_rightController.Calculate(
-        units::inch_t{m_rightEncoder.GetDistance()}));
+    UpdateEstimate();
+
+    auto estimate = m_estimator.GetEstimate();
+    m_odometry.Update(GetGyroHeading(),
+                      estimate.leftDistance - m_state.leftOdometryOffset,
+                      estimate.rightDistance - m_state.rightOdometryOffset);
+
+    const auto& pose = m_odometry.GetPose();
+    m_telemetry.Set(kPoseX, pose.X().to<double>());
+    m_telemetry.Set(kPoseY, pose.Y().to<double>());
+    m_telemetry.Set(kPoseHeading, pose.Rotation().Radians().to<double>());
+    m_telemetry.Set(kLeftVelocity, estimate.leftVelocity.to<double>());
+    m_telemetry.Set(kRightVelocity, estimate.rightVelocity.to<double>());
+    m_telemetry.Commit();
+
+    if (m_state.trajectory != nullptr) {
+        UpdateTrajectory();
+        return;
+    }
+
+    if (!m_state.controllersEnabled) {
+        return;
+    }
+
+    units::foot_t leftDistance = estimate.leftDistance;
+    units::foot_t rightDistance = estimate.rightDistance;
+
+    units::foot_t leftSetpoint;
+    units::foot_t rightSetpoint;
+    units::volt_t leftVoltage;
+    units::volt_t rightVoltage;
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        // The Talons follow their own profiles, so only goals are sent
+        m_leftGrbx.SetMotionMagic(
+            m_leftEncoder.ToSensorPosition(
+                units::inch_t{m_state.leftGoal}.to<double>()),
+            0_V);
+        m_rightGrbx.SetMotionMagic(
+            m_rightEncoder.ToSensorPosition(
+                units::inch_t{m_state.rightGoal}.to<double>()),
+            0_V);
+
+        leftSetpoint = m_state.leftGoal;
+        rightSetpoint = m_state.rightGoal;
+        leftVoltage =
+            units::volt_t{m_frontLeftMotor.GetMotorOutputVoltage()};
+        rightVoltage =
+            units::volt_t{m_frontRightMotor.GetMotorOutputVoltage()};
+    } else {
+        auto outputs = m_controllers.Calculate({leftDistance, rightDistance});
+        m_leftGrbx.Set(-outputs[kLeft]);
+        m_rightGrbx.Set(outputs[kRight]);
+
+        auto batteryVoltage = PowerMonitor::GetInstance().GetBatteryVoltage();
+        leftSetpoint = m_controllers.GetSetpoint(kLeft).position;
+        rightSetpoint = m_controllers.GetSetpoint(kRight).position;
+        leftVoltage = outputs[kLeft] * batteryVoltage;
+        rightVoltage = outputs[kRight] * batteryVoltage;
+    }
+
+    m_recorder.Record({static_cast<float>(leftSetpoint.to<double>()),
+                       static_cast<float>(leftDistance.to<double>()),
+                       static_cast<float>(leftVoltage.to<double>()),
+                       static_cast<float>(LeftAtGoal()),
+                       static_cast<float>(rightSetpoint.to<double>()),
+                       static_cast<float>(rightDistance.to<double>()),
+                       static_cast<float>(rightVoltage.to<double>()),
+                       static_cast<float>(RightAtGoal())});
+}
+
+void Drivetrain::FlushSignals(std::string_view directory) {
+    m_recorder.Flush(directory);
+    m_trajectoryRecorder.Flush(directory);
+}
+
+void Drivetrain::SimulationPeriodic(units::second_t dt) {
+    auto& leftSim = m_frontLeftMotor.GetSimCollection();
+    auto& rightSim = m_frontRightMotor.GetSimCollection();
+
+    double batteryVoltage =
+        frc::RobotController::GetBatteryVoltage().to<double>();
+    leftSim.SetBusVoltage(batteryVoltage);
+    rightSim.SetBusVoltage(batteryVoltage);
+
+    m_drivetrainSim.SetInputs(
+        units::volt_t{leftSim.GetMotorOutputLeadVoltage()},
+        units::volt_t{rightSim.GetMotorOutputLeadVoltage()});
+    m_drivetrainSim.Update(dt);
+
+    if (!m_gyroSim && IsGyroReady()) {
+        m_gyroSim.emplace(*m_gyro);
+    }
+
+    // The gyro measures clockwise
+    if (m_gyroSim) {
+        m_gyroSim->SetAngle(-m_drivetrainSim.GetHeading().Degrees());
+        m_gyroSim->SetRate(-units::radians_per_second_t{
+            (m_drivetrainSim.GetRightVelocity() -
+             m_drivetrainSim.GetLeftVelocity())
+                .to<double>() /
+            kTrackWidth.to<double>()});
+    }
+
+    // The encoders are advanced by the distance moved rather than set so
+    // ResetEncoders() still works
+    int leftPulses = static_cast<int>(std::round(
+        units::inch_t{m_drivetrainSim.GetLeftPosition()}.to<double>() /
+        kDistancePerPulse));
+    int rightPulses = static_cast<int>(std::round(
+        units::inch_t{m_drivetrainSim.GetRightPosition()}.to<double>() /
+        kDistancePerPulse));
+    leftSim.AddQuadraturePosition(leftPulses - m_leftSimPulses);
+    rightSim.AddQuadraturePosition(rightPulses - m_rightSimPulses);
+    m_leftSimPulses = leftPulses;
+    m_rightSimPulses = rightPulses;
+
+    // Talon velocities are in pulses per 100 ms
+    units::inch_t leftPer100ms = m_drivetrainSim.GetLeftVelocity() * 100_ms;
+    units::inch_t rightPer100ms = m_drivetrainSim.GetRightVelocity() * 100_ms;
+    leftSim.SetQuadratureVelocity(
+        static_cast<int>(leftPer100ms.to<double>() / kDistancePerPulse));
+    rightSim.SetQuadratureVelocity(
+        static_cast<int>(rightPer100ms.to<double>() / kDistancePerPulse));
+}
+
+frc::Pose2d Drivetrain::GetSimulatedPose() const {
+    return m_drivetrainSim.GetPose();
+}
+
+frc::Rotation2d Drivetrain::GetGyroHeading() const {
+    if (!m_state.gyroInUse) {
+        return frc::Rotation2d{GetWheelHeading()};
+    }
+    return frc::Rotation2d{m_state.gyroHeadingOffset +
+                           units::degree_t{-m_gyro->GetAngle()}};
+}
+
+units::radians_per_second_t Drivetrain::GetGyroRate() const {
+    return units::degrees_per_second_t{-m_gyro->GetRate()};
+}
+
+units::radian_t Drivetrain::GetWheelHeading() const {
+    auto estimate = m_estimator.GetEstimate();
+    return units::radian_t{
+        (estimate.rightDistance - estimate.leftDistance).to<double>() /
+        kTrackWidth.to<double>()};
+}
+
+void Drivetrain::CalibrateGyro() {
+    using namespace std::chrono_literals;
+
+    // The constructor calibrates
+    m_gyroCalibrating = true;
+    m_gyro = std::make_unique<frc::ADXRS450_Gyro>();
+    m_gyroCalibrating = false;
+
+    while (m_gyroMovedWhileCalibrating.exchange(false)) {
+        frc3512::PrintFixed(
+            FMT_COMPILE("Drivetrain: the wheels moved during gyro calibration, "
+                        "so it will calibrate again once disabled\n"));
+
+        // Wait until the robot has been disabled long enough to coast to a
+        // stop
+        auto& ds = frc::DriverStation::GetInstance();
+        int disabledPolls = 0;
+        while (disabledPolls < 10) {
+            if (m_stopGyroThread) {
+                return;
+            }
+            std::this_thread::sleep_for(100ms);
+            disabledPolls = ds.IsDisabled() ? disabledPolls + 1 : 0;
+        }
+
+        m_gyroCalibrating = true;
+        m_gyro->Calibrate();
+        m_gyroCalibrating = false;
+    }
+
+    m_gyroReady.store(true, std::memory_order_release);
+}
+
+void Drivetrain::UpdateEstimate() {
+    auto now = frc2::Timer::GetFPGATimestamp();
+
+    if (!m_state.gyroInUse && IsGyroReady()) {
+        m_state.gyroHeadingOffset =
+            GetWheelHeading() - units::degree_t{-m_gyro->GetAngle()};
+        m_state.gyroInUse = true;
+    }
+
+    // The voltages were commanded on the last update and applied since then.
+    // The left gearbox's is negated so forward is positive on both sides.
+    if (m_state.gyroInUse) {
+        m_estimator.Update(now, -m_leftGrbx.GetVoltage(),
+                           m_rightGrbx.GetVoltage(), GetGyroRate());
+    } else {
+        m_estimator.Update(now, -m_leftGrbx.GetVoltage(),
+                           m_rightGrbx.GetVoltage());
+    }
+
+    // Both encoders' frames are sent at the same rate, so they're sampled
+    // within a frame period of each other
+    m_estimator.CorrectEncoders(
+        units::math::min(m_leftEncoder.GetTimestamp(),
+                         m_rightEncoder.GetTimestamp()),
+        units::inch_t{m_leftEncoder.GetDistance()},
+        units::inch_t{m_rightEncoder.GetDistance()});
+
+    if (m_gyroCalibrating.load(std::memory_order_relaxed)) {
+        auto estimate = m_estimator.GetEstimate();
+        if (units::math::abs(estimate.leftVelocity) >
+                kGyroCalibrationMaxSpeed ||
+            units::math::abs(estimate.rightVelocity) >
+                kGyroCalibrationMaxSpeed) {
+            m_gyroMovedWhileCalibrating = true;
+        }
+    }
+}
+
+void Drivetrain::UpdateTrajectory() {
+    units::second_t elapsed =
+        frc2::Timer::GetFPGATimestamp() - m_state.trajectoryStartTime;
+    if (elapsed > m_state.trajectory->TotalTime()) {
+        StopTrajectory();
+        return;
+    }
+
+    auto reference = m_state.trajectory->Sample(elapsed);
+    auto pose = m_odometry.GetPose();
+    auto wheelSpeeds =
+        kKinematics.ToWheelSpeeds(m_ramsete.Calculate(pose, reference));
+
+    // Feed forward the wheel speeds the Ramsete controller wants and correct
+    // the error in the estimated ones
+    constexpr auto dt = frc3512::Constants::kControllerPeriod;
+    auto estimate = m_estimator.GetEstimate();
+    units::meters_per_second_t leftRate = estimate.leftVelocity;
+    units::meters_per_second_t rightRate = estimate.rightVelocity;
+    units::volt_t leftVoltage =
+        kFeedforward.Calculate(
+            wheelSpeeds.left,
+            (wheelSpeeds.left - m_state.lastWheelSpeeds.left) / dt) +
+        units::volt_t{kWheelVelocityP *
+                      (wheelSpeeds.left - leftRate).to<double>()};
+    units::volt_t rightVoltage =
+        kFeedforward.Calculate(
+            wheelSpeeds.right,
+            (wheelSpeeds.right - m_state.lastWheelSpeeds.right) / dt) +
+        units::volt_t{kWheelVelocityP *
+                      (wheelSpeeds.right - rightRate).to<double>()};
+    m_state.lastWheelSpeeds = wheelSpeeds;
+
+    SetLeftVoltage(leftVoltage);
+    SetRightVoltage(rightVoltage);
+
+    m_trajectoryRecorder.Record(
+        {static_cast<float>(reference.pose.X().to<double>()),
+         static_cast<float>(reference.pose.Y().to<double>()),
+         static_cast<float>(reference.pose.Rotation().Radians().to<double>()),
+         static_cast<float>(pose.X().to<double>()),
+         static_cast<float>(pose.Y().to<double>()),
+         static_cast<float>(pose.Rotation().Radians().to<double>()),
+         static_cast<float>(leftVoltage.to<double>()),
+         static_cast<float>(rightVoltage.to<double>())});
+}
+
+void Drivetrain::ConfigTalonController(TalonSRXGroup& gearbox,
+                                       const CANEncoder& encoder,
+                                       const PositionController::Gains& gains) {
+    // The controllers' gains are in fractions of full output per foot. Full
+    // output is 1023 on the Talon, and its derivative is per millisecond
+    // instead of per second.
+    double pulsesPerFoot = std::abs(
+        encoder.ToSensorDistance(units::inch_t{1_ft}.to<double>()));
+
+    TalonSRXGroup::ClosedLoopGains talonGains;
+    talonGains.kP = gains.kP * 1023.0 / pulsesPerFoot;
+    talonGains.kI = gains.kI * 1023.0 / pulsesPerFoot / 1000.0;
+    talonGains.kD = gains.kD * 1023.0 / pulsesPerFoot * 1000.0;
+    talonGains.kF = kFeedforward.kV.to<double>() * 1023.0 /
+                    TalonSRXGroup::kNominalVoltage.to<double>() /
+                    std::abs(encoder.ToSensorVelocity(
+                        units::inch_t{1_m}.to<double>()));
+    gearbox.ConfigClosedLoop(talonGains);
+
+    // The encoders measure in inches
+    gearbox.ConfigMotionMagic(
+        std::abs(encoder.ToSensorVelocity(
+            units::inch_t{kMaxV * 1_s}.to<double>())),
+        std::abs(encoder.ToSensorVelocity(
+            units::inch_t{kMaxA * 1_s * 1_s}.to<double>())));
 }
@@ -2,149 +2,263 @@
 
 #include "subsystems/Elevator.hpp"
 
-#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+#include <Eigen/Core>
+#include <frc/RobotController.h>
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <units/math.h>
+
+#include "CANBusBudget.hpp"
+#include "EventLog.hpp"
+#include "LatencyTracer.hpp"
+
+namespace {
+
+// Written by WarmUp() so its results aren't optimized away
+volatile double warmUpSink;
+
+}  // namespace
+
+Elevator::Elevator(FeedbackMode feedbackMode,
+                   TalonSRXGroup::ControllerLocation controllerLocation) {
+    m_state.feedbackMode = feedbackMode;
+    m_state.controllerLocation = controllerLocation;
+
+    frc::LinearQuadraticRegulator<2, 1> lqr{
+        m_liftPlant,
+        {units::meter_t{1_in}.to<double>(),
+         units::meters_per_second_t{10_in / 1_s}.to<double>()},
+        {12.0},
+        frc3512::Constants::kControllerPeriod};
+    m_state.lqrGain = lqr.K();
+
+#ifdef __FRC_ROBORIO__
+    if (!kModelCharacterized) {
+        // Gains derived from the stand-in model would be guesses on the real
+        // lift, so it keeps the P controller it was tuned with
+        m_state.feedbackMode = FeedbackMode::kPD;
+        m_feedforward = frc::ElevatorFeedforward<units::inches>{};
+        m_feedback.SetPID(kUncharacterizedP, 0.0, 0.0);
+    }
+#endif
+
+    // Nothing reads the intake motors' status frames
+    CANBusBudget::GetInstance().SlowUnrequiredFrames(m_intakeLeftMotor);
+    CANBusBudget::GetInstance().SlowUnrequiredFrames(m_intakeRightMotor);
 
-#include <wpi/raw_ostream.h>
+    // The drive is scaled back when the battery sags, so the lift keeps its
+    // speed by compensating for the voltage it has left
+    m_liftGrbx.EnableVoltageCompensation();
 
-Elevator::Elevator() {
-    State state{"IDLE"};
-    state.entry = [this] { m_startAutoStacking = false; };
-    state.transition = [this] {
-        if (m_startAutoStacking) {
-            return "WAIT_INITIAL_HEIGHT";
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        ConfigTalonController();
+
+        // Sends the Motion Magic constraints in case the first goal doesn't
+        // need a new profile
+        PlanProfile(m_state.goal);
+    }
+
+    State<AutoStackState> state;
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        if (m_queueSize > 0) {
+            return StartNextCommand();
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
-    m_autoStackSM.SetState("IDLE");
+    m_autoStackSM.AddState(AutoStackState::kIdle, "IDLE", state);
 
-    state = State{"WAIT_INITIAL_HEIGHT"};
-    state.entry = [this] { SetGoal(kToteHeight1); };
-    state.transition = [this] {
+    state = State<AutoStackState>{};
+    state.entry = [this] { SetGoal(toteHeight1.Get()); };
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "SEEK_DROP_TOTES";
+            return AutoStackState::kSeekDropTotes;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kWaitInitialHeight,
+                           "WAIT_INITIAL_HEIGHT", state);
 
-    state = State{"SEEK_DROP_TOTES"};
+    state = State<AutoStackState>{};
     state.entry = [this] {
-        SetGoal(m_controller.GetGoal().position - kAutoDropHeight);
+        SetGoal(m_state.goal - autoDropHeight.Get());
     };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "RELEASE";
+            return AutoStackState::kRelease;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kSeekDropTotes, "SEEK_DROP_TOTES",
+                           state);
 
-    state = State{"RELEASE"};
+    state = State<AutoStackState>{};
     state.entry = [this] {
         m_grabTimer.Reset();
         m_grabTimer.Start();
         ElevatorGrab(false);
     };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.2_s)) {
-            return "SEEK_GROUND";
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        // The pipelined descent only waits for the tines to open
+        auto duration = m_pipelinedStacking ? kCylinderStrokeTime : 0.2_s;
+        if (m_grabTimer.HasPeriodPassed(duration)) {
+            return AutoStackState::kSeekGround;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kRelease, "RELEASE", state);
 
-    state = State{"SEEK_GROUND"};
+    state = State<AutoStackState>{};
     state.entry = [this] { SetGoal(kGroundHeight); };
-    state.transition = [this] {
-        if (AtGoal()) {
-            return "GRAB";
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        // Pipelined stacking closes the tines a stroke before the lift is
+        // predicted to reach the ground so they close as it arrives
+        if (AtGoal() ||
+            (m_pipelinedStacking &&
+             (m_limitSwitch.Get() ||
+              TimeUntilHeight(kGroundHeight) <= kCylinderStrokeTime))) {
+            return AutoStackState::kGrab;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kSeekGround, "SEEK_GROUND", state);
 
-    state = State{"GRAB"};
+    state = State<AutoStackState>{};
     state.entry = [this] {
         m_grabTimer.Reset();
         m_grabTimer.Start();
         ElevatorGrab(true);
     };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.4_s)) {
-            return "SEEK_HALF_TOTE";
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        auto duration = m_pipelinedStacking ? kCylinderStrokeTime : 0.4_s;
+        if (m_grabTimer.HasPeriodPassed(duration)) {
+            return AutoStackState::kSeekHalfTote;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
-
-    state = State{"SEEK_HALF_TOTE"};
-    state.entry = [this] { SetGoal(kToteHeight2); };
-    state.transition = [this] {
-        if (AtGoal()) {
-            return "INTAKE_IN";
+    m_autoStackSM.AddState(AutoStackState::kGrab, "GRAB", state);
+
+    state = State<AutoStackState>{};
+    state.entry = [this] { SetGoal(toteHeight2.Get()); };
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        if (AtGoal() ||
+            (m_pipelinedStacking &&
+             TimeUntilHeight(toteHeight2.Get()) <= kCylinderStrokeTime)) {
+            return AutoStackState::kIntakeIn;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kSeekHalfTote, "SEEK_HALF_TOTE",
+                           state);
 
-    state = State{"INTAKE_IN"};
+    state = State<AutoStackState>{};
     state.entry = [this] {
         m_grabTimer.Reset();
         m_grabTimer.Start();
         IntakeGrab(true);
     };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.2_s)) {
-            return "IDLE";
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        auto duration = m_pipelinedStacking ? kCylinderStrokeTime : 0.2_s;
+        if (m_grabTimer.HasPeriodPassed(duration)) {
+            // A queued cycle starts here without passing through IDLE
+            return StartNextCommand();
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    m_autoStackSM.AddState(AutoStackState::kIntakeIn, "INTAKE_IN", state);
+
+    state = State<AutoStackState>{};
+    state.entry = [this] {
+        frc3512::EventLog::GetInstance().Log(frc3512::Event::kElevatorSeek,
+                                             m_presetGoal.to<double>());
+        SetGoal(m_presetGoal);
+    };
+    state.transition = [this]() -> std::optional<AutoStackState> {
+        if (AtGoal()) {
+            return StartNextCommand();
+        } else {
+            return std::nullopt;
+        }
+    };
+    m_autoStackSM.AddState(AutoStackState::kSeekPreset, "SEEK_PRESET", state);
+
+    // States whose goal is already reached, such as WAIT_INITIAL_HEIGHT when
+    // the lift is already at the first tote height, are passed through in the
+    // same loop instead of costing a loop each. A stack cycle stops at its
+    // grab timers and each preset move uses up a queued command, so a loop
+    // never needs more transitions than there are states.
+    m_autoStackSM.SetMaxTransitionsPerRun(
+        static_cast<uint32_t>(AutoStackState::kNumStates));
+
+    m_autoStackSM.Validate();
+    m_autoStackSM.SetState(AutoStackState::kIdle);
+
+    frc::SmartDashboard::PutData("Auto-stack", &m_autoStackSM);
 }
 
-void Elevator::ElevatorGrab(bool state) { m_elevatorGrabber.Set(!state); }
+void Elevator::ElevatorGrab(bool state) {
+    m_elevatorGrabber.Set(!state);
+    frc3512::LatencyTracer::GetInstance().RecordCurrent(
+        frc3512::LatencyTracer::Output::kTines);
+}
 
 bool Elevator::IsElevatorGrabbed() const { return !m_elevatorGrabber.Get(); }
 
-void Elevator::IntakeGrab(bool state) { m_intakeGrabber.Set(state); }
+void Elevator::IntakeGrab(bool state) {
+    m_intakeGrabber.Set(state);
+    frc3512::LatencyTracer::GetInstance().RecordCurrent(
+        frc3512::LatencyTracer::Output::kIntakeArms);
+}
 
 bool Elevator::IsIntakeGrabbed() const { return m_intakeGrabber.Get(); }
 
-void Elevator::StowIntake(bool state) { m_intakeStower.Set(!state); }
+void Elevator::StowIntake(bool state) {
+    m_intakeStower.Set(!state);
+    frc3512::LatencyTracer::GetInstance().RecordCurrent(
+        frc3512::LatencyTracer::Output::kIntakeStow);
+}
 
 bool Elevator::IsIntakeStowed() const { return !m_intakeStower.Get(); }
 
-void Elevator::ContainerGrab(bool state) { m_containerGrabber.Set(!state); }
+void Elevator::ContainerGrab(bool state) {
+    m_containerGrabber.Set(!state);
+    frc3512::LatencyTracer::GetInstance().RecordCurrent(
+        frc3512::LatencyTracer::Output::kContainerGrabber);
+}
 
 bool Elevator::IsContainerGrabbed() const { return !m_containerGrabber.Get(); }
 
 void Elevator::SetIntakeDirection(IntakeMotorState state) {
+    using ctre::phoenix::motorcontrol::ControlMode;
+
     m_intakeState = state;
 
     if (state == S_STOPPED) {
-        m_intakeLeftMotor.Set(0);
-        m_intakeRightMotor.Set(0);
+        m_intakeLeftOutput.Set(ControlMode::PercentOutput, 0);
+        m_intakeRightOutput.Set(ControlMode::PercentOutput, 0);
     } else if (state == S_FORWARD) {
-        m_intakeLeftMotor.Set(1);
-        m_intakeRightMotor.Set(-1);
+        m_intakeLeftOutput.Set(ControlMode::PercentOutput, 1);
+        m_intakeRightOutput.Set(ControlMode::PercentOutput, -1);
     } else if (state == S_REVERSE) {
-        m_intakeLeftMotor.Set(-1);
-        m_intakeRightMotor.Set(1);
+        m_intakeLeftOutput.Set(ControlMode::PercentOutput, -1);
+        m_intakeRightOutput.Set(ControlMode::PercentOutput, 1);
     } else if (state == S_ROTATE_CCW) {
-        m_intakeLeftMotor.Set(-1);
-        m_intakeRightMotor.Set(-1);
+        m_intakeLeftOutput.Set(ControlMode::PercentOutput, -1);
+        m_intakeRightOutput.Set(ControlMode::PercentOutput, -1);
     } else if (state == S_ROTATE_CW) {
-        m_intakeLeftMotor.Set(1);
-        m_intakeRightMotor.Set(1);
+        m_intakeLeftOutput.Set(ControlMode::PercentOutput, 1);
+        m_intakeRightOutput.Set(ControlMode::PercentOutput, 1);
     }
 }
 
@@ -153,36 +267,36 @@ Elevator::IntakeMotorState Elevator::GetIntakeDirection() const {
 }
 
 void Elevator::SetManualLiftSpeed(units::volt_t value) {
-    if (m_manual) {
+    if (m_state.manual) {
         m_liftGrbx.SetVoltage(value);
     }
 }
 
 units::meters_per_second_t Elevator::GetManualLiftSpeed() {
-    if (m_manual) {
+    if (m_state.manual) {
         return units::inch_t{m_liftEncoder.GetRate()} / 1_s;
     }
     return 0_mps;
 }
 
 void Elevator::SetManualMode(bool on) {
-    if (on != m_manual) {
-        m_manual = on;
+    if (on != m_state.manual) {
+        m_state.manual = on;
 
-        if (m_manual) {
+        if (m_state.manual) {
             // Stop any auto-stacking when we switch to manual mode
-            m_autoStackSM.SetState("IDLE");
+            CancelStack();
         } else {
             SetGoal(GetHeight());
         }
     }
 }
 
-bool Elevator::IsManualMode() const { return m_manual; }
+bool Elevator::IsManualMode() const { return m_state.manual; }
 
 void Elevator::SetHeight(units::meter_t height) {
-    if (m_manual == false) {
-        m_controller.SetGoal(height);
+    if (m_state.manual == false) {
+        PlanProfile(height);
     }
 }
 
@@ -192,69 +306,338 @@ units::meter_t Elevator::GetHeight() {
 
 void Elevator::ResetEncoders() { m_liftEncoder.Reset(); }
 
-void Elevator::RaiseElevator(units::meter_t level) {
-    /* Only allow changing the elevator height manually if not currently
-     * auto-stacking
-     */
-    if (!IsStacking()) {
-        wpi::outs() << "Seeking to " << level.to<double>() << "\n";
+void Elevator::WarmUp() {
+    for (units::meter_t height :
+         {kGroundHeight, toteHeight1.Get(), toteHeight2.Get(),
+          toteHeight3.Get(), toteHeight4.Get(), toteHeight5.Get(),
+          garbageCanHeight.Get()}) {
+        auto move = PlanMove(height);
+        Profile profile{move.constraints, move.goal, m_state.setpoint};
+
+        // Evaluated like UpdateController() does along the whole move
+        double output = 0.0;
+        for (auto t = 0_s; !profile.IsFinished(t);
+             t += frc3512::Constants::kControllerPeriod) {
+            auto setpoint = profile.Calculate(t);
+            output += m_feedforward
+                          .Calculate(setpoint.velocity, setpoint.acceleration)
+                          .to<double>();
+            output += (m_state.lqrGain *
+                       Eigen::Vector2d{
+                           units::meter_t{setpoint.position}.to<double>(),
+                           units::meters_per_second_t{setpoint.velocity}
+                               .to<double>()})(0);
+        }
+        warmUpSink = output;
+    }
+}
+
+bool Elevator::RaiseElevator(units::meter_t level) {
+    // A command queued this loop hasn't started yet, but still goes first
+    if (!IsStacking() && m_queueSize == 0) {
+        frc3512::EventLog::GetInstance().Log(frc3512::Event::kElevatorSeek,
+                                             level.to<double>());
         SetGoal(level);
+        return true;
     }
+
+    // With nothing queued behind it, a move in progress is retargeted instead
+    // of finishing first
+    if (m_autoStackSM.GetState() == AutoStackState::kSeekPreset &&
+        m_queueSize == 0) {
+        m_presetGoal = level;
+        m_autoStackSM.SetState(AutoStackState::kSeekPreset);
+        return true;
+    }
+
+    return EnqueueCommand({Command::Type::kRaise, level});
 }
 
-void Elevator::StackTotes() {
+bool Elevator::StackTotes() {
     SetManualMode(false);
-    m_startAutoStacking = true;
+    return EnqueueCommand({Command::Type::kStack});
 }
 
-bool Elevator::IsStacking() const { return m_autoStackSM.GetState() != "IDLE"; }
+bool Elevator::IsStacking() const {
+    return m_autoStackSM.GetState() != AutoStackState::kIdle;
+}
+
+void Elevator::CancelStack() {
+    m_queueSize = 0;
+    m_commandInputTime = 0;
+    m_autoStackSM.SetState(AutoStackState::kIdle);
+}
 
-void Elevator::CancelStack() { m_autoStackSM.SetState("IDLE"); }
+size_t Elevator::GetQueuedCommandCount() const { return m_queueSize; }
+
+void Elevator::SetPipelinedStacking(bool on) { m_pipelinedStacking = on; }
+
+bool Elevator::IsPipelinedStacking() const { return m_pipelinedStacking; }
 
 void Elevator::UpdateState() {
-    m_autoStackSM.run();
+    m_autoStackSM.Run();
 
     /* Opens intake if the elevator is at the same level as it or if the tines
      * are open
      */
     if (IsIntakeGrabbed()) {
-        if ((m_controller.GetSetpoint().position < 11_in && !IsManualMode()) ||
+        if ((m_state.setpoint.position < 11_in && !IsManualMode()) ||
             !IsElevatorGrabbed() || IsIntakeStowed()) {
             IntakeGrab(false);
         }
     }
+}
 
+void Elevator::UpdateController() {
     // If elevator is at ground and wasn't before
-    if (!m_lastLimitSwitchValue && m_limitSwitch.Get()) {
+    if (!m_state.lastLimitSwitchValue && m_limitSwitch.Get()) {
         m_liftEncoder.Reset();
         SetGoal(GetHeight());
     }
-    m_liftGrbx.Set(
-        m_controller.Calculate(units::inch_t{m_liftEncoder.GetDistance()}));
 
-    m_lastLimitSwitchValue = m_limitSwitch.Get();
+    m_state.profileTime += frc3512::Constants::kControllerPeriod;
+    m_state.setpoint = m_state.profile.Calculate(m_state.profileTime);
+
+    // The encoder reading is up to a status frame old, so it's brought forward
+    // to now for the feedback controllers
+    units::inch_t height{
+        m_liftEncoder.GetDistance(frc2::Timer::GetFPGATimestamp())};
+    units::volt_t output;
+    if (m_state.controllerLocation ==
+        TalonSRXGroup::ControllerLocation::kTalon) {
+        // The Talon follows its own profile to the goal. The profile above
+        // only predicts where the lift is for auto-stacking and AtGoal().
+        m_liftGrbx.SetMotionMagic(
+            m_liftEncoder.ToSensorPosition(m_state.goal.to<double>()),
+            m_feedforward.kG);
+        output = units::volt_t{m_liftLeftMotor.GetMotorOutputVoltage()};
+    } else {
+        output = m_feedforward.Calculate(m_state.setpoint.velocity,
+                                         m_state.setpoint.acceleration);
+        if (m_state.feedbackMode == FeedbackMode::kLQR) {
+            units::meters_per_second_t velocity =
+                units::inch_t{m_liftEncoder.GetRate()} / 1_s;
+            Eigen::Vector2d r{
+                units::meter_t{m_state.setpoint.position}.to<double>(),
+                units::meters_per_second_t{m_state.setpoint.velocity}
+                    .to<double>()};
+            Eigen::Vector2d x{units::meter_t{height}.to<double>(),
+                              velocity.to<double>()};
+            output += units::volt_t{(m_state.lqrGain * (r - x))(0)};
+        } else {
+            output += units::volt_t{m_feedback.Calculate(
+                height.to<double>(), m_state.setpoint.position.to<double>())};
+        }
+        output = std::clamp(output, -12_V, 12_V);
+        m_liftGrbx.SetVoltage(output);
+    }
+
+    // The first voltage toward a traced goal ends its trace
+    frc3512::LatencyTracer::GetInstance().Record(
+        frc3512::LatencyTracer::Output::kLift, m_state.liftInputTime);
+    m_state.liftInputTime = 0;
+
+    m_state.atSetpoint = units::math::abs(m_state.setpoint.position - height) <
+                         kPositionTolerance;
+
+    m_recorder.Record(
+        {static_cast<float>(m_state.setpoint.position.to<double>()),
+         static_cast<float>(height.to<double>()),
+         static_cast<float>(output.to<double>()),
+         static_cast<float>(AtGoal())});
+
+    m_telemetry.Set(kHeight, height.to<double>());
+    m_telemetry.Set(kGoal, m_state.goal.to<double>());
+    m_telemetry.Set(kOutput, output.to<double>());
+    m_telemetry.Set(kAtGoal, AtGoal());
+    m_telemetry.Commit();
+
+    m_state.lastLimitSwitchValue = m_limitSwitch.Get();
 }
 
-bool Elevator::AtGoal() const { return m_controller.AtGoal(); }
+void Elevator::FlushSignals(std::string_view directory) {
+    m_recorder.Flush(directory);
+}
 
-void Elevator::SetGoal(units::meter_t height) {
+void Elevator::SimulationPeriodic(units::second_t dt) {
+    auto& liftSim = m_liftLeftMotor.GetSimCollection();
+
+    liftSim.SetBusVoltage(
+        frc::RobotController::GetBatteryVoltage().to<double>());
+
+    m_liftSim.SetInputVoltage(
+        units::volt_t{liftSim.GetMotorOutputLeadVoltage()});
+    m_liftSim.Update(dt);
+
+    units::inch_t height = m_liftSim.GetPosition();
+
+    // The encoder is advanced by the distance moved rather than set so the
+    // limit switch can still zero it
+    int pulses = static_cast<int>(
+        std::round(height.to<double>() / kDistancePerPulse));
+    liftSim.AddQuadraturePosition(pulses - m_liftSimPulses);
+    m_liftSimPulses = pulses;
+
+    // Talon velocities are in pulses per 100 ms
+    units::inch_t per100ms = m_liftSim.GetVelocity() * 100_ms;
+    liftSim.SetQuadratureVelocity(
+        static_cast<int>(per100ms.to<double>() / kDistancePerPulse));
+
+    liftSim.SetLimitRev(height < 0.25_in);
+}
+
+bool Elevator::AtGoal() const {
+    return m_state.profile.IsFinished(m_state.profileTime) &&
+           m_state.atSetpoint;
+}
+
+units::meter_t Elevator::GetGoal() const {
+    return m_state.goal;
+}
+
+void Elevator::SetUpConstraints(
+    units::feet_per_second_t maxVelocity,
+    units::feet_per_second_squared_t maxAcceleration) {
+    m_upConstraints = Profile::Constraints{maxVelocity, maxAcceleration,
+                                           kMaxJUp};
+}
+
+bool Elevator::EnqueueCommand(const Command& command) {
+    if (m_queueSize == kMaxQueuedCommands) {
+        return false;
+    }
+
+    auto& queued = m_queue[(m_queueHead + m_queueSize) % kMaxQueuedCommands];
+    queued = command;
+    queued.inputTime = frc3512::LatencyTracer::GetCurrentInputTime();
+    ++m_queueSize;
+    return true;
+}
+
+Elevator::AutoStackState Elevator::StartNextCommand() {
+    if (m_queueSize == 0) {
+        return AutoStackState::kIdle;
+    }
+
+    Command command = m_queue[m_queueHead];
+    m_queueHead = (m_queueHead + 1) % kMaxQueuedCommands;
+    --m_queueSize;
+    m_commandInputTime = command.inputTime;
+
+    if (command.type == Command::Type::kRaise) {
+        m_presetGoal = command.height;
+        return AutoStackState::kSeekPreset;
+    } else {
+        return AutoStackState::kWaitInitialHeight;
+    }
+}
+
+Elevator::Move Elevator::PlanMove(units::meter_t height) const {
     if (height > kMaxHeight) {
         height = kMaxHeight;
     }
 
-    // Set PID constant profile
-    if (height > GetHeight()) {
+    // Pick the constraints by which way the setpoint has to move. The
+    // setpoint is where the new profile starts, and it's already in memory.
+    if (height > m_state.setpoint.position) {
         // Going up.
-        m_controller.SetConstraints({kMaxVUp, kMaxAUp});
-    } else {
+        return {height, m_upConstraints.value_or(Profile::Constraints{
+                            maxVUp.Get(), maxAUp.Get(), kMaxJUp})};
+    } else if (height > 0_in) {
         // Going down.
-        if (height > 0_in) {
-            m_controller.SetConstraints({kMaxVDown, kMaxADown});
-        } else {
-            m_controller.SetConstraints({kMaxVDownZeroing, kMaxADown});
-            height = -100_in;
-        }
+        return {height, {maxVDown.Get(), maxADown.Get(), kMaxJDown}};
+    } else {
+        return {-100_in, {maxVDownZeroing.Get(), maxADown.Get(), kMaxJDown}};
+    }
+}
+
+void Elevator::SetGoal(units::meter_t height) {
+    auto move = PlanMove(height);
+
+    // The state machines and preset buttons set the same goal repeatedly, and
+    // replanning would restart a profile that's already heading there
+    if (move.goal == m_state.goal && move.constraints == m_activeConstraints) {
+        return;
+    }
+
+    m_activeConstraints = move.constraints;
+    PlanProfile(move.goal);
+
+    // A goal set by an input handler is traced to that input, and one set by
+    // the state machine to the input that queued the running command
+    uint64_t inputTime = frc3512::LatencyTracer::GetCurrentInputTime();
+    if (inputTime == 0) {
+        inputTime = m_commandInputTime;
     }
+    m_commandInputTime = 0;
+    if (inputTime != 0) {
+        frc3512::LatencyTracer::GetInstance().Record(
+            frc3512::LatencyTracer::Output::kLiftGoal, inputTime);
+        m_state.liftInputTime = inputTime;
+    }
+}
+
+void Elevator::PlanProfile(units::meter_t goal) {
+    // Planning from the setpoint's acceleration keeps the voltage continuous
+    // when the goal changes mid-move
+    m_state.goal = goal;
+    m_state.profile =
+        Profile{m_activeConstraints, m_state.goal, m_state.setpoint};
+    m_state.profileTime = 0_s;
+
+    // Each config call is a CAN frame, so only send changed constraints
+    if (m_state.controllerLocation ==
+            TalonSRXGroup::ControllerLocation::kTalon &&
+        m_activeConstraints != m_talonConstraints) {
+        m_talonConstraints = m_activeConstraints;
+        m_liftGrbx.ConfigMotionMagic(
+            std::abs(m_liftEncoder.ToSensorVelocity(
+                m_activeConstraints.maxVelocity.to<double>())),
+            std::abs(m_liftEncoder.ToSensorVelocity(
+                m_activeConstraints.maxAcceleration.to<double>())),
+            kMotionMagicSCurveStrength);
+    }
+}
+
+units::second_t Elevator::TimeUntilHeight(units::meter_t height) const {
+    return units::math::max(
+        m_state.profile.TimeLeftUntil(height) - m_state.profileTime, 0_s);
+}
+
+frc::ElevatorFeedforward<units::inches> Elevator::MakeFeedforward(
+    const frc::LinearSystem<2, 1, 1>& plant) {
+    using Feedforward = frc::ElevatorFeedforward<units::inches>;
+
+    // The model's acceleration is A(1, 1) v + B(1, 0) u - g, so holding it at
+    // a given velocity and acceleration takes u = (a + g - A(1, 1) v) / B(1, 0)
+    double kA = 1.0 / plant.B(1, 0);
+    double kV = -plant.A(1, 1) / plant.B(1, 0);
+    double kG = 9.806 * kA;
+
+    // The model is in meters and the feedforward is in inches
+    return Feedforward{0_V, units::volt_t{kG},
+                       units::unit_t<Feedforward::kv_unit>{
+                           kV * units::meter_t{1_in}.to<double>()},
+                       units::unit_t<Feedforward::ka_unit>{
+                           kA * units::meter_t{1_in}.to<double>()}};
+}
+
+void Elevator::ConfigTalonController() {
+    // Full output is 1023 at the nominal voltage, and the Talon's derivative
+    // is per millisecond instead of per second
+    constexpr double kOutputPerVolt =
+        1023.0 / TalonSRXGroup::kNominalVoltage.to<double>();
+    double pulsesPerInch = std::abs(m_liftEncoder.ToSensorDistance(1.0));
+
+    TalonSRXGroup::ClosedLoopGains gains;
+    gains.kP = m_feedback.GetP() * kOutputPerVolt / pulsesPerInch;
+    gains.kI = m_feedback.GetI() * kOutputPerVolt / pulsesPerInch / 1000.0;
+    gains.kD = m_feedback.GetD() * kOutputPerVolt / pulsesPerInch * 1000.0;
+
+    // Motion Magic has no acceleration feedforward, and gravity is sent as an
+    // arbitrary feedforward with each goal
+    gains.kF = m_feedforward.kV.to<double>() * kOutputPerVolt /
+               std::abs(m_liftEncoder.ToSensorVelocity(1.0));
 
-    m_controller.SetGoal(height);
+    m_liftGrbx.ConfigClosedLoop(gains);
 }
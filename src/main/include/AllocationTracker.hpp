@@ -0,0 +1,158 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+namespace frc3512 {
+
+/**
+ * Counts heap allocations made inside sections of code that shouldn't
+ * allocate, such as the periodic functions of the robot loop.
+ *
+ * The robot program replaces the global operator new so every allocation
+ * checks whether the calling thread is inside a Scope. If it is, the
+ * allocation is charged to the scope's site along with the address it was
+ * called from, so Report() can say where it happened. Allocations outside a
+ * scope cost one thread-local load.
+ *
+ * operator new is only replaced on Linux, which covers the roboRIO and the
+ * Linux simulation. Callers are reported as an object and offset there, and
+ * as raw addresses elsewhere.
+ *
+ * Even when memory is never returned, malloc() takes a lock that other
+ * threads hold, so a loop that allocates can stall behind them.
+ */
+class AllocationTracker {
+public:
+    static constexpr size_t kMaxSites = 16;
+
+    enum class Mode {
+        // Allocations in a scope are counted
+        kCount,
+
+        // Allocations in a scope are printed, then the program aborts
+        kAbort
+    };
+
+    /**
+     * The allocations made inside the scopes of one section of code.
+     */
+    class Site {
+    public:
+        // The number of distinct callers recorded per site. Allocations from
+        // any others are only counted.
+        static constexpr size_t kMaxCallers = 8;
+
+        /**
+         * Returns the name of the site.
+         */
+        const std::string& GetName() const;
+
+        /**
+         * Returns the number of allocations made in the site.
+         */
+        uint64_t GetCount() const;
+
+        /**
+         * Returns the number of bytes allocated in the site.
+         */
+        uint64_t GetBytes() const;
+
+        /**
+         * Clears the recorded allocations.
+         */
+        void Reset();
+
+    private:
+        friend class AllocationTracker;
+
+        std::string m_name;
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<uint64_t> m_bytes{0};
+        std::array<std::atomic<uintptr_t>, kMaxCallers> m_callers{};
+        std::array<std::atomic<uint64_t>, kMaxCallers> m_callerCounts{};
+
+        void Record(size_t size, uintptr_t caller);
+    };
+
+    /**
+     * Charges allocations made by the calling thread to a site for the
+     * lifetime of the object.
+     *
+     * Scopes may nest. The innermost one is charged.
+     */
+    class Scope {
+    public:
+        explicit Scope(Site& site);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Site* m_previous;
+    };
+
+    static AllocationTracker& GetInstance();
+
+    AllocationTracker(const AllocationTracker&) = delete;
+    AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+    /**
+     * Adds a site to the tracker.
+     *
+     * Sites should be added during initialization. Adding a name again
+     * returns the existing site. The returned reference is valid for the
+     * lifetime of the program.
+     *
+     * @param name The name of the site.
+     * @throws std::length_error if kMaxSites sites were already added.
+     */
+    Site& AddSite(std::string_view name);
+
+    /**
+     * Sets what happens when a scope allocates. The default is Mode::kCount.
+     *
+     * @param mode The mode.
+     */
+    void SetMode(Mode mode);
+
+    /**
+     * Prints the allocations of every site and where they were made.
+     *
+     * Callers are printed as an offset into the executable or shared library
+     * containing them, so they can be passed to addr2line.
+     */
+    void Report() const;
+
+    /**
+     * Clears the recorded allocations of every site.
+     */
+    void Reset();
+
+    /**
+     * Charges an allocation to the calling thread's innermost scope, if any.
+     *
+     * This is called by the replacement operator new.
+     *
+     * @param size   The size of the allocation in bytes.
+     * @param caller The return address of operator new.
+     */
+    static void OnAllocate(size_t size, void* caller);
+
+private:
+    std::array<Site, kMaxSites> m_sites;
+    size_t m_numSites = 0;
+    std::atomic<Mode> m_mode{Mode::kCount};
+
+    AllocationTracker() = default;
+};
+
+}  // namespace frc3512
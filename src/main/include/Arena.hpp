@@ -0,0 +1,137 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace frc3512 {
+
+/**
+ * A monotonic allocator for structures built once during initialization.
+ *
+ * The arena reserves one block up front and hands out pieces of it by bumping
+ * an offset, so allocations are contiguous and never touch malloc() or its
+ * lock. Memory is only given back when the arena is destroyed. Once the block
+ * is used up, allocations fall back to the heap and are counted so the
+ * capacity can be raised.
+ */
+class Arena {
+public:
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    /**
+     * Returns the arena for structures that live as long as the program.
+     */
+    static Arena& GetInstance();
+
+    /**
+     * Constructs an arena.
+     *
+     * @param capacity The size of the block in bytes.
+     */
+    explicit Arena(size_t capacity);
+
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Returns uninitialized memory.
+     *
+     * @param size      The size in bytes.
+     * @param alignment The alignment in bytes. It must be a power of two.
+     */
+    void* Allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+    /**
+     * Returns memory from Allocate(). Only memory that fell back to the heap
+     * is freed.
+     *
+     * @param ptr       The memory.
+     * @param size      The size passed to Allocate().
+     * @param alignment The alignment passed to Allocate().
+     */
+    void Deallocate(void* ptr, size_t size,
+                    size_t alignment = alignof(max_align_t));
+
+    /**
+     * Returns the number of bytes used from the block, including padding.
+     */
+    size_t GetUsed() const;
+
+    /**
+     * Returns the number of allocations that didn't fit in the block.
+     */
+    size_t GetOverflowCount() const;
+
+private:
+    std::unique_ptr<std::byte[]> m_block;
+    size_t m_capacity;
+    std::atomic<size_t> m_used{0};
+    std::atomic<size_t> m_overflows{0};
+
+    bool Contains(const void* ptr) const {
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        auto start = reinterpret_cast<uintptr_t>(m_block.get());
+        return address >= start && address < start + m_capacity;
+    }
+};
+
+/**
+ * Adapts an Arena for standard containers.
+ *
+ * Default-constructed allocators use Arena::GetInstance(). Containers moved
+ * or copied from each other keep their allocator, so moving a container never
+ * copies its elements.
+ *
+ * @tparam T The element type.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() : m_arena{&Arena::GetInstance()} {}
+
+    explicit ArenaAllocator(Arena& arena) : m_arena{&arena} {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT
+        : m_arena{other.m_arena} {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        m_arena->Deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& rhs) const {
+        return m_arena == rhs.m_arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const {
+        return m_arena != rhs.m_arena;
+    }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    Arena* m_arena;
+};
+
+}  // namespace frc3512
@@ -2,19 +2,28 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <array>
 #include <atomic>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 #include <frc/smartdashboard/Sendable.h>
 #include <frc/smartdashboard/SendableBuilder.h>
+#include <frc/smartdashboard/SendableHelper.h>
 #include <networktables/NetworkTableEntry.h>
+#include <units/time.h>
 #include <wpi/StringMap.h>
 #include <wpi/StringRef.h>
-#include <wpi/condition_variable.h>
-#include <wpi/mutex.h>
+
+#include "AutonomousSequence.hpp"
+#include "Fiber.hpp"
+#include "SeqLock.hpp"
+#include "TelemetryPublisher.hpp"
 
 namespace frc3512 {
 
@@ -22,8 +31,26 @@ namespace frc3512 {
  * A convenience wrapper around a SendableChooser for managing, selecting, and
  * running autonomous modes.
  */
-class AutonomousChooser : public frc::Sendable {
+class AutonomousChooser : public frc::Sendable,
+                          public frc::SendableHelper<AutonomousChooser> {
 public:
+    /**
+     * Determines how the autonomous mode runs alongside the main robot thread.
+     */
+    enum class ExecutionMode {
+        /// Run the autonomous mode in a worker thread that's spawned at
+        /// construction. Each yield hands control back through an atomic flag.
+        kThread,
+
+        /// Run the autonomous mode in a fiber on the main robot thread. Each
+        /// yield is a user-space context switch.
+        kFiber
+    };
+
+    // How often WarmUpSelected() repeats the selected mode's warm-up while the
+    // selection doesn't change, so it's still cached when the match starts
+    static constexpr units::second_t kWarmUpPeriod = 1_s;
+
     /**
      * Constructs an AutonomousChooser.
      *
@@ -32,18 +59,37 @@ public:
      *
      * @param name Name of autonomous mode.
      * @param func Autonomous mode function.
+     * @param mode How the autonomous mode is run.
      */
-    AutonomousChooser(wpi::StringRef name, std::function<void()> func);
+    AutonomousChooser(wpi::StringRef name, std::function<void()> func,
+                      ExecutionMode mode = ExecutionMode::kThread);
 
     ~AutonomousChooser();
 
     /**
      * Adds an autonomous mode.
      *
-     * @param name Name of autonomous mode.
-     * @param func Autonomous mode function.
+     * @param name   Name of autonomous mode.
+     * @param func   Autonomous mode function.
+     * @param warmUp Run by WarmUpSelected() while the mode is selected. May be
+     *               empty.
+     */
+    void AddAutonomous(wpi::StringRef name, std::function<void()> func,
+                       std::function<void()> warmUp = nullptr);
+
+    /**
+     * Adds an autonomous mode that's a command sequence.
+     *
+     * Sequences are advanced by AwaitRunAutonomous() on the main robot thread
+     * regardless of the execution mode, so they never yield.
+     *
+     * @param name     Name of autonomous mode.
+     * @param sequence Autonomous mode sequence.
+     * @param warmUp   Run by WarmUpSelected() while the mode is selected. May
+     *                 be empty.
      */
-    void AddAutonomous(wpi::StringRef name, std::function<void()> func);
+    void AddAutonomous(wpi::StringRef name, AutonomousSequence sequence,
+                       std::function<void()> warmUp = nullptr);
 
     /**
      * Sets the selected autonomous mode for unit testing purposes.
@@ -57,6 +103,22 @@ public:
      */
     const std::vector<std::string>& GetAutonomousNames() const;
 
+    /**
+     * Prepares the selected autonomous mode to run.
+     *
+     * The mode's warm-up runs the computations its first steps need, such as
+     * motion profiles and trajectory tracking, on scratch state so the first
+     * loops of the match run from warm caches like the rest. It doesn't move
+     * anything. The code of the sequences themselves is kept in RAM by
+     * Robot::RobotInit() instead, since running them would.
+     *
+     * The warm-up runs when the selection changes and every kWarmUpPeriod
+     * after that. Call this periodically while the robot is disabled.
+     *
+     * @return True if the warm-up ran.
+     */
+    bool WarmUpSelected();
+
     /**
      * Yield to main robot thread and wait for next chance to run.
      *
@@ -92,30 +154,118 @@ public:
      */
     void EndAutonomous();
 
+    /**
+     * Returns true if an autonomous mode was started and hasn't returned yet.
+     */
+    bool IsAutonomousRunning() const;
+
+    /**
+     * Sets the priority of the autonomous worker thread.
+     *
+     * Returns false if the execution mode has no worker thread or the priority
+     * couldn't be set.
+     *
+     * @param realTime Set to true to use real-time scheduling (SCHED_FIFO).
+     * @param priority Priority from 1 (lowest) to 99 (highest). Only used if
+     *                 realTime is true.
+     */
+    bool SetThreadPriority(bool realTime, int priority);
+
+    /**
+     * Pins the autonomous worker thread to the given CPU core.
+     *
+     * Returns false if the execution mode has no worker thread or the platform
+     * doesn't support setting thread affinity.
+     *
+     * @param cpu Index of the CPU core.
+     */
+    bool SetThreadAffinity(int cpu);
+
     void InitSendable(frc::SendableBuilder& builder) override;
 
 private:
+    ExecutionMode m_executionMode;
+
+    Fiber m_autonFiber;
+
+    // Which thread may run. Only the thread named here touches the robot
+    // while the other waits for the value to change.
+    static constexpr uint32_t kMain = 0;
+    static constexpr uint32_t kAuton = 1;
+    static constexpr uint32_t kExit = 2;
+
     std::thread m_autonThread;
-    wpi::mutex m_mutex;
-    wpi::mutex m_autonMutex;
-    std::unique_lock<wpi::mutex> m_mainLock{m_autonMutex};
-    std::unique_lock<wpi::mutex> m_autonLock{m_autonMutex, std::defer_lock};
-    wpi::condition_variable m_cond;
-    bool m_awaitingAuton = false;
-    bool m_autonRunning = false;
+    std::atomic<uint32_t> m_turn{kMain};
+
+    // When the worker was last handed the turn, for measuring how long it
+    // takes to wake up
+    std::atomic<uint64_t> m_handOffTime{0};
+    std::atomic<bool> m_autonRunning{false};
+
+    // Longer names are truncated when selected
+    static constexpr size_t kMaxNameLength = 63;
+
+    // A name that can be stored in a SeqLock
+    struct Name {
+        std::array<char, kMaxNameLength> chars;
+        size_t length;
+
+        Name() = default;
+        explicit Name(std::string_view name);
+        std::string_view View() const;
+    };
 
     std::string m_defaultChoice;
-    std::string m_selectedChoice;
-    wpi::StringMap<std::function<void()>> m_choices;
+
+    // Written by the NetworkTables listener thread and SelectAutonomous(), and
+    // read by the robot thread and the telemetry publisher
+    SeqLock<Name> m_selectedChoice;
+
+    // An autonomous mode is either a function or a sequence
+    struct Choice {
+        std::function<void()> func;
+        AutonomousSequence sequence;
+        bool isSequence = false;
+        std::function<void()> warmUp;
+    };
+
+    wpi::StringMap<Choice> m_choices;
     std::vector<std::string> m_names;
-    std::function<void()>* m_selectedAuton;
+    Choice* m_selectedAuton;
+
+    // The mode WarmUpSelected() last warmed up and when, in microseconds
+    std::string m_warmedChoice;
+    uint64_t m_lastWarmUpTime = 0;
 
     nt::NetworkTableEntry m_defaultEntry;
     nt::NetworkTableEntry m_optionsEntry;
     nt::NetworkTableEntry m_selectedEntry;
     nt::NetworkTableEntry m_activeEntry;
+    std::string m_publishedActive;
 
     NT_EntryListener m_selectedListenerHandle;
+    TelemetryPublisher::Handle m_publisherHandle;
+
+    /**
+     * Gives control to the given thread and wakes it.
+     */
+    void HandOff(uint32_t turn);
+
+    /**
+     * Blocks until another thread takes control away from the given thread.
+     */
+    void AwaitHandOff(uint32_t turn);
+
+    /**
+     * Runs on the worker thread and executes each started autonomous mode.
+     */
+    void RunWorker();
+
+    /**
+     * Runs on the telemetry publisher thread and mirrors the selection to the
+     * "active" entry.
+     */
+    void PublishActive();
 };
 
 }  // namespace frc3512
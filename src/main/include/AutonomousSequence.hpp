@@ -0,0 +1,254 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <units/time.h>
+
+#include "Arena.hpp"
+
+namespace frc3512 {
+
+/**
+ * An autonomous mode built from composable commands.
+ *
+ * The command tree is described once with the factory functions below, then
+ * flattened into an array when the sequence is constructed. Children of a
+ * group are stored next to each other, so Update() walks the array by index
+ * on the calling thread instead of needing a second thread to block in.
+ *
+ * @code
+ * using Seq = frc3512::AutonomousSequence;
+ * Seq sequence{Seq::Sequential(
+ *     Seq::Instant([=] { elevator.RaiseElevator(height); }),
+ *     Seq::Parallel(
+ *         Seq::WaitUntil([=] { return elevator.AtGoal(); }),
+ *         Seq::Deadline(Seq::Wait(1_s),
+ *                       Seq::Run([=] { drivetrain.Drive(-0.3, 0, false); },
+ *                                [=] { drivetrain.Drive(0, 0, false); }))))};
+ * @endcode
+ */
+class AutonomousSequence {
+public:
+    /**
+     * A node of the command tree. Construct one with the factory functions of
+     * AutonomousSequence.
+     */
+    class Command {
+    public:
+        Command() = default;
+
+    private:
+        friend class AutonomousSequence;
+
+        enum class Type {
+            kInstant,
+            kRun,
+            kWaitUntil,
+            kWait,
+            kSequential,
+            kParallel,
+            kRace,
+            kDeadline
+        };
+
+        Type m_type = Type::kInstant;
+        std::function<void()> m_action;
+        std::function<void()> m_end;
+        std::function<bool()> m_condition;
+        std::function<units::second_t()> m_duration;
+        std::vector<Command> m_children;
+
+        template <typename... Commands>
+        static Command Group(Type type, Commands&&... commands) {
+            Command command;
+            command.m_type = type;
+            (command.m_children.emplace_back(std::forward<Commands>(commands)),
+             ...);
+            return command;
+        }
+    };
+
+    /**
+     * Returns a command that calls a function once and finishes.
+     *
+     * @param action The function.
+     */
+    static Command Instant(std::function<void()> action);
+
+    /**
+     * Returns a command that calls a function every update and never finishes
+     * on its own. Put it in a race or deadline group to stop it.
+     *
+     * @param execute Called every update.
+     * @param end     Called when the command is stopped. May be empty.
+     */
+    static Command Run(std::function<void()> execute,
+                       std::function<void()> end = nullptr);
+
+    /**
+     * Returns a command that finishes once a condition is true.
+     *
+     * The condition is first checked in the update the command starts in.
+     *
+     * @param condition The condition.
+     * @param end       Called when the command finishes or is stopped. May be
+     *                  empty.
+     */
+    static Command WaitUntil(std::function<bool()> condition,
+                             std::function<void()> end = nullptr);
+
+    /**
+     * Returns a command that finishes after a duration.
+     *
+     * @param duration How long to wait.
+     */
+    static Command Wait(units::second_t duration);
+
+    /**
+     * Returns a command that finishes after a duration.
+     *
+     * @param duration Returns how long to wait. It's called when the command
+     *                 starts, so the duration can be tuned after the sequence
+     *                 is built.
+     */
+    static Command Wait(std::function<units::second_t()> duration);
+
+    /**
+     * Returns a command that runs commands one after another.
+     *
+     * A command that finishes immediately lets the next one start in the same
+     * update.
+     */
+    template <typename... Commands>
+    static Command Sequential(Commands&&... commands) {
+        return Command::Group(Command::Type::kSequential,
+                              std::forward<Commands>(commands)...);
+    }
+
+    /**
+     * Returns a command that runs commands at the same time and finishes when
+     * all of them have.
+     */
+    template <typename... Commands>
+    static Command Parallel(Commands&&... commands) {
+        return Command::Group(Command::Type::kParallel,
+                              std::forward<Commands>(commands)...);
+    }
+
+    /**
+     * Returns a command that runs commands at the same time and finishes when
+     * any of them does. The rest are stopped.
+     */
+    template <typename... Commands>
+    static Command Race(Commands&&... commands) {
+        return Command::Group(Command::Type::kRace,
+                              std::forward<Commands>(commands)...);
+    }
+
+    /**
+     * Returns a command that runs commands at the same time and finishes when
+     * the first one does. The rest are stopped.
+     *
+     * @param deadline The command that determines when the group finishes.
+     * @param commands The commands to run alongside it.
+     */
+    template <typename... Commands>
+    static Command Deadline(Command deadline, Commands&&... commands) {
+        return Command::Group(Command::Type::kDeadline, std::move(deadline),
+                              std::forward<Commands>(commands)...);
+    }
+
+    /**
+     * Constructs an empty sequence. It finishes as soon as it's started.
+     */
+    AutonomousSequence() = default;
+
+    /**
+     * Constructs a sequence that runs a command.
+     *
+     * @param command The root of the command tree.
+     */
+    explicit AutonomousSequence(Command command);
+
+    /**
+     * Starts the sequence from the beginning.
+     */
+    void Start();
+
+    /**
+     * Advances the sequence. Call this once per robot loop.
+     *
+     * Returns true if the sequence has finished.
+     */
+    bool Update();
+
+    /**
+     * Stops the sequence and every command that's running.
+     */
+    void Cancel();
+
+    /**
+     * Returns true if the sequence was started and hasn't finished or been
+     * canceled yet.
+     */
+    bool IsRunning() const;
+
+private:
+    enum class Status { kIdle, kRunning, kFinished };
+
+    struct Node {
+        Command::Type type;
+        Status status = Status::kIdle;
+
+        // The children occupy [firstChild, firstChild + numChildren)
+        size_t firstChild = 0;
+        size_t numChildren = 0;
+
+        // Index of the running child of a sequential group
+        size_t current = 0;
+
+        units::second_t startTime = 0_s;
+        units::second_t duration = 0_s;
+
+        std::function<void()> action;
+        std::function<void()> end;
+        std::function<bool()> condition;
+        std::function<units::second_t()> durationSource;
+    };
+
+    // Built once at construction, so the nodes of every sequence are packed
+    // together in the program's arena
+    std::vector<Node, ArenaAllocator<Node>> m_nodes;
+    bool m_running = false;
+    units::second_t m_now = 0_s;
+
+    /**
+     * Returns the number of nodes in a command tree.
+     */
+    static size_t CountNodes(const Command& command);
+
+    /**
+     * Stores a command and its descendants starting at the given node.
+     */
+    void Flatten(Command& command, size_t index);
+
+    /**
+     * Starts the given node if needed and advances it.
+     *
+     * Returns true if it has finished.
+     */
+    bool Step(size_t index);
+
+    /**
+     * Stops the given node and its running descendants.
+     */
+    void Interrupt(size_t index);
+};
+
+}  // namespace frc3512
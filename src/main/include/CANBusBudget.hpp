@@ -0,0 +1,127 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+
+#include <ctre/phoenix/motorcontrol/StatusFrame.h>
+#include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <units/time.h>
+
+/**
+ * Manages Talon SRX status frame periods and estimates CAN bus utilization.
+ *
+ * Every Talon broadcasts all of its status frames at their default rates
+ * unless told otherwise. Subsystems declare the frames they actually read with
+ * RequireStatusFrame(), then SlowUnrequiredFrames() drops everything else to
+ * the slowest rate. The resulting bus load can be printed with Report().
+ */
+class CANBusBudget {
+public:
+    // The slowest period a status frame can be set to
+    static constexpr units::millisecond_t kMaxFramePeriod = 255_ms;
+
+    // Period of the control frame the roboRIO sends to each Talon
+    static constexpr units::millisecond_t kControlFramePeriod = 10_ms;
+
+    // Worst-case length of an extended CAN frame with 8 data bytes, including
+    // bit stuffing
+    static constexpr double kBitsPerFrame = 160.0;
+
+    // The roboRIO's CAN bus bit rate in bits per second
+    static constexpr double kBitRate = 1e6;
+
+    static CANBusBudget& GetInstance();
+
+    CANBusBudget(const CANBusBudget&) = delete;
+    CANBusBudget& operator=(const CANBusBudget&) = delete;
+
+    /**
+     * Sets a status frame's period and records it for the load estimate.
+     *
+     * The call doesn't wait for the Talon to acknowledge the new period.
+     *
+     * @param motor  The Talon.
+     * @param frame  The status frame.
+     * @param period The frame period. It's clamped to kMaxFramePeriod.
+     */
+    void SetStatusFramePeriod(
+        ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced frame,
+        units::millisecond_t period);
+
+    /**
+     * Declares that a status frame must be sent at least as often as the given
+     * period.
+     *
+     * If the frame was already required at a shorter period, the shorter one is
+     * kept. Required frames are never slowed by SlowUnrequiredFrames().
+     *
+     * @param motor  The Talon.
+     * @param frame  The status frame.
+     * @param period The longest acceptable frame period.
+     */
+    void RequireStatusFrame(
+        ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced frame,
+        units::millisecond_t period);
+
+    /**
+     * Sets every status frame of the Talon that hasn't been required to
+     * kMaxFramePeriod.
+     *
+     * @param motor The Talon.
+     */
+    void SlowUnrequiredFrames(
+        ctre::phoenix::motorcontrol::can::TalonSRX& motor);
+
+    /**
+     * Returns the estimated fraction of the CAN bus bandwidth used by the
+     * registered Talons' status and control frames.
+     */
+    double GetEstimatedUtilization() const;
+
+    /**
+     * Prints each Talon's frame rates and the estimated bus utilization.
+     */
+    void Report() const;
+
+private:
+    static constexpr size_t kMaxDevices = 16;
+    static constexpr size_t kNumFrames = 9;
+
+    struct Frame {
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced frame;
+        units::millisecond_t period;
+        bool required = false;
+    };
+
+    struct Device {
+        int deviceID = -1;
+        std::array<Frame, kNumFrames> frames;
+    };
+
+    std::array<Device, kMaxDevices> m_devices;
+
+    CANBusBudget() = default;
+
+    /**
+     * Returns the frame's entry for the Talon, registering the Talon with
+     * default frame periods if it's new.
+     */
+    Frame& GetFrame(ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+                    ctre::phoenix::motorcontrol::StatusFrameEnhanced frame);
+
+    /**
+     * Returns the Talon's entry, registering it with default frame periods if
+     * it's new.
+     */
+    Device& GetDevice(ctre::phoenix::motorcontrol::can::TalonSRX& motor);
+
+    /**
+     * Returns the bits per second sent by and to one Talon.
+     */
+    static double GetBitsPerSecond(const Device& device);
+};
@@ -1,17 +1,29 @@
-// Copyright (c) 2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2020-2021 FRC Team 3512. All Rights Reserved.
 
-#include <ctre/phoenix/motorcontrol/SensorCollection.h>
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
 
+#include "CANSensorSnapshot.hpp"
+
 #pragma once
 
+/**
+ * The reverse limit switch input of a Talon SRX.
+ *
+ * Readings come from the CANSensorSnapshot, so they're updated once per call
+ * to CANSensorSnapshot::Update().
+ */
 class CANDigitalInput {
 public:
     explicit CANDigitalInput(ctre::phoenix::motorcontrol::can::TalonSRX& motor);
 
-    bool Get();
+    ~CANDigitalInput();
+
+    CANDigitalInput(const CANDigitalInput&) = delete;
+    CANDigitalInput& operator=(const CANDigitalInput&) = delete;
+
+    bool Get() const;
 
 private:
     ctre::phoenix::motorcontrol::can::TalonSRX& m_motor;
-    ctre::phoenix::motorcontrol::SensorCollection m_sensor{m_motor};
+    const TalonSRXSensorData& m_sensors;
 };
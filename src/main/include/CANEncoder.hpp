@@ -3,20 +3,99 @@
 #pragma once
 
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <units/time.h>
 
+#include "CANSensorSnapshot.hpp"
+
+/**
+ * A quadrature encoder attached to a Talon SRX.
+ *
+ * Readings come from the CANSensorSnapshot, so they're updated once per call
+ * to CANSensorSnapshot::Update(). They're sampled by the Talon up to a status
+ * frame period before they arrive, so GetTimestamp() estimates when, and
+ * GetDistance(units::second_t) extrapolates the distance from then.
+ */
 class CANEncoder {
 public:
     CANEncoder(ctre::phoenix::motorcontrol::can::TalonSRX& motor,
                double distancePerPulse = 1.0, bool reverseDirection = false);
 
-    double GetDistance();
+    ~CANEncoder();
+
+    CANEncoder(const CANEncoder&) = delete;
+    CANEncoder& operator=(const CANEncoder&) = delete;
+
+    double GetDistance() const;
+
+    /**
+     * Returns the distance extrapolated from the last reading to the given
+     * time at the measured rate.
+     *
+     * The rate is averaged over the Talon's velocity measurement window, so it
+     * lags the distance. The extrapolation is only as good as that over the
+     * age of a reading.
+     *
+     * @param time An FPGA timestamp, usually the current time.
+     */
+    double GetDistance(units::second_t time) const;
+
+    /**
+     * Returns the rate in distance units per second.
+     */
+    double GetRate() const;
 
-    double GetRate();
+    /**
+     * Returns the FPGA timestamp at which the Talon sampled the last reading.
+     *
+     * Phoenix doesn't report when status frames arrive, so this is estimated
+     * from when the reading changed. A reading that hasn't changed for longer
+     * than the frame period is assumed to have been resent by the Talon.
+     */
+    units::second_t GetTimestamp() const;
 
+    /**
+     * Makes the current position zero distance.
+     *
+     * The Talon's count isn't changed, since it wouldn't report the new count
+     * until its next Status_3 frame. The current count is subtracted from the
+     * readings instead.
+     */
     void Reset();
 
+    /**
+     * Returns the position of the Talon's selected sensor at the given
+     * distance. Closed-loop goals on the Talon are in these units.
+     *
+     * @param distance The distance.
+     */
+    double ToSensorPosition(double distance) const;
+
+    /**
+     * Returns how far the Talon's selected sensor moves over the given
+     * distance.
+     *
+     * @param distance The distance.
+     */
+    double ToSensorDistance(double distance) const;
+
+    /**
+     * Returns the velocity of the Talon's selected sensor, in pulses per 100
+     * ms, at the given rate.
+     *
+     * @param rate The rate in distance units per second.
+     */
+    double ToSensorVelocity(double rate) const;
+
 private:
     ctre::phoenix::motorcontrol::can::TalonSRX& m_motor;
+    TalonSRXSensorData& m_sensors;
 
     double m_distancePerPulse;
+
+    // The quadrature position at the last Reset()
+    int m_offset = 0;
+
+    // The sensor phase negates the selected sensor relative to the quadrature
+    // position that GetDistance() reads
+    double m_sensorSign;
 };
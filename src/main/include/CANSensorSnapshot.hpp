@@ -0,0 +1,144 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+
+#include "SignalRecorder.hpp"
+
+/**
+ * Sensor readings from one Talon SRX as of the last
+ * CANSensorSnapshot::Update().
+ */
+struct TalonSRXSensorData {
+    int quadraturePosition = 0;
+    int quadratureVelocity = 0;
+
+    // FPGA time in microseconds at which the quadrature readings last changed.
+    // Phoenix doesn't report when a status frame arrived, so it's taken as
+    // the midpoint between the snapshot that saw the change and the one
+    // before it.
+    uint64_t quadratureTimestamp = 0;
+
+    // FPGA time in microseconds of the snapshot that read these
+    uint64_t snapshotTimestamp = 0;
+
+    bool isFwdLimitSwitchClosed = false;
+    bool isRevLimitSwitchClosed = false;
+};
+
+/**
+ * Caches the sensor readings of every registered Talon SRX once per robot loop.
+ *
+ * Call Update() at the start of each periodic function. Sensor classes like
+ * CANEncoder and CANDigitalInput then read from the cached data, so every
+ * subsystem sees the same readings for the whole loop and each Talon's
+ * SensorCollection is only queried once.
+ *
+ * The raw readings can be recorded to a signal file, and replaced by a source
+ * that plays one back so the robot code can be rerun offline on the readings
+ * from a match.
+ */
+class CANSensorSnapshot {
+public:
+    static constexpr size_t kMaxDevices = 16;
+
+    /**
+     * The raw sensor readings of one Talon.
+     */
+    struct Reading {
+        int quadraturePosition = 0;
+        int quadratureVelocity = 0;
+        bool isFwdLimitSwitchClosed = false;
+        bool isRevLimitSwitchClosed = false;
+    };
+
+    /**
+     * Returns a Talon's readings given its CAN ID.
+     */
+    using ReadingSource = std::function<Reading(int deviceID)>;
+
+    static CANSensorSnapshot& GetInstance();
+
+    CANSensorSnapshot(const CANSensorSnapshot&) = delete;
+    CANSensorSnapshot& operator=(const CANSensorSnapshot&) = delete;
+
+    /**
+     * Adds a Talon to the snapshot.
+     *
+     * Registering the same Talon more than once returns the same data. The
+     * returned reference stays valid until the matching call to Unregister().
+     *
+     * @param motor The Talon whose sensors to read.
+     */
+    TalonSRXSensorData& Register(
+        ctre::phoenix::motorcontrol::can::TalonSRX& motor);
+
+    /**
+     * Removes one registration of a Talon from the snapshot.
+     *
+     * @param motor The Talon passed to Register().
+     */
+    void Unregister(ctre::phoenix::motorcontrol::can::TalonSRX& motor);
+
+    /**
+     * Reads the sensors of every registered Talon.
+     */
+    void Update();
+
+    /**
+     * Reads sensors from a source instead of the Talons.
+     *
+     * Timestamps are still taken from the FPGA clock.
+     *
+     * @param source The source, or nullptr to read the Talons again.
+     */
+    void SetReadingSource(ReadingSource source);
+
+    /**
+     * Starts recording the readings of every Talon registered so far on each
+     * Update().
+     *
+     * Each Talon gets "talon<ID> position", "talon<ID> velocity", and
+     * "talon<ID> limit switches" signals. The limit switch signal has bit 0 set
+     * if the forward switch is closed and bit 1 set if the reverse one is.
+     * Call this once every subsystem is constructed.
+     */
+    void StartRecording();
+
+    /**
+     * Writes the recorded readings to a file in the background.
+     *
+     * @param directory The directory in which to create the file.
+     */
+    void FlushRecording(std::string_view directory);
+
+private:
+    struct Device {
+        ctre::phoenix::motorcontrol::can::TalonSRX* motor = nullptr;
+        int refCount = 0;
+    };
+
+    std::array<Device, kMaxDevices> m_devices;
+    std::array<TalonSRXSensorData, kMaxDevices> m_data;
+
+    // FPGA time in microseconds of the last Update()
+    uint64_t m_lastUpdateTime = 0;
+
+    ReadingSource m_source;
+
+    // The device indices recorded, in signal order
+    std::unique_ptr<frc3512::SignalRecorder> m_recorder;
+    std::array<size_t, kMaxDevices> m_recordedDevices;
+    size_t m_numRecordedDevices = 0;
+
+    CANSensorSnapshot() = default;
+};
@@ -0,0 +1,114 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <ctre/phoenix/motorcontrol/ControlMode.h>
+#include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <units/time.h>
+
+/**
+ * Sends output commands to a Talon SRX only when they change.
+ *
+ * The last commanded mode, value, and auxiliary demand are remembered. A new
+ * command is written if the mode or demand type differs, either value moved by
+ * more than the deadband, or the keep-alive interval has passed since the last
+ * write. Everything else is dropped and counted.
+ */
+class CoalescedTalonOutput {
+public:
+    // Smallest change in value that's written immediately
+    static constexpr double kDefaultDeadband = 1e-3;
+
+    // Longest time a repeated command is suppressed. This is kept below the
+    // default 100 ms motor safety expiration.
+    static constexpr units::millisecond_t kDefaultKeepAlive = 50_ms;
+
+    /**
+     * Constructs a CoalescedTalonOutput.
+     *
+     * @param motor     The Talon to command.
+     * @param deadband  Smallest change in value that's written immediately.
+     * @param keepAlive Longest time a repeated command is suppressed.
+     */
+    explicit CoalescedTalonOutput(
+        ctre::phoenix::motorcontrol::can::TalonSRX& motor,
+        double deadband = kDefaultDeadband,
+        units::millisecond_t keepAlive = kDefaultKeepAlive);
+
+    CoalescedTalonOutput(CoalescedTalonOutput&&) = default;
+    CoalescedTalonOutput& operator=(CoalescedTalonOutput&&) = default;
+
+    /**
+     * Commands the Talon unless the command matches the last one written.
+     *
+     * Returns true if the command was written.
+     *
+     * @param mode  The control mode.
+     * @param value The setpoint for the control mode.
+     */
+    bool Set(ctre::phoenix::motorcontrol::ControlMode mode, double value);
+
+    /**
+     * Commands the Talon with an auxiliary demand unless the command matches
+     * the last one written.
+     *
+     * Returns true if the command was written.
+     *
+     * @param mode        The control mode.
+     * @param value       The setpoint for the control mode.
+     * @param demandType  How the Talon uses the auxiliary demand.
+     * @param demandValue The auxiliary demand.
+     */
+    bool Set(ctre::phoenix::motorcontrol::ControlMode mode, double value,
+             ctre::phoenix::motorcontrol::DemandType demandType,
+             double demandValue);
+
+    /**
+     * Makes the next call to Set() write regardless of the last command.
+     */
+    void Invalidate();
+
+    /**
+     * Returns the number of commands written by this output.
+     */
+    uint64_t GetWriteCount() const;
+
+    /**
+     * Returns the number of commands suppressed by this output.
+     */
+    uint64_t GetSuppressedCount() const;
+
+    /**
+     * Returns the number of commands written by all outputs.
+     */
+    static uint64_t GetTotalWriteCount();
+
+    /**
+     * Returns the number of commands suppressed by all outputs.
+     */
+    static uint64_t GetTotalSuppressedCount();
+
+private:
+    static std::atomic<uint64_t> s_totalWrites;
+    static std::atomic<uint64_t> s_totalSuppressed;
+
+    ctre::phoenix::motorcontrol::can::TalonSRX* m_motor;
+    double m_deadband;
+    uint64_t m_keepAlive;
+
+    ctre::phoenix::motorcontrol::ControlMode m_lastMode;
+    double m_lastValue = 0.0;
+    ctre::phoenix::motorcontrol::DemandType m_lastDemandType;
+    double m_lastDemandValue = 0.0;
+    bool m_hasLastCommand = false;
+
+    // FPGA timestamp of the last write in microseconds
+    uint64_t m_lastWriteTime = 0;
+
+    uint64_t m_writes = 0;
+    uint64_t m_suppressed = 0;
+};
@@ -0,0 +1,12 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <units/time.h>
+
+namespace frc3512::Constants {
+
+// Period of the subsystem controllers run by ControllerScheduler
+constexpr units::second_t kControllerPeriod = 5_ms;
+
+}  // namespace frc3512::Constants
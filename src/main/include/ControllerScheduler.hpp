@@ -0,0 +1,80 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <frc/Notifier.h>
+#include <units/time.h>
+#include <wpi/mutex.h>
+
+#include "Constants.hpp"
+#include "ThreadPolicy.hpp"
+
+namespace frc3512 {
+
+/**
+ * Runs subsystem controllers at a fixed rate independent of the main robot
+ * loop.
+ *
+ * Each tick refreshes the CAN sensor snapshot, then calls every registered
+ * controller in the order it was added. Ticks run on a notifier thread with
+ * the ThreadRole::kControllers policy, so they aren't delayed by driver
+ * station packet handling on the main thread.
+ *
+ * Controllers share state with the main loop. Hold GetMutex() for the whole
+ * body of each periodic function so ticks only run between them.
+ */
+class ControllerScheduler {
+public:
+    /**
+     * Constructs a ControllerScheduler.
+     *
+     * @param period The period at which the controllers run.
+     */
+    explicit ControllerScheduler(
+        units::second_t period = Constants::kControllerPeriod);
+
+    ControllerScheduler(const ControllerScheduler&) = delete;
+    ControllerScheduler& operator=(const ControllerScheduler&) = delete;
+
+    /**
+     * Adds a controller to run every tick.
+     *
+     * @param controller The function that runs the controller once.
+     */
+    void AddController(std::function<void()> controller);
+
+    /**
+     * Starts running the controllers periodically.
+     */
+    void Start();
+
+    /**
+     * Stops running the controllers.
+     */
+    void Stop();
+
+    /**
+     * Returns the period at which the controllers run.
+     */
+    units::second_t GetPeriod() const;
+
+    /**
+     * Returns the mutex held while the controllers run.
+     */
+    wpi::mutex& GetMutex();
+
+private:
+    units::second_t m_period;
+    std::vector<std::function<void()>> m_controllers;
+    wpi::mutex m_mutex;
+    bool m_appliedPolicy = false;
+    WakeupMonitor m_wakeups;
+    frc::Notifier m_notifier{[=] { Tick(); }};
+
+    void Tick();
+};
+
+}  // namespace frc3512
@@ -0,0 +1,78 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace frc3512 {
+
+template <typename Signature, size_t Capacity = sizeof(void*)>
+class Delegate;
+
+/**
+ * A non-allocating replacement for std::function.
+ *
+ * The callable is stored inline in a buffer of Capacity bytes, so constructing,
+ * copying, and calling a Delegate never touches the heap. Only trivially
+ * copyable and destructible callables fit, which covers lambdas that capture
+ * pointers and references such as [this]. Anything larger or with a nontrivial
+ * destructor fails to compile instead of silently allocating.
+ *
+ * @tparam R        Return type.
+ * @tparam Args     Argument types.
+ * @tparam Capacity Size of the inline storage in bytes.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class Delegate<R(Args...), Capacity> {
+public:
+    /**
+     * Constructs an empty Delegate. Calling it is undefined behavior.
+     */
+    Delegate() = default;
+
+    /**
+     * Constructs a Delegate that stores a copy of the given callable.
+     *
+     * @param func The callable.
+     */
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<
+                              std::decay_t<F>, Delegate>>>
+    Delegate(F&& func) {  // NOLINT(runtime/explicit)
+        using Func = std::decay_t<F>;
+        static_assert(sizeof(Func) <= Capacity,
+                      "Callable doesn't fit in the Delegate's inline storage");
+        static_assert(alignof(Func) <= alignof(void*),
+                      "Callable is overaligned for the Delegate's storage");
+        static_assert(std::is_trivially_copyable_v<Func> &&
+                          std::is_trivially_destructible_v<Func>,
+                      "Delegate can only store trivially copyable callables");
+
+        new (m_storage) Func(std::forward<F>(func));
+        m_invoke = [](void* storage, Args... args) -> R {
+            return (*std::launder(static_cast<Func*>(storage)))(
+                std::forward<Args>(args)...);
+        };
+    }
+
+    /**
+     * Calls the stored callable.
+     */
+    R operator()(Args... args) const {
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Returns true if the Delegate stores a callable.
+     */
+    explicit operator bool() const { return m_invoke != nullptr; }
+
+private:
+    alignas(void*) mutable unsigned char m_storage[Capacity] = {};
+    R (*m_invoke)(void*, Args...) = nullptr;
+};
+
+}  // namespace frc3512
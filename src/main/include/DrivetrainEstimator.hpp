@@ -0,0 +1,160 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+
+#include <Eigen/Core>
+#include <frc/system/LinearSystem.h>
+#include <units/angular_velocity.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <units/velocity.h>
+#include <units/voltage.h>
+
+namespace frc3512 {
+
+/**
+ * Estimates the drivetrain's wheel distances and velocities with a Kalman
+ * filter.
+ *
+ * The model is the drivetrain's velocity system driven by the voltages applied
+ * to each side, with the wheel distances integrated from its velocities. The
+ * encoder distances and the gyro's yaw rate correct it. The Talons' velocity
+ * measurements aren't used since they're averaged over 100 ms.
+ *
+ * Encoder distances arrive in CAN status frames, so they describe the wheels at
+ * some time in the past. The filter keeps its recent states, corrects the one
+ * at the time of the measurement, and then replays the inputs and gyro
+ * measurements since then to bring the estimate back to the present.
+ */
+class DrivetrainEstimator {
+public:
+    struct Estimate {
+        units::second_t timestamp = 0_s;
+        units::meter_t leftDistance = 0_m;
+        units::meter_t rightDistance = 0_m;
+        units::meters_per_second_t leftVelocity = 0_mps;
+        units::meters_per_second_t rightVelocity = 0_mps;
+
+        // Counterclockwise yaw rate
+        units::radians_per_second_t angularVelocity = 0_rad_per_s;
+    };
+
+    /**
+     * Constructs a DrivetrainEstimator at rest at zero distance.
+     *
+     * @param plant      The drivetrain's velocity system. Its states are the
+     *                   left and right wheel velocities and its inputs are the
+     *                   left and right voltages.
+     * @param trackWidth The distance between the left and right wheels.
+     */
+    DrivetrainEstimator(const frc::LinearSystem<2, 2, 2>& plant,
+                        units::meter_t trackWidth);
+
+    /**
+     * Discards the estimate and restarts at rest at the given distances.
+     *
+     * @param timestamp     The current time.
+     * @param leftDistance  The left wheel distance.
+     * @param rightDistance The right wheel distance.
+     */
+    void Reset(units::second_t timestamp, units::meter_t leftDistance,
+               units::meter_t rightDistance);
+
+    /**
+     * Advances the estimate to the given time and corrects it with the gyro.
+     *
+     * @param timestamp       The current time.
+     * @param leftVoltage     The voltage applied to the left side since the
+     *                        last call.
+     * @param rightVoltage    The voltage applied to the right side since the
+     *                        last call.
+     * @param angularVelocity The counterclockwise yaw rate from the gyro.
+     */
+    void Update(units::second_t timestamp, units::volt_t leftVoltage,
+                units::volt_t rightVoltage,
+                units::radians_per_second_t angularVelocity);
+
+    /**
+     * Advances the estimate to the given time without a gyro measurement.
+     *
+     * @param timestamp    The current time.
+     * @param leftVoltage  The voltage applied to the left side since the last
+     *                     call.
+     * @param rightVoltage The voltage applied to the right side since the last
+     *                     call.
+     */
+    void Update(units::second_t timestamp, units::volt_t leftVoltage,
+                units::volt_t rightVoltage);
+
+    /**
+     * Corrects the estimate with encoder distances measured in the past.
+     *
+     * Measurements must be passed in the order they were taken, and ones no
+     * newer than the last measurement are ignored so a reading that hasn't
+     * been replaced yet isn't applied twice. Ones older than the states kept
+     * are applied to the oldest one.
+     *
+     * @param timestamp     The time at which the distances were measured.
+     * @param leftDistance  The left encoder distance.
+     * @param rightDistance The right encoder distance.
+     */
+    void CorrectEncoders(units::second_t timestamp, units::meter_t leftDistance,
+                         units::meter_t rightDistance);
+
+    /**
+     * Returns the estimate at the time of the last call to Update().
+     */
+    Estimate GetEstimate() const;
+
+private:
+    // States kept for replaying, which is 80 ms at the controller period
+    static constexpr size_t kHistorySize = 16;
+
+    // Left distance, right distance, left velocity, and right velocity
+    using StateVector = Eigen::Matrix<double, 4, 1>;
+    using StateMatrix = Eigen::Matrix<double, 4, 4>;
+    using InputVector = Eigen::Matrix<double, 2, 1>;
+
+    struct Entry {
+        double timestamp = 0.0;
+        StateVector x = StateVector::Zero();
+        StateMatrix P = StateMatrix::Zero();
+
+        // The input applied from the previous entry until this one
+        InputVector u = InputVector::Zero();
+
+        double angularVelocity = 0.0;
+        bool hasAngularVelocity = false;
+    };
+
+    StateMatrix m_contA;
+    Eigen::Matrix<double, 4, 2> m_contB;
+    double m_trackWidth;
+
+    // Ring buffer of the states at each Update(), newest at m_newest
+    std::array<Entry, kHistorySize> m_history;
+    size_t m_newest = 0;
+    size_t m_size = 0;
+
+    // Time of the last encoder measurement applied
+    double m_lastEncoderTimestamp = 0.0;
+
+    /**
+     * Returns the entry from the given number of updates ago.
+     */
+    Entry& At(size_t age);
+    const Entry& At(size_t age) const;
+
+    void Predict(StateVector& x, StateMatrix& P, const InputVector& u,
+                 double dt) const;
+    void CorrectGyro(StateVector& x, StateMatrix& P,
+                     double angularVelocity) const;
+    void CorrectDistances(StateVector& x, StateMatrix& P, double leftDistance,
+                          double rightDistance) const;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,189 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <frc/RobotController.h>
+
+#include "SPSCQueue.hpp"
+
+namespace frc3512 {
+
+/**
+ * Events that can be logged. The format string of each is in EventLog.cpp.
+ *
+ * Append new events to the end so old logs still decode.
+ */
+enum class Event : uint16_t {
+    kAutonomousStart,
+    kElevatorSeek,
+    kDriveLimited,
+    kNumEvents
+};
+
+/**
+ * One fixed-size log record.
+ *
+ * The format string's replacement fields are filled with the text first, if
+ * any, followed by the arguments.
+ */
+struct EventRecord {
+    static constexpr size_t kMaxArgs = 4;
+    static constexpr size_t kMaxTextLength = 16;
+
+    // FPGA timestamp in microseconds
+    uint64_t timestamp;
+
+    uint16_t event;
+    uint8_t numArgs;
+    uint8_t textLength;
+    uint32_t reserved;
+    double args[kMaxArgs];
+
+    // Not null-terminated
+    char text[kMaxTextLength];
+};
+
+static_assert(sizeof(EventRecord) == 64, "EventRecord layout changed");
+
+/**
+ * A binary event logger that keeps I/O off the control thread.
+ *
+ * The robot thread pushes fixed-size records into a lock-free queue. A
+ * low-priority writer thread appends them to a log file and prints them to the
+ * console.
+ *
+ * The log file starts with a header containing every event's format string,
+ * followed by the records at a fixed offset. Decode it with
+ * tools/decode_event_log.py.
+ *
+ * Only one thread may log events.
+ */
+class EventLog {
+public:
+    // Log file format version. Bump this when the header or EventRecord
+    // changes.
+    static constexpr uint32_t kVersion = 1;
+
+    static constexpr size_t kQueueCapacity = 1024;
+
+    static EventLog& GetInstance();
+
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    /**
+     * Opens a new log file in the given directory and starts the writer
+     * thread.
+     *
+     * Events logged before this are written once it's called.
+     *
+     * @param directory The directory in which to create the log file.
+     * @return True if the log file was opened. Events are still printed if it
+     *         wasn't.
+     */
+    bool Start(std::string_view directory = GetDefaultDirectory());
+
+    /**
+     * Writes the remaining events and stops the writer thread.
+     */
+    void Stop();
+
+    /**
+     * Logs an event with numeric arguments.
+     *
+     * @param event The event.
+     * @param args  The arguments. They're stored as doubles.
+     */
+    template <typename... Args>
+    void Log(Event event, Args... args) {
+        LogText(event, {}, args...);
+    }
+
+    /**
+     * Logs an event with a short string and numeric arguments.
+     *
+     * @param event The event.
+     * @param text  The string. It's truncated to EventRecord::kMaxTextLength
+     *              characters.
+     * @param args  The arguments. They're stored as doubles.
+     */
+    template <typename... Args>
+    void LogText(Event event, std::string_view text, Args... args) {
+        static_assert(sizeof...(Args) <= EventRecord::kMaxArgs,
+                      "Too many event arguments");
+
+        EventRecord record;
+        record.timestamp = frc::RobotController::GetFPGATime();
+        record.event = static_cast<uint16_t>(event);
+        record.numArgs = sizeof...(Args);
+        record.textLength = static_cast<uint8_t>(
+            std::min(text.size(), EventRecord::kMaxTextLength));
+        record.reserved = 0;
+
+        // The trailing zero keeps the array nonempty when there are no
+        // arguments
+        const double values[] = {static_cast<double>(args)..., 0.0};
+        std::copy_n(values, sizeof...(Args), record.args);
+        std::fill(record.args + sizeof...(Args),
+                  record.args + EventRecord::kMaxArgs, 0.0);
+        std::memcpy(record.text, text.data(), record.textLength);
+
+        if (!m_queue.Push(record)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Returns the number of events dropped because the queue was full.
+     */
+    uint64_t GetDroppedCount() const;
+
+    /**
+     * Returns the format string of the given event.
+     *
+     * @param event The event.
+     */
+    static const char* GetFormat(Event event);
+
+    /**
+     * Returns the directory logs are written to by default.
+     *
+     * On the roboRIO, this is a USB drive mounted at /u if one is present and
+     * /home/lvuser otherwise. Elsewhere, it's the working directory.
+     */
+    static std::string GetDefaultDirectory();
+
+private:
+    SPSCQueue<EventRecord, kQueueCapacity> m_queue;
+    std::atomic<uint64_t> m_dropped{0};
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::FILE* m_file = nullptr;
+
+    EventLog() = default;
+
+    void WriteHeader();
+
+    /**
+     * Writes and prints every queued event.
+     */
+    void Drain();
+
+    void RunWriter();
+};
+
+}  // namespace frc3512
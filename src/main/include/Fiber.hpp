@@ -0,0 +1,81 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace frc3512 {
+
+/**
+ * A user-space execution context with its own stack.
+ *
+ * A fiber runs a function cooperatively on the thread that resumes it. Control
+ * only changes hands when the fiber calls Yield() or its function returns, so
+ * switching between the caller and the fiber costs a register save/restore
+ * instead of a kernel scheduler wakeup.
+ *
+ * The stack is allocated once at construction and reused by every function
+ * started on the fiber.
+ */
+class Fiber {
+public:
+    static constexpr size_t kDefaultStackSize = 256 * 1024;
+
+    /**
+     * Constructs a Fiber.
+     *
+     * @param stackSize Size of the fiber's stack in bytes.
+     */
+    explicit Fiber(size_t stackSize = kDefaultStackSize);
+
+    ~Fiber();
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    /**
+     * Starts running a function on the fiber.
+     *
+     * This returns when the function calls Yield() or returns. The previous
+     * function must have finished before a new one is started.
+     *
+     * @param func The function to run.
+     */
+    void Start(std::function<void()> func);
+
+    /**
+     * Switches from the caller to the fiber.
+     *
+     * This returns when the fiber's function calls Yield() or returns. If the
+     * function exited with an exception, it's rethrown here.
+     */
+    void Resume();
+
+    /**
+     * Switches from the fiber back to the thread that resumed it.
+     *
+     * This function should only be called by the fiber's function.
+     */
+    void Yield();
+
+    /**
+     * Returns true if a function has been started and hasn't returned yet.
+     */
+    bool IsRunning() const;
+
+private:
+    struct Context;
+    friend struct Context;
+
+    std::unique_ptr<Context> m_context;
+    std::function<void()> m_func;
+    std::exception_ptr m_exception;
+    bool m_running = false;
+
+    [[noreturn]] void Run();
+};
+
+}  // namespace frc3512
@@ -0,0 +1,143 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+namespace frc3512 {
+
+namespace detail {
+
+/**
+ * True for argument types that fmt formats without allocating: numbers,
+ * characters, and strings. Types with custom or ostream formatters are
+ * excluded since those usually format through a std::string.
+ */
+template <typename T, typename U = std::remove_cv_t<std::remove_reference_t<T>>>
+inline constexpr bool kIsFixedFormatArg =
+    std::is_arithmetic_v<U> || std::is_same_v<U, const char*> ||
+    std::is_same_v<U, char*> || std::is_same_v<U, std::string_view> ||
+    std::is_same_v<U, std::string> ||
+    (std::is_array_v<U> && std::is_same_v<std::remove_extent_t<U>, char>) ||
+    (std::is_array_v<U> &&
+     std::is_same_v<std::remove_extent_t<U>, const char>);
+
+template <typename S>
+inline constexpr bool kIsCompiledFormat =
+    fmt::detail::is_compiled_string<S>::value;
+
+}  // namespace detail
+
+/**
+ * Text formatted into a fixed-capacity buffer that lives wherever the
+ * FixedString does, usually the stack.
+ *
+ * Text past the capacity is cut off. Use this, FormatFixed(), and PrintFixed()
+ * instead of fmt::format() and fmt::print() for messages from robot code,
+ * since those parse the format string at runtime and allocate.
+ *
+ * @tparam N The capacity in characters, not counting the null terminator.
+ */
+template <size_t N>
+class FixedString {
+public:
+    static constexpr size_t kCapacity = N;
+
+    /**
+     * Replaces the contents with formatted text.
+     *
+     * The format string must be wrapped in FMT_COMPILE() so it's parsed at
+     * compile time, and every argument must be a number, character, or
+     * string, so formatting never allocates.
+     *
+     * @param format The format string.
+     * @param args   The arguments.
+     */
+    template <typename S, typename... Args>
+    void Format(const S& format, const Args&... args) {
+        static_assert(detail::kIsCompiledFormat<S>,
+                      "Wrap the format string in FMT_COMPILE()");
+        static_assert((detail::kIsFixedFormatArg<Args> && ...),
+                      "Fixed formatting only accepts numbers, characters, and "
+                      "strings, since other types may allocate");
+
+        auto result = fmt::format_to_n(m_data.data(), N, format, args...);
+        m_size = std::min(result.size, N);
+        m_truncated = result.size > N;
+        m_data[m_size] = '\0';
+    }
+
+    /**
+     * Returns the text.
+     */
+    std::string_view View() const { return {m_data.data(), m_size}; }
+
+    /**
+     * Returns the text as a null-terminated string.
+     */
+    const char* CStr() const { return m_data.data(); }
+
+    /**
+     * Returns true if the last Format() was cut off at the capacity.
+     */
+    bool IsTruncated() const { return m_truncated; }
+
+private:
+    std::array<char, N + 1> m_data{};
+    size_t m_size = 0;
+    bool m_truncated = false;
+};
+
+/**
+ * Formats text into a FixedString. See FixedString::Format().
+ *
+ * @tparam N The capacity of the returned string.
+ */
+template <size_t N, typename S, typename... Args>
+FixedString<N> FormatFixed(const S& format, const Args&... args) {
+    FixedString<N> text;
+    text.Format(format, args...);
+    return text;
+}
+
+// Capacity of the buffer PrintFixed() formats into
+inline constexpr size_t kPrintFixedCapacity = 256;
+
+/**
+ * Prints formatted text to a stream without allocating. See
+ * FixedString::Format(). Text is cut off at kPrintFixedCapacity characters.
+ *
+ * @param file   The stream.
+ * @param format The format string.
+ * @param args   The arguments.
+ */
+template <typename S, typename... Args>
+void PrintFixed(std::FILE* file, const S& format, const Args&... args) {
+    FixedString<kPrintFixedCapacity> text;
+    text.Format(format, args...);
+    std::fwrite(text.CStr(), 1, text.View().size(), file);
+}
+
+/**
+ * Prints formatted text to stdout without allocating. See
+ * FixedString::Format(). Text is cut off at kPrintFixedCapacity characters.
+ *
+ * @param format The format string.
+ * @param args   The arguments.
+ */
+template <typename S, typename... Args>
+void PrintFixed(const S& format, const Args&... args) {
+    PrintFixed(stdout, format, args...);
+}
+
+}  // namespace frc3512
@@ -0,0 +1,30 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace frc3512 {
+
+/**
+ * Blocks the calling thread while the atomic word equals the expected value.
+ *
+ * This may return spuriously, so callers should recheck the word in a loop. On
+ * Linux, this sleeps in the kernel via futex(2). Other platforms yield the
+ * thread until the value changes.
+ *
+ * @param word     The atomic word to wait on.
+ * @param expected The value to wait on the word changing from.
+ */
+void FutexWait(std::atomic<uint32_t>& word, uint32_t expected);
+
+/**
+ * Wakes one thread blocked in FutexWait() on the atomic word.
+ *
+ * @param word The atomic word to wake a waiter on.
+ */
+void FutexWakeOne(std::atomic<uint32_t>& word);
+
+}  // namespace frc3512
@@ -0,0 +1,105 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace frc3512 {
+
+/**
+ * The buttons, POV hat, and X and Y axes of one joystick as of the last
+ * Update().
+ *
+ * frc::Joystick asks the driver station for each button and axis on every
+ * call. Instead, call Update() once at the start of each robot loop. It reads
+ * the whole button bitmask and the rest of the state once, and finds the
+ * buttons pressed since the previous Update() by comparing bitmasks, so the
+ * rest of the loop reads cached values and can skip button handling entirely
+ * when nothing was pressed.
+ *
+ * A press and release within one loop is missed, but the driver station only
+ * sends new joystick data once per loop anyway.
+ */
+class JoystickSnapshot {
+public:
+    /**
+     * Constructs a JoystickSnapshot.
+     *
+     * @param port The driver station port of the joystick.
+     */
+    explicit JoystickSnapshot(int port);
+
+    /**
+     * Reads the joystick's state from the driver station.
+     */
+    void Update();
+
+    /**
+     * Returns the driver station port of the joystick.
+     */
+    int GetPort() const { return m_port; }
+
+    /**
+     * Returns a bitmask of the buttons held down, with button 1 in bit 0.
+     */
+    uint32_t GetButtons() const { return m_buttons; }
+
+    /**
+     * Returns a bitmask of the buttons pressed since the previous Update(),
+     * with button 1 in bit 0.
+     */
+    uint32_t GetPressedButtons() const { return m_pressed; }
+
+    /**
+     * Returns true if a button is held down.
+     *
+     * @param button The button, starting at 1.
+     */
+    bool GetButton(int button) const {
+        return (m_buttons & ButtonMask(button)) != 0;
+    }
+
+    /**
+     * Returns the angle of the POV hat in degrees, or -1 if it isn't pressed.
+     */
+    int GetPOV() const { return m_pov; }
+
+    /**
+     * Returns the X axis in [-1..1].
+     */
+    double GetX() const { return m_x; }
+
+    /**
+     * Returns the Y axis in [-1..1].
+     */
+    double GetY() const { return m_y; }
+
+    /**
+     * Returns the FPGA time in microseconds of the last Update().
+     *
+     * This is when the loop first saw the state, which can be up to a loop
+     * after the driver station received it.
+     */
+    uint64_t GetTimestamp() const { return m_timestamp; }
+
+    /**
+     * Returns the bit for a button in the button bitmasks.
+     *
+     * @param button The button, starting at 1.
+     */
+    static constexpr uint32_t ButtonMask(int button) {
+        return uint32_t{1} << (button - 1);
+    }
+
+private:
+    int m_port;
+
+    uint32_t m_buttons = 0;
+    uint32_t m_pressed = 0;
+    int m_pov = -1;
+    double m_x = 0.0;
+    double m_y = 0.0;
+    uint64_t m_timestamp = 0;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,134 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+
+#include "LoopProfiler.hpp"
+
+namespace frc3512 {
+
+/**
+ * Measures how long driver inputs take to become actuator commands.
+ *
+ * An input is traced by running its handler inside a Scope stamped with the
+ * time the input was read. Code that writes an output directly from the
+ * handler records the latency on the spot with RecordCurrent(). Code that
+ * acts later, such as a queued command or a controller tick, saves
+ * GetCurrentInputTime() with the request and passes it to Record() when the
+ * output is finally written.
+ *
+ * Each output keeps a LoopProfiler histogram of its latencies, so the cost is
+ * a few relaxed atomic increments per traced input.
+ */
+class LatencyTracer {
+public:
+    /**
+     * The points an input's latency is measured to.
+     */
+    enum class Output {
+        // A new lift motion profile was planned for the input
+        kLiftGoal,
+
+        // The lift controller sent the first voltage toward that goal
+        kLift,
+
+        // The tine, intake arm, intake stow and container grabber solenoids
+        // switched
+        kTines,
+        kIntakeArms,
+        kIntakeStow,
+        kContainerGrabber
+    };
+
+    static constexpr size_t kNumOutputs = 6;
+
+    /**
+     * Marks the inputs handled during its lifetime as read at a given time.
+     *
+     * Scopes may nest. The innermost one applies.
+     */
+    class Scope {
+    public:
+        /**
+         * Constructs a Scope.
+         *
+         * @param inputTime The FPGA time in microseconds the input was read.
+         */
+        explicit Scope(uint64_t inputTime);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        uint64_t m_previous;
+    };
+
+    static LatencyTracer& GetInstance();
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    /**
+     * Returns the input time of the calling thread's innermost Scope, or 0 if
+     * it isn't in one.
+     */
+    static uint64_t GetCurrentInputTime();
+
+    /**
+     * Records the latency from an input to now.
+     *
+     * @param output    The output that was written.
+     * @param inputTime The FPGA time in microseconds the input was read. Zero
+     *                  means the output wasn't caused by a traced input, and
+     *                  nothing is recorded.
+     */
+    void Record(Output output, uint64_t inputTime);
+
+    /**
+     * Records the latency from the calling thread's current input to now, if
+     * it's in a Scope.
+     *
+     * @param output The output that was written.
+     */
+    void RecordCurrent(Output output) {
+        Record(output, GetCurrentInputTime());
+    }
+
+    /**
+     * Returns the latency histogram of an output.
+     *
+     * @param output The output.
+     */
+    const LoopProfiler::Section& GetLatency(Output output) const {
+        return *m_sections[static_cast<size_t>(output)];
+    }
+
+    /**
+     * Returns the latency of each output. Pass it to
+     * frc::SmartDashboard::PutData() to publish the statistics.
+     */
+    LoopProfiler& GetProfiler();
+
+    /**
+     * Prints the latency of each output that has recorded any.
+     */
+    void Report() const;
+
+    /**
+     * Clears the recorded latencies.
+     */
+    void Reset();
+
+private:
+    LoopProfiler m_latencies;
+    std::array<LoopProfiler::Section*, kNumOutputs> m_sections;
+
+    LatencyTracer();
+};
+
+}  // namespace frc3512
@@ -0,0 +1,195 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#include <frc/RobotController.h>
+#include <frc/smartdashboard/Sendable.h>
+#include <frc/smartdashboard/SendableBuilder.h>
+#include <frc/smartdashboard/SendableHelper.h>
+#include <units/time.h>
+
+namespace frc3512 {
+
+/**
+ * Records how long sections of the robot loop take.
+ *
+ * Each section keeps a histogram of its durations in log-spaced buckets with
+ * four buckets per power of two, so percentiles are accurate to within 25%.
+ * Recording is a handful of relaxed atomic increments and never locks or
+ * allocates, so it's cheap enough to leave on in competition.
+ *
+ * Sections may be recorded from any thread. Pass the profiler to
+ * frc::SmartDashboard::PutData() to publish the statistics to NetworkTables.
+ */
+class LoopProfiler : public frc::Sendable,
+                     public frc::SendableHelper<LoopProfiler> {
+public:
+    static constexpr size_t kMaxSections = 16;
+
+    /**
+     * Duration histogram for one section.
+     */
+    class Section {
+    public:
+        // 4 linear buckets below 4 us, then 4 buckets per power of two up to
+        // 2^32 us
+        static constexpr size_t kNumBuckets = 4 + 4 * 30;
+
+        /**
+         * Records one run of the section.
+         *
+         * @param duration The duration in microseconds.
+         */
+        void Record(uint64_t duration) {
+            uint32_t us = duration > UINT32_MAX
+                              ? UINT32_MAX
+                              : static_cast<uint32_t>(duration);
+
+            m_buckets[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+
+            uint32_t min = m_min.load(std::memory_order_relaxed);
+            while (us < min && !m_min.compare_exchange_weak(
+                                   min, us, std::memory_order_relaxed)) {
+            }
+            uint32_t max = m_max.load(std::memory_order_relaxed);
+            while (us > max && !m_max.compare_exchange_weak(
+                                   max, us, std::memory_order_relaxed)) {
+            }
+
+            if (m_budget != 0 && us > m_budget) {
+                m_overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Returns the name of the section.
+         */
+        const std::string& GetName() const;
+
+        /**
+         * Returns the number of recorded runs.
+         */
+        uint32_t GetCount() const;
+
+        /**
+         * Returns the number of runs that took longer than the budget.
+         */
+        uint32_t GetOverruns() const;
+
+        /**
+         * Returns the shortest recorded run.
+         */
+        units::second_t GetMin() const;
+
+        /**
+         * Returns the longest recorded run.
+         */
+        units::second_t GetMax() const;
+
+        /**
+         * Returns the upper bound of the bucket containing the given
+         * percentile, clamped to the longest run.
+         *
+         * @param percentile The percentile in the range [0, 1].
+         */
+        units::second_t GetPercentile(double percentile) const;
+
+        /**
+         * Clears the recorded runs.
+         */
+        void Reset();
+
+    private:
+        friend class LoopProfiler;
+
+        std::string m_name;
+        uint32_t m_budget = 0;
+        std::array<std::atomic<uint32_t>, kNumBuckets> m_buckets{};
+        std::atomic<uint32_t> m_count{0};
+        std::atomic<uint32_t> m_overruns{0};
+        std::atomic<uint32_t> m_min{UINT32_MAX};
+        std::atomic<uint32_t> m_max{0};
+
+        static constexpr size_t BucketIndex(uint32_t us) {
+            if (us < 4) {
+                return us;
+            }
+
+            // Index of the most significant set bit
+            int exponent = 31 - __builtin_clz(us);
+            return 4 * (exponent - 1) + ((us >> (exponent - 2)) & 3);
+        }
+
+        static constexpr uint64_t BucketUpperBound(size_t index) {
+            if (index < 4) {
+                return index;
+            }
+
+            size_t exponent = index / 4 + 1;
+            uint64_t lower = (4 + index % 4) << (exponent - 2);
+            return lower + (uint64_t{1} << (exponent - 2)) - 1;
+        }
+    };
+
+    /**
+     * Measures the lifetime of the object and records it to a section.
+     */
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Section& section)
+            : m_section{section},
+              m_start{frc::RobotController::GetFPGATime()} {}
+
+        ~ScopedTimer() {
+            m_section.Record(frc::RobotController::GetFPGATime() - m_start);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Section& m_section;
+        uint64_t m_start;
+    };
+
+    /**
+     * Adds a section to the profiler.
+     *
+     * Sections must be added before any are recorded. The returned reference
+     * is valid for the lifetime of the profiler.
+     *
+     * @param name   The name of the section.
+     * @param budget The time the section should finish within. Runs which
+     *               exceed it are counted as overruns. Zero disables the
+     *               check.
+     * @throws std::length_error if kMaxSections sections were already added.
+     */
+    Section& AddSection(std::string_view name, units::second_t budget = 0_s);
+
+    /**
+     * Prints the statistics of every section that has recorded a run.
+     */
+    void Print() const;
+
+    /**
+     * Clears the recorded runs of every section.
+     */
+    void Reset();
+
+    void InitSendable(frc::SendableBuilder& builder) override;
+
+private:
+    std::array<Section, kMaxSections> m_sections;
+    size_t m_numSections = 0;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,307 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <frc/trajectory/TrapezoidProfile.h>
+#include <units/time.h>
+
+namespace frc3512 {
+
+/**
+ * Several profiled PID controllers that share constraints and are calculated
+ * together.
+ *
+ * Each channel behaves like a frc::ProfiledPIDController: a trapezoid profile
+ * moves its setpoint toward its goal and a PID controller tracks the setpoint.
+ * Instead of regenerating the profile every Calculate(), the phase boundaries
+ * are computed once when the goal or setpoint is set, and each channel's
+ * setpoint is evaluated from them at the time since.
+ *
+ * State is stored as one array per field, and Calculate() updates every
+ * channel in branch-free loops over those arrays so the compiler can vectorize
+ * them.
+ *
+ * @tparam N        The number of channels.
+ * @tparam Distance The unit of distance.
+ */
+template <size_t N, class Distance>
+class MultiProfiledPIDController {
+public:
+    using Profile = frc::TrapezoidProfile<Distance>;
+    using Distance_t = typename Profile::Distance_t;
+    using Velocity_t = typename Profile::Velocity_t;
+    using Constraints = typename Profile::Constraints;
+    using State = typename Profile::State;
+
+    struct Gains {
+        double kP = 0.0;
+        double kI = 0.0;
+        double kD = 0.0;
+    };
+
+    /**
+     * Constructs a MultiProfiledPIDController with every channel at rest at
+     * zero.
+     *
+     * @param gains       The PID gains of each channel.
+     * @param constraints The profile constraints of every channel.
+     * @param period      The period between calls to Calculate().
+     */
+    MultiProfiledPIDController(const std::array<Gains, N>& gains,
+                               const Constraints& constraints,
+                               units::second_t period = 20_ms)
+        : m_maxVelocity{constraints.maxVelocity.template to<double>()},
+          m_maxAcceleration{constraints.maxAcceleration.template to<double>()},
+          m_period{period.to<double>()} {
+        for (size_t i = 0; i < N; ++i) {
+            m_kP[i] = gains[i].kP;
+            m_kI[i] = gains[i].kI;
+            m_kD[i] = gains[i].kD;
+            m_goal[i] = 0.0;
+            Reset(i, Distance_t{0});
+        }
+    }
+
+    /**
+     * Returns the PID gains of a channel.
+     *
+     * @param channel The channel.
+     */
+    Gains GetGains(size_t channel) const {
+        return {m_kP[channel], m_kI[channel], m_kD[channel]};
+    }
+
+    /**
+     * Sets the tolerances that AtSetpoint() and AtGoal() use for every
+     * channel.
+     *
+     * @param positionTolerance The position error tolerance.
+     * @param velocityTolerance The velocity error tolerance.
+     */
+    void SetTolerance(Distance_t positionTolerance,
+                      Velocity_t velocityTolerance = Velocity_t{
+                          std::numeric_limits<double>::infinity()}) {
+        m_positionTolerance = positionTolerance.template to<double>();
+        m_velocityTolerance = velocityTolerance.template to<double>();
+    }
+
+    /**
+     * Sets a channel's goal and plans its profile from the current setpoint.
+     *
+     * @param channel The channel.
+     * @param goal    The position to stop at.
+     */
+    void SetGoal(size_t channel, Distance_t goal) {
+        m_goal[channel] = goal.template to<double>();
+        Plan(channel);
+    }
+
+    /**
+     * Returns a channel's goal.
+     *
+     * @param channel The channel.
+     */
+    Distance_t GetGoal(size_t channel) const {
+        return Distance_t{m_goal[channel]};
+    }
+
+    /**
+     * Returns a channel's setpoint as of the last Calculate().
+     *
+     * @param channel The channel.
+     */
+    State GetSetpoint(size_t channel) const {
+        return {Distance_t{m_setpointPosition[channel]},
+                Velocity_t{m_setpointVelocity[channel]}};
+    }
+
+    /**
+     * Returns true if a channel's error was within tolerance at the last
+     * Calculate().
+     *
+     * @param channel The channel.
+     */
+    bool AtSetpoint(size_t channel) const {
+        return std::abs(m_positionError[channel]) < m_positionTolerance &&
+               std::abs(m_velocityError[channel]) < m_velocityTolerance;
+    }
+
+    /**
+     * Returns true if a channel's setpoint has reached its goal and its error
+     * is within tolerance.
+     *
+     * @param channel The channel.
+     */
+    bool AtGoal(size_t channel) const {
+        return AtSetpoint(channel) &&
+               m_setpointPosition[channel] == m_goal[channel] &&
+               m_setpointVelocity[channel] == 0.0;
+    }
+
+    /**
+     * Moves a channel's setpoint to a measurement at rest, clears its PID
+     * state, and replans its profile to the goal.
+     *
+     * @param channel     The channel.
+     * @param measurement The measured position.
+     */
+    void Reset(size_t channel, Distance_t measurement) {
+        double position = measurement.template to<double>();
+        m_setpointPosition[channel] = position;
+        m_setpointVelocity[channel] = 0.0;
+        m_positionError[channel] = 0.0;
+        m_velocityError[channel] = 0.0;
+        m_totalError[channel] = 0.0;
+        Plan(channel);
+    }
+
+    /**
+     * Advances every channel's setpoint by one period and returns the PID
+     * outputs.
+     *
+     * @param measurements The measured position of each channel.
+     */
+    std::array<double, N> Calculate(
+        const std::array<Distance_t, N>& measurements) {
+        for (size_t i = 0; i < N; ++i) {
+            m_time[i] += m_period;
+        }
+
+        // Evaluate the profiles. Every phase is computed and the current one
+        // selected so the loop doesn't branch per channel.
+        for (size_t i = 0; i < N; ++i) {
+            double t = m_time[i];
+            double a = m_acceleration[i];
+
+            double accelT = std::fmin(t, m_endAccel[i]);
+            double accelPosition =
+                m_startPosition[i] + (m_startVelocity[i] + accelT * a / 2.0) *
+                                         accelT;
+            double accelVelocity = m_startVelocity[i] + accelT * a;
+
+            double cruisePosition =
+                m_endAccelPosition[i] +
+                m_cruiseVelocity[i] * (std::fmin(t, m_endCruise[i]) -
+                                       m_endAccel[i]);
+
+            double timeLeft = std::fmax(m_endDecel[i] - t, 0.0);
+            double decelPosition =
+                m_goal[i] - m_direction[i] * timeLeft * timeLeft *
+                                m_maxAcceleration / 2.0;
+            double decelVelocity =
+                m_direction[i] * timeLeft * m_maxAcceleration;
+
+            bool accelerating = t < m_endAccel[i];
+            bool cruising = t < m_endCruise[i];
+            m_setpointPosition[i] = accelerating
+                                        ? accelPosition
+                                        : cruising ? cruisePosition
+                                                   : decelPosition;
+            m_setpointVelocity[i] = accelerating
+                                        ? accelVelocity
+                                        : cruising ? m_cruiseVelocity[i]
+                                                   : decelVelocity;
+        }
+
+        // Run the PID controllers
+        std::array<double, N> outputs;
+        for (size_t i = 0; i < N; ++i) {
+            double error = m_setpointPosition[i] -
+                           measurements[i].template to<double>();
+            m_velocityError[i] = (error - m_positionError[i]) / m_period;
+            m_positionError[i] = error;
+            m_totalError[i] += error * m_period;
+
+            outputs[i] = m_kP[i] * error + m_kI[i] * m_totalError[i] +
+                         m_kD[i] * m_velocityError[i];
+        }
+        return outputs;
+    }
+
+private:
+    double m_maxVelocity;
+    double m_maxAcceleration;
+    double m_period;
+
+    double m_positionTolerance = 0.05;
+    double m_velocityTolerance = std::numeric_limits<double>::infinity();
+
+    std::array<double, N> m_kP;
+    std::array<double, N> m_kI;
+    std::array<double, N> m_kD;
+
+    std::array<double, N> m_goal;
+    std::array<double, N> m_setpointPosition;
+    std::array<double, N> m_setpointVelocity;
+
+    std::array<double, N> m_positionError;
+    std::array<double, N> m_velocityError;
+    std::array<double, N> m_totalError;
+
+    // Each profile, planned by Plan(). Times are since the profile started and
+    // the acceleration and cruise velocity are signed toward the goal.
+    std::array<double, N> m_time;
+    std::array<double, N> m_direction;
+    std::array<double, N> m_startPosition;
+    std::array<double, N> m_startVelocity;
+    std::array<double, N> m_acceleration;
+    std::array<double, N> m_cruiseVelocity;
+    std::array<double, N> m_endAccel;
+    std::array<double, N> m_endAccelPosition;
+    std::array<double, N> m_endCruise;
+    std::array<double, N> m_endDecel;
+
+    /**
+     * Plans a channel's trapezoid profile from its setpoint to its goal.
+     *
+     * This follows frc::TrapezoidProfile for a goal at rest.
+     */
+    void Plan(size_t channel) {
+        double position = m_setpointPosition[channel];
+        double direction = position > m_goal[channel] ? -1.0 : 1.0;
+
+        // Plan in the direction of the goal, where positions increase
+        double initialVelocity =
+            std::fmin(direction * m_setpointVelocity[channel], m_maxVelocity);
+        double distance = direction * (m_goal[channel] - position);
+
+        double cutoffBegin = initialVelocity / m_maxAcceleration;
+        double cutoffDistBegin =
+            cutoffBegin * cutoffBegin * m_maxAcceleration / 2.0;
+        double fullTrapezoidDist = cutoffDistBegin + distance;
+
+        double accelerationTime = m_maxVelocity / m_maxAcceleration;
+        double fullSpeedDist = fullTrapezoidDist - accelerationTime *
+                                                       accelerationTime *
+                                                       m_maxAcceleration;
+        if (fullSpeedDist < 0.0) {
+            accelerationTime = std::sqrt(fullTrapezoidDist / m_maxAcceleration);
+            fullSpeedDist = 0.0;
+        }
+
+        double endAccel = accelerationTime - cutoffBegin;
+        m_time[channel] = 0.0;
+        m_direction[channel] = direction;
+        m_startPosition[channel] = position;
+        m_startVelocity[channel] = direction * initialVelocity;
+        m_acceleration[channel] = direction * m_maxAcceleration;
+        m_cruiseVelocity[channel] =
+            direction * (initialVelocity + endAccel * m_maxAcceleration);
+        m_endAccel[channel] = endAccel;
+        m_endAccelPosition[channel] =
+            position + direction *
+                           (initialVelocity + endAccel * m_maxAcceleration /
+                                                  2.0) *
+                           endAccel;
+        m_endCruise[channel] = endAccel + fullSpeedDist / m_maxVelocity;
+        m_endDecel[channel] = m_endCruise[channel] + accelerationTime;
+    }
+};
+
+}  // namespace frc3512
@@ -0,0 +1,113 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <frc/PowerDistributionPanel.h>
+#include <units/current.h>
+#include <units/time.h>
+#include <units/voltage.h>
+
+#include "TelemetryPublisher.hpp"
+
+/**
+ * Samples the battery voltage and PDP current once per robot loop and limits
+ * the drive before the battery sags into a brownout.
+ *
+ * Call Update() at the start of each periodic function. Outputs that need the
+ * battery voltage read the sample instead of querying the HAL on every call.
+ *
+ * The voltage is extrapolated along its recent slope to predict where it will
+ * be a couple of loops from now. As the prediction falls from
+ * kLimitStartVoltage to kLimitFullVoltage, GetDriveScale() falls from 1 to
+ * kMinDriveScale. The lift isn't limited, so stacking keeps its speed while
+ * the drive gives up current. The scale drops as soon as the prediction does
+ * and recovers at kRecoveryRate so the limit doesn't oscillate.
+ */
+class PowerMonitor {
+public:
+    // The roboRIO disables motor outputs below this
+    static constexpr units::volt_t kBrownoutVoltage = 6.8_V;
+
+    static constexpr units::volt_t kLimitStartVoltage = 8.5_V;
+    static constexpr units::volt_t kLimitFullVoltage = 7.5_V;
+    static constexpr double kMinDriveScale = 0.25;
+
+    // How far ahead the voltage is predicted
+    static constexpr units::second_t kLookahead = 40_ms;
+
+    // Time constant of the filter on the voltage's slope
+    static constexpr units::second_t kSlopeTimeConstant = 40_ms;
+
+    // How fast the drive scale returns to 1 in units per second
+    static constexpr double kRecoveryRate = 1.0;
+
+    static PowerMonitor& GetInstance();
+
+    PowerMonitor(const PowerMonitor&) = delete;
+    PowerMonitor& operator=(const PowerMonitor&) = delete;
+
+    /**
+     * Samples the battery voltage and PDP current and updates the drive scale.
+     */
+    void Update();
+
+    /**
+     * Returns the battery voltage as of the last Update().
+     *
+     * Before the first Update(), this is 12 V.
+     */
+    units::volt_t GetBatteryVoltage() const {
+        return units::volt_t{m_voltage.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * Returns the total current drawn through the PDP as of the last Update().
+     */
+    units::ampere_t GetTotalCurrent() const;
+
+    /**
+     * Returns the battery voltage predicted kLookahead after the last
+     * Update().
+     */
+    units::volt_t GetPredictedVoltage() const;
+
+    /**
+     * Returns the fraction of its commanded output the drive may apply.
+     */
+    double GetDriveScale() const {
+        return m_driveScale.load(std::memory_order_relaxed);
+    }
+
+private:
+    frc::PowerDistributionPanel m_pdp;
+
+    // Written by Update() and read from any thread
+    std::atomic<double> m_voltage{12.0};
+    std::atomic<double> m_current{0.0};
+    std::atomic<double> m_predictedVoltage{12.0};
+    std::atomic<double> m_driveScale{1.0};
+
+    // Owned by Update()
+    uint64_t m_lastTimestamp = 0;
+    double m_slope = 0.0;
+    bool m_limited = false;
+
+    // Indices of the telemetry fields
+    enum TelemetryField : size_t {
+        kVoltage,
+        kCurrent,
+        kPredictedVoltage,
+        kDriveScale
+    };
+
+    frc3512::TelemetrySource m_telemetry{
+        "Power",
+        {"Battery voltage (V)", "Total current (A)", "Predicted voltage (V)",
+         "Drive scale"}};
+
+    PowerMonitor() = default;
+};
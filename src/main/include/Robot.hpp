@@ -2,48 +2,258 @@
 
 #pragma once
 
-#include <frc/Joystick.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include <frc/TimedRobot.h>
+#include <networktables/NetworkTableEntry.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <wpi/StringRef.h>
 
+#include "AllocationTracker.hpp"
 #include "AutonomousChooser.hpp"
+#include "AutonomousSequence.hpp"
+#include "Constants.hpp"
+#include "ControllerScheduler.hpp"
+#include "JoystickSnapshot.hpp"
+#include "LoopProfiler.hpp"
+#include "SignalRecorder.hpp"
+#include "StartupProfiler.hpp"
+#include "ThreadPolicy.hpp"
+#include "TrajectoryCache.hpp"
 #include "subsystems/Drivetrain.hpp"
 #include "subsystems/Elevator.hpp"
 
+/**
+ * Drive commands and durations for each step of AutoOneTote().
+ *
+ * Powers are in the units of Drivetrain::Drive(). The defaults are the values
+ * used in competition; the simulation parameter sweep overrides them.
+ */
+struct AutoOneToteConfig {
+    // Move to tote
+    double approachPower = -0.3;
+    units::second_t approachTime = 1_s;
+
+    // Autostack
+    units::second_t intakeTime = 1_s;
+
+    // Turn
+    double turnThrottle = -0.3;
+    double turnRate = -0.3;
+    units::second_t turnTime = 1_s;
+
+    // Run away
+    double retreatPower = -0.3;
+    units::second_t retreatTime = 3_s;
+};
+
 /**
  * Implements the main robot class
  */
 class Robot : public frc::TimedRobot {
 public:
+    // The driver inputs TeleopPeriodic() reads and the outputs it commands, in
+    // the order they're recorded to the "teleop" signal file. The replay tool
+    // feeds the recorded inputs back in and compares the outputs. Buttons are
+    // bitmasks with button 1 in bit 0.
+    static constexpr std::array<std::string_view, 9> kTeleopInputSignals{
+        "driveStick1 y",      "driveStick2 x",      "driveStick2 buttons",
+        "driveStick2 pov",    "appendageStick y",   "appendageStick buttons",
+        "appendageStick pov", "pipelined stacking", "battery voltage"};
+    static constexpr std::array<std::string_view, 9> kTeleopOutputSignals{
+        "left output",    "right output",  "elevator goal",
+        "manual mode",    "stacking",      "elevator grabbed",
+        "intake grabbed", "intake stowed", "container grabbed"};
+
+    // Each startup checkpoint times the members declared since the previous
+    // one
+    frc3512::StartupProfiler::Checkpoint programStartup{
+        "Static and HAL initialization"};
     Drivetrain drivetrain;
+    frc3512::StartupProfiler::Checkpoint drivetrainStartup{"Drivetrain"};
     Elevator elevator;
+    frc3512::StartupProfiler::Checkpoint elevatorStartup{"Elevator"};
+
+    AutoOneToteConfig autoOneToteConfig;
 
     Robot();
+    ~Robot() override;
+
+    void RobotInit() override;
+    void DisabledInit() override;
+    void DisabledPeriodic() override;
+    void TeleopInit() override;
     void TeleopPeriodic() override;
     void AutonomousInit() override;
     void AutonomousPeriodic() override;
+    void SimulationPeriodic() override;
+
+    /**
+     * Selects the autonomous mode run by AutonomousInit() for unit testing
+     * purposes.
+     *
+     * @param name Name of autonomous mode.
+     */
+    void SelectAutonomous(wpi::StringRef name);
+
+    /**
+     * Returns a list of selectable autonomous modes for unit testing purposes.
+     */
+    const std::vector<std::string>& GetAutonomousNames() const;
+
+    /**
+     * Returns true if the autonomous mode started by AutonomousInit() hasn't
+     * returned yet.
+     */
+    bool IsAutonomousRunning() const;
+
+    /**
+     * Returns the current value of each of kTeleopOutputSignals.
+     */
+    std::array<float, kTeleopOutputSignals.size()> GetTeleopOutputs() const;
+
+    // The autonomous modes below return their command trees, which the
+    // constructor builds into sequences once
 
     // Drives forward
-    void AutoDriveForward();
+    frc3512::AutonomousSequence::Command AutoDriveForward();
 
     // Seeks elevator to ground to reset its encoders
-    void AutoResetElevator();
+    frc3512::AutonomousSequence::Command AutoResetElevator();
 
-    // Drives forward and picks up one can
-    void AutoOneCanCenter();
+    // Picks up one can and drives forward while lifting it
+    frc3512::AutonomousSequence::Command AutoOneCanCenter();
 
-    // Drives forward and picks up one can
-    void AutoOneCanLeft();
+    // Picks up one can and drives forward while lifting it
+    frc3512::AutonomousSequence::Command AutoOneCanLeft();
 
-    // Drives forward and picks up one can
-    void AutoOneCanRight();
+    // Picks up one can
+    frc3512::AutonomousSequence::Command AutoOneCanRight();
 
     // Drives forward and picks up one tote
-    void AutoOneTote();
+    frc3512::AutonomousSequence::Command AutoOneTote();
+
+    // Drives forward along a trajectory
+    frc3512::AutonomousSequence::Command AutoDriveForwardTrajectory();
+
+    /**
+     * Adds the trajectories followed by the autonomous modes to a cache.
+     *
+     * The trajectory generator tool calls this to generate the trajectory files
+     * deployed with the robot program.
+     *
+     * @param cache The trajectory cache.
+     */
+    static void AddTrajectories(frc3512::TrajectoryCache& cache);
 
 private:
-    frc::Joystick driveStick1{0};
-    frc::Joystick driveStick2{1};
-    frc::Joystick appendageStick{2};
+    // Updated at the start of TeleopPeriodic()
+    frc3512::JoystickSnapshot driveStick1{0};
+    frc3512::JoystickSnapshot driveStick2{1};
+    frc3512::JoystickSnapshot appendageStick{2};
+
+    // Loaded at construction so no trajectories are generated during a match
+    frc3512::TrajectoryCache trajectories;
+
+    frc3512::AutonomousChooser autonChooser{
+        "No-op", [] {}, frc3512::AutonomousChooser::ExecutionMode::kFiber};
+    frc3512::StartupProfiler::Checkpoint autonChooserStartup{
+        "Joysticks and AutonomousChooser"};
+
+    // Enough samples for a 150 s match plus margin at the robot loop rate
+    static constexpr size_t kTeleopRecorderCapacity =
+        static_cast<size_t>(180.0 / kDefaultPeriod.to<double>());
+    frc3512::SignalRecorder teleopRecorder;
+
+    // The "Pipelined stacking" dashboard setting. An NT listener stores it so
+    // the robot loop doesn't take the NetworkTables lock to read it.
+    std::atomic<bool> pipelinedStacking{false};
+    nt::NetworkTableEntry pipelinedStackingEntry;
+    NT_EntryListener pipelinedStackingListener;
+
+    frc3512::WakeupMonitor mainLoopWakeups{frc3512::ThreadRole::kMainLoop,
+                                           kDefaultPeriod};
+
+    frc3512::LoopProfiler loopProfiler;
+    frc3512::LoopProfiler::Section& teleopSection =
+        loopProfiler.AddSection("TeleopPeriodic", kDefaultPeriod);
+    frc3512::LoopProfiler::Section& autonSection =
+        loopProfiler.AddSection("AutonomousPeriodic", kDefaultPeriod);
+    frc3512::LoopProfiler::Section& autonRunSection =
+        loopProfiler.AddSection("AwaitRunAutonomous", kDefaultPeriod);
+    frc3512::LoopProfiler::Section& elevatorStateSection =
+        loopProfiler.AddSection("Elevator::UpdateState", kDefaultPeriod);
+    frc3512::LoopProfiler::Section& elevatorControllerSection =
+        loopProfiler.AddSection("Elevator::UpdateController",
+                                frc3512::Constants::kControllerPeriod);
+    frc3512::LoopProfiler::Section& drivetrainControllerSection =
+        loopProfiler.AddSection("Drivetrain::UpdateControllers",
+                                frc3512::Constants::kControllerPeriod);
+
+    // Heap allocations in the robot loop, reported when the robot is disabled
+    frc3512::AllocationTracker::Site& teleopAllocations =
+        frc3512::AllocationTracker::GetInstance().AddSite("TeleopPeriodic");
+    frc3512::AllocationTracker::Site& autonAllocations =
+        frc3512::AllocationTracker::GetInstance().AddSite("AutonomousPeriodic");
+    frc3512::AllocationTracker::Site& controllerAllocations =
+        frc3512::AllocationTracker::GetInstance().AddSite("Controllers");
+
+    /**
+     * Returns a command that moves the elevator to a height and finishes when
+     * it gets there.
+     *
+     * @param height The elevator height.
+     */
+    frc3512::AutonomousSequence::Command ElevatorTo(units::meter_t height);
+
+    /**
+     * Returns a command that moves the elevator to a tuned height and finishes
+     * when it gets there.
+     *
+     * The height is read when the command starts.
+     *
+     * @param height The elevator height.
+     */
+    frc3512::AutonomousSequence::Command ElevatorTo(
+        const frc3512::Tunable<units::inch_t>& height);
+
+    /**
+     * Returns a command that drives for a duration, then stops the drivetrain.
+     *
+     * @param duration    How long to drive.
+     * @param throttle    Passed to Drivetrain::Drive().
+     * @param turn        Passed to Drivetrain::Drive().
+     * @param isQuickTurn Passed to Drivetrain::Drive().
+     */
+    frc3512::AutonomousSequence::Command DriveFor(units::second_t duration,
+                                                  double throttle, double turn,
+                                                  bool isQuickTurn);
+
+    /**
+     * Returns a command that calls a drive function every update for a
+     * duration, then stops the drivetrain.
+     *
+     * @param duration Returns how long to drive when the command starts.
+     * @param drive    Commands the drivetrain.
+     */
+    frc3512::AutonomousSequence::Command DriveFor(
+        std::function<units::second_t()> duration, std::function<void()> drive);
+
+    /**
+     * Returns a command that follows a trajectory from the cache and finishes
+     * when it ends.
+     *
+     * @param name Name of the trajectory. It must already be loaded.
+     */
+    frc3512::AutonomousSequence::Command FollowTrajectory(
+        std::string_view name);
 
-    frc3512::AutonomousChooser autonChooser{"No-op", [] {}};
+    // Declared last so it stops before the subsystems it runs are destroyed
+    frc3512::ControllerScheduler controllerScheduler;
 };
@@ -0,0 +1,319 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <units/time.h>
+
+namespace frc3512 {
+
+/**
+ * A jerk-limited ("S-curve") motion profile.
+ *
+ * Unlike frc::TrapezoidProfile, acceleration ramps at a bounded jerk instead of
+ * stepping, so the feedforward voltage is continuous and the mechanism isn't
+ * jolted at the start and end of each move. The profile can start from any
+ * position, velocity, and acceleration, so a new goal can be planned from the
+ * current setpoint of a profile that's still running. It always ends at rest
+ * at the goal.
+ *
+ * The profile is planned once at construction as a list of constant-jerk
+ * phases along with the state at the start of each. Calculate() only finds the
+ * current phase and evaluates a cubic.
+ *
+ * @tparam Distance The unit of distance.
+ */
+template <class Distance>
+class SCurveProfile {
+public:
+    using Distance_t = units::unit_t<Distance>;
+    using Velocity =
+        units::compound_unit<Distance, units::inverse<units::seconds>>;
+    using Velocity_t = units::unit_t<Velocity>;
+    using Acceleration =
+        units::compound_unit<Velocity, units::inverse<units::seconds>>;
+    using Acceleration_t = units::unit_t<Acceleration>;
+    using Jerk =
+        units::compound_unit<Acceleration, units::inverse<units::seconds>>;
+    using Jerk_t = units::unit_t<Jerk>;
+
+    /**
+     * Limits on the profile's motion. All of them must be positive.
+     */
+    struct Constraints {
+        Velocity_t maxVelocity{0};
+        Acceleration_t maxAcceleration{0};
+        Jerk_t maxJerk{0};
+
+        bool operator==(const Constraints& rhs) const {
+            return maxVelocity == rhs.maxVelocity &&
+                   maxAcceleration == rhs.maxAcceleration &&
+                   maxJerk == rhs.maxJerk;
+        }
+
+        bool operator!=(const Constraints& rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    struct State {
+        Distance_t position{0};
+        Velocity_t velocity{0};
+        Acceleration_t acceleration{0};
+    };
+
+    /**
+     * Constructs a profile that stays at rest at zero.
+     */
+    SCurveProfile() = default;
+
+    /**
+     * Constructs a profile.
+     *
+     * @param constraints The limits on the profile's motion.
+     * @param goal        The position to stop at.
+     * @param initial     The state to start from.
+     */
+    SCurveProfile(const Constraints& constraints, Distance_t goal,
+                  const State& initial = State{}) {
+        m_maxVelocity = constraints.maxVelocity.template to<double>();
+        m_maxAcceleration = constraints.maxAcceleration.template to<double>();
+        m_maxJerk = constraints.maxJerk.template to<double>();
+        m_goal = goal.template to<double>();
+
+        m_end = {initial.position.template to<double>(),
+                 initial.velocity.template to<double>(),
+                 initial.acceleration.template to<double>()};
+
+        // Ramp the initial acceleration to zero so the rest of the profile is
+        // built from velocity changes that start and end without acceleration
+        if (m_end.a != 0.0) {
+            AddPhase(std::abs(m_end.a) / m_maxJerk,
+                     m_end.a > 0.0 ? -m_maxJerk : m_maxJerk);
+        }
+
+        double direction = m_goal >= m_end.p ? 1.0 : -1.0;
+        double distance = direction * (m_goal - m_end.p);
+        double velocity = direction * m_end.v;
+
+        // If the mechanism can't stop before passing the goal, stop as quickly
+        // as possible, then come back
+        if (velocity > 0.0 &&
+            velocity / 2.0 * VelocityChangeTime(velocity) > distance) {
+            AddVelocityChange(m_end.v, 0.0);
+            direction = m_goal >= m_end.p ? 1.0 : -1.0;
+            distance = direction * (m_goal - m_end.p);
+            velocity = 0.0;
+        }
+
+        double peak = FindPeakVelocity(distance, velocity);
+        double cruiseTime = 0.0;
+        if (peak > 0.0) {
+            cruiseTime = (distance - MoveDistance(velocity, peak)) / peak;
+        }
+
+        AddVelocityChange(m_end.v, direction * peak);
+        AddPhase(cruiseTime, 0.0);
+        AddVelocityChange(m_end.v, 0.0);
+    }
+
+    /**
+     * Returns the state of the profile at the given time.
+     *
+     * @param t Time since the start of the profile.
+     */
+    State Calculate(units::second_t t) const {
+        double time = t.to<double>();
+        if (time >= m_totalTime) {
+            return {Distance_t{m_goal}, Velocity_t{0}, Acceleration_t{0}};
+        }
+
+        size_t i = 0;
+        while (i + 1 < m_numPhases && m_phases[i + 1].startTime <= time) {
+            ++i;
+        }
+
+        const auto& phase = m_phases[i];
+        auto state = Integrate(phase.start, phase.jerk,
+                               std::max(time - phase.startTime, 0.0));
+        return {Distance_t{state.p}, Velocity_t{state.v},
+                Acceleration_t{state.a}};
+    }
+
+    /**
+     * Returns the total duration of the profile.
+     */
+    units::second_t TotalTime() const { return units::second_t{m_totalTime}; }
+
+    /**
+     * Returns true if the profile is at its goal at the given time.
+     *
+     * @param t Time since the start of the profile.
+     */
+    bool IsFinished(units::second_t t) const { return t >= TotalTime(); }
+
+    /**
+     * Returns the time from the start of the profile until its position first
+     * reaches the target, or TotalTime() if it never does.
+     *
+     * @param target The position.
+     */
+    units::second_t TimeLeftUntil(Distance_t target) const {
+        double position = target.template to<double>();
+
+        for (size_t i = 0; i < m_numPhases; ++i) {
+            const auto& phase = m_phases[i];
+            double end = i + 1 < m_numPhases ? m_phases[i + 1].startTime
+                                             : m_totalTime;
+            double duration = end - phase.startTime;
+
+            double before = phase.start.p - position;
+            double after = Integrate(phase.start, phase.jerk, duration).p -
+                           position;
+            if (before == 0.0) {
+                return units::second_t{phase.startTime};
+            }
+            if ((before < 0.0) == (after < 0.0)) {
+                continue;
+            }
+
+            // Bisect for the crossing within the phase
+            double low = 0.0;
+            double high = duration;
+            for (int iteration = 0; iteration < 40; ++iteration) {
+                double mid = (low + high) / 2.0;
+                double error =
+                    Integrate(phase.start, phase.jerk, mid).p - position;
+                if ((error < 0.0) == (before < 0.0)) {
+                    low = mid;
+                } else {
+                    high = mid;
+                }
+            }
+            return units::second_t{phase.startTime + high};
+        }
+
+        return TotalTime();
+    }
+
+private:
+    // Worst case is an acceleration ramp, a stop, and a full seven-phase move
+    static constexpr size_t kMaxPhases = 1 + 3 + 7;
+
+    struct RawState {
+        double p = 0.0;
+        double v = 0.0;
+        double a = 0.0;
+    };
+
+    struct Phase {
+        double startTime = 0.0;
+        double jerk = 0.0;
+        RawState start;
+    };
+
+    std::array<Phase, kMaxPhases> m_phases;
+    size_t m_numPhases = 0;
+    double m_totalTime = 0.0;
+
+    double m_maxVelocity = 0.0;
+    double m_maxAcceleration = 0.0;
+    double m_maxJerk = 0.0;
+    double m_goal = 0.0;
+
+    // The state at the end of the last phase added
+    RawState m_end;
+
+    static RawState Integrate(const RawState& state, double jerk, double t) {
+        return {state.p + state.v * t + state.a * t * t / 2.0 +
+                    jerk * t * t * t / 6.0,
+                state.v + state.a * t + jerk * t * t / 2.0,
+                state.a + jerk * t};
+    }
+
+    void AddPhase(double duration, double jerk) {
+        if (duration <= 0.0) {
+            return;
+        }
+
+        m_phases[m_numPhases++] = {m_totalTime, jerk, m_end};
+        m_end = Integrate(m_end, jerk, duration);
+        m_totalTime += duration;
+    }
+
+    /**
+     * Returns the duration of a velocity change that starts and ends without
+     * acceleration.
+     */
+    double VelocityChangeTime(double change) const {
+        change = std::abs(change);
+        if (change * m_maxJerk >= m_maxAcceleration * m_maxAcceleration) {
+            return change / m_maxAcceleration + m_maxAcceleration / m_maxJerk;
+        } else {
+            return 2.0 * std::sqrt(change / m_maxJerk);
+        }
+    }
+
+    /**
+     * Returns the distance covered while changing from the initial velocity to
+     * the peak velocity and then stopping.
+     */
+    double MoveDistance(double initial, double peak) const {
+        return (initial + peak) / 2.0 * VelocityChangeTime(peak - initial) +
+               peak / 2.0 * VelocityChangeTime(peak);
+    }
+
+    /**
+     * Returns the highest velocity toward the goal that can be reached from the
+     * initial velocity while still stopping at the goal.
+     */
+    double FindPeakVelocity(double distance, double initial) const {
+        if (MoveDistance(initial, m_maxVelocity) <= distance) {
+            return m_maxVelocity;
+        }
+
+        // MoveDistance() increases with the peak velocity, and stopping from
+        // the initial velocity never passes the goal here. A peak below zero
+        // would move away from the goal.
+        double feasible =
+            initial > m_maxVelocity ? initial : std::max(initial, 0.0);
+        double infeasible = m_maxVelocity;
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            double mid = (feasible + infeasible) / 2.0;
+            if (MoveDistance(initial, mid) <= distance) {
+                feasible = mid;
+            } else {
+                infeasible = mid;
+            }
+        }
+        return feasible;
+    }
+
+    /**
+     * Adds the phases that change the velocity without acceleration at either
+     * end.
+     */
+    void AddVelocityChange(double from, double to) {
+        double change = to - from;
+        double jerk = change >= 0.0 ? m_maxJerk : -m_maxJerk;
+        change = std::abs(change);
+
+        if (change * m_maxJerk >= m_maxAcceleration * m_maxAcceleration) {
+            double rampTime = m_maxAcceleration / m_maxJerk;
+            AddPhase(rampTime, jerk);
+            AddPhase(change / m_maxAcceleration - rampTime, 0.0);
+            AddPhase(rampTime, -jerk);
+        } else {
+            double rampTime = std::sqrt(change / m_maxJerk);
+            AddPhase(rampTime, jerk);
+            AddPhase(rampTime, -jerk);
+        }
+    }
+};
+
+}  // namespace frc3512
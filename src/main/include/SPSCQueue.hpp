@@ -0,0 +1,99 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+
+namespace frc3512 {
+
+/**
+ * A bounded, lock-free queue for one producer thread and one consumer thread.
+ *
+ * Push() and Pop() never block or allocate. Each side caches the other side's
+ * index so it only touches the other side's cache line when the queue looks
+ * full or empty.
+ *
+ * @tparam T        The element type.
+ * @tparam Capacity The maximum number of elements. It must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SPSCQueue {
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SPSCQueue capacity must be a power of two");
+
+    /**
+     * Appends an element to the queue.
+     *
+     * This function should only be called by the producer thread. 'true' is
+     * returned if the element was added and 'false' if the queue was full.
+     *
+     * @param value The element.
+     */
+    bool Push(const T& value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache == Capacity) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache == Capacity) {
+                return false;
+            }
+        }
+
+        m_buffer[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest element from the queue.
+     *
+     * This function should only be called by the consumer thread. 'true' is
+     * returned if an element was removed and 'false' if the queue was empty.
+     *
+     * @param value Set to the removed element.
+     */
+    bool Pop(T& value) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache) {
+                return false;
+            }
+        }
+
+        value = m_buffer[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns the number of elements in the queue.
+     *
+     * The result is only a snapshot if the other thread is active.
+     */
+    size_t Size() const {
+        return m_tail.load(std::memory_order_acquire) -
+               m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    // The producer's and consumer's indices are kept on separate cache lines
+    // so they don't false share. 64 bytes covers the Cortex-A9's 32-byte lines
+    // as well as desktop processors.
+    static constexpr size_t kCacheLineSize = 64;
+
+    // Written by the producer
+    alignas(kCacheLineSize) std::atomic<size_t> m_tail{0};
+    size_t m_headCache = 0;
+
+    // Written by the consumer
+    alignas(kCacheLineSize) std::atomic<size_t> m_head{0};
+    size_t m_tailCache = 0;
+
+    alignas(kCacheLineSize) std::array<T, Capacity> m_buffer;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,101 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace frc3512 {
+
+/**
+ * A value that's written by one thread at a time and read without locking.
+ *
+ * Writers bump a sequence number to odd, copy the value, then bump it back to
+ * even. Readers copy the value and retry if the sequence number was odd or
+ * changed while they copied, so they never see a torn value and never make a
+ * writer wait. Concurrent writers wait for each other.
+ *
+ * The value is stored as atomic words so the copies aren't data races.
+ *
+ * @tparam T The value type. It must be trivially copyable.
+ */
+template <typename T>
+class SeqLock {
+public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SeqLock values must be trivially copyable");
+
+    SeqLock() : SeqLock(T{}) {}
+
+    explicit SeqLock(const T& value) { Store(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /**
+     * Replaces the value.
+     *
+     * @param value The new value.
+     */
+    void Store(const T& value) {
+        uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        while ((seq & 1) != 0 ||
+               !m_seq.compare_exchange_weak(seq, seq + 1,
+                                            std::memory_order_acquire)) {
+            if ((seq & 1) != 0) {
+                std::this_thread::yield();
+                seq = m_seq.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::array<uint64_t, kWords> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Returns the value.
+     */
+    T Load() const {
+        std::array<uint64_t, kWords> words;
+        uint32_t seq;
+        do {
+            seq = m_seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 ||
+                 seq != m_seq.load(std::memory_order_relaxed));
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+    /**
+     * Returns a number that changes every time the value is replaced.
+     */
+    uint32_t GetVersion() const {
+        return m_seq.load(std::memory_order_acquire) & ~uint32_t{1};
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+    std::atomic<uint32_t> m_seq{0};
+    std::array<std::atomic<uint64_t>, kWords> m_words;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,143 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <units/time.h>
+
+#include "Constants.hpp"
+
+namespace frc3512 {
+
+/**
+ * Records controller signals every tick into preallocated memory.
+ *
+ * Samples are stored column-wise, one array per signal plus one of timestamps,
+ * so Record() is a few stores with no allocation. When the robot is disabled,
+ * Flush() hands the samples to a background thread that writes them to a
+ * binary file and starts recording into a second set of columns. Decode the
+ * file with tools/decode_signal_log.py.
+ *
+ * Record() and Flush() must not run concurrently.
+ */
+class SignalRecorder {
+public:
+    // Enough samples for a 150 s match plus margin at the controller rate
+    static constexpr size_t kDefaultCapacity = static_cast<size_t>(
+        180.0 / Constants::kControllerPeriod.to<double>());
+
+    // Signal file format version. Bump this when the layout changes.
+    static constexpr uint32_t kVersion = 1;
+
+    /**
+     * Constructs a SignalRecorder and allocates all its storage.
+     *
+     * @param name     The name of the recorder. It's used in the file name.
+     * @param signals  The names of the signals.
+     * @param capacity The maximum number of samples between flushes.
+     */
+    SignalRecorder(std::string_view name,
+                   std::initializer_list<std::string_view> signals,
+                   size_t capacity = kDefaultCapacity);
+
+    /**
+     * Constructs a SignalRecorder whose signals are only known at runtime.
+     *
+     * @param name     The name of the recorder. It's used in the file name.
+     * @param signals  The names of the signals.
+     * @param capacity The maximum number of samples between flushes.
+     */
+    SignalRecorder(std::string_view name, std::vector<std::string> signals,
+                   size_t capacity = kDefaultCapacity);
+
+    ~SignalRecorder();
+
+    SignalRecorder(const SignalRecorder&) = delete;
+    SignalRecorder& operator=(const SignalRecorder&) = delete;
+
+    /**
+     * Records one sample of every signal.
+     *
+     * Samples past the capacity are dropped.
+     *
+     * @param values The signal values, in the order the signals were given to
+     *               the constructor.
+     */
+    void Record(std::initializer_list<float> values);
+
+    /**
+     * Records one sample of every signal.
+     *
+     * Samples past the capacity are dropped.
+     *
+     * @param values The signal values, in the order the signals were given to
+     *               the constructor.
+     * @param count  The number of values. It must equal the number of signals.
+     */
+    void Record(const float* values, size_t count);
+
+    /**
+     * Writes the recorded samples to a file in the background.
+     *
+     * Recording continues into a second buffer. Nothing happens if there are
+     * no samples or the previous flush is still writing.
+     *
+     * @param directory The directory in which to create the file.
+     * @return True if a flush was started.
+     */
+    bool Flush(std::string_view directory);
+
+    /**
+     * Returns the number of samples recorded since the last flush.
+     */
+    size_t GetSize() const;
+
+    /**
+     * Returns the number of samples dropped because the buffer was full.
+     */
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct Buffer {
+        // Microseconds since the first sample of the buffer. 32 bits covers
+        // over an hour.
+        std::vector<uint32_t> timestamps;
+
+        // One column per signal
+        std::vector<std::vector<float>> columns;
+
+        uint64_t startTime = 0;
+        size_t size = 0;
+    };
+
+    std::string m_name;
+    std::vector<std::string> m_signals;
+    size_t m_capacity;
+
+    std::array<Buffer, 2> m_buffers;
+    size_t m_active = 0;
+    uint64_t m_dropped = 0;
+
+    std::thread m_writer;
+    std::atomic<bool> m_writing{false};
+
+    /**
+     * Writes a buffer to a file.
+     *
+     * @param buffer   The buffer.
+     * @param filename The file's name.
+     */
+    void Write(Buffer& buffer, const char* filename);
+};
+
+}  // namespace frc3512
@@ -0,0 +1,70 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace frc3512 {
+
+/**
+ * Records how long each step of robot program startup takes.
+ *
+ * Each checkpoint records the time since the previous one, so placing one
+ * after each member of Robot times that member's constructor. The first
+ * checkpoint is timed from static initialization of the program.
+ *
+ * Startup is single-threaded, so this doesn't lock.
+ */
+class StartupProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * A checkpoint that's recorded when it's constructed, for use as a class
+     * member between the members being timed.
+     */
+    class Checkpoint {
+    public:
+        /**
+         * Records a checkpoint.
+         *
+         * @param name What ran since the previous checkpoint.
+         */
+        explicit Checkpoint(std::string_view name);
+    };
+
+    static StartupProfiler& GetInstance();
+
+    StartupProfiler(const StartupProfiler&) = delete;
+    StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+    /**
+     * Records the time since the previous checkpoint.
+     *
+     * @param name What ran since the previous checkpoint.
+     */
+    void Record(std::string_view name);
+
+    /**
+     * Prints each step's duration and the total, then clears them so the next
+     * report starts from the last checkpoint.
+     */
+    void Report();
+
+private:
+    struct Step {
+        std::string name;
+        Clock::duration duration;
+    };
+
+    Clock::time_point m_start;
+    Clock::time_point m_last;
+    std::vector<Step> m_steps;
+
+    StartupProfiler();
+};
+
+}  // namespace frc3512
@@ -1,39 +1,37 @@
-// Copyright (c) 2015-2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
 #pragma once
 
-#include <functional>
-#include <string>
-#include <string_view>
+#include <optional>
+
+#include "Delegate.hpp"
 
 /**
  * Defines State in StateMachine class
+ *
+ * The callbacks are stored inline, so each may capture at most one pointer
+ * (e.g., [this]). On the roboRIO, a State is 32 bytes, which is one Cortex-A9
+ * L1 cache line.
+ *
+ * @tparam EnumT The enum type that identifies the state machine's states.
  */
+template <typename EnumT>
 class State {
 public:
-    explicit State(std::string_view name) : m_name{name} {}
-
-    State(State&&) = default;
-    State& operator=(State&&) = default;
-
-    const std::string& Name() const { return m_name; }
-
     // entry() is run when the state is first transitioned to.
-    std::function<void()> entry = [] {};
+    frc3512::Delegate<void()> entry = [] {};
 
     /* transition() transitions the state of the state machine to the state
-     * which has the name returned. If "" is returned, the current state will be
+     * returned. If std::nullopt is returned, the current state will be
      * maintained.
      */
-    std::function<std::string()> transition = [] { return ""; };
+    frc3512::Delegate<std::optional<EnumT>()> transition = [] {
+        return std::optional<EnumT>{};
+    };
 
     // run() is run while the state machine is in that state.
-    std::function<void()> run = [] {};
+    frc3512::Delegate<void()> run = [] {};
 
     // std::exit() is run when the state is being transitioned away from.
-    std::function<void()> exit = [] {};
-
-private:
-    // Contains the name of the state
-    std::string m_name;
+    frc3512::Delegate<void()> exit = [] {};
 };
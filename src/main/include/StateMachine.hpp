@@ -1,45 +1,369 @@
-// Copyright (c) 2015-2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <cassert>
+#include <optional>
+#include <stdexcept>
 #include <string>
-#include <utility>
-#include <vector>
+#include <string_view>
+
+#include <frc/RobotController.h>
+#include <frc/smartdashboard/Sendable.h>
+#include <frc/smartdashboard/SendableBuilder.h>
+#include <frc/smartdashboard/SendableHelper.h>
+#include <units/time.h>
 
 #include "State.hpp"
 
-/* The default state is "IDLE". States that end the state machine should return
- * "IDLE" from transition(). Call run() periodically to operate the state
- * machine
+/* States are identified by the values of an enum class whose last enumerator
+ * is kNumStates. Transitions are resolved by indexing an array with the enum
+ * value, so Run() never searches or allocates. Call Validate() after all states
+ * are added and Run() periodically to operate the state machine.
+ *
+ * A state machine can be added as a state of another one. Entering the parent
+ * state enters the child's initial state, running it runs the child, and
+ * leaving it exits the child's current state.
+ */
+
+/**
+ * Timing statistics for one state of a StateMachine.
  */
+struct StateStats {
+    // Number of times the state was entered
+    uint32_t entries = 0;
+
+    // Total time spent in the state over all completed visits
+    units::second_t totalTime = 0_s;
+
+    // Duration of the last completed visit
+    units::second_t lastVisitTime = 0_s;
+};
 
 /**
  * Provides an easier way to create state machines
+ *
+ * The state machine records how long it spends in each state, how many
+ * transitions it makes, and the worst-case duration of Run(). Pass it to
+ * frc::SmartDashboard::PutData() to publish them to NetworkTables.
+ *
+ * @tparam EnumT The enum class that identifies the states. It must have
+ *               consecutive values starting at zero followed by kNumStates.
  */
-class StateMachine : public State {
+template <typename EnumT>
+class StateMachine : public frc::Sendable,
+                     public frc::SendableHelper<StateMachine<EnumT>> {
 public:
-    explicit StateMachine(std::string name);
+    static constexpr size_t kNumStates = static_cast<size_t>(EnumT::kNumStates);
+
+    explicit StateMachine(std::string_view name) : m_name{name} {}
 
     StateMachine(StateMachine&&) = default;
     StateMachine& operator=(StateMachine&&) = default;
 
     /**
-     * Ownership of 'state' will be transferred to this class, which will handle
-     * destroying it.
+     * Returns the name of the state machine.
      */
-    void AddState(State&& state) { m_states.push_back(std::move(state)); }
+    const std::string& Name() const { return m_name; }
 
-    /* Moves the state machine to the given state. If the next state is found,
-     * std::exit() for the current state and entry() for the next state are
-     * called.
+    /**
+     * Adds a state to the state machine.
+     *
+     * @param id    The ID of the state.
+     * @param name  The name of the state.
+     * @param state The state's callbacks.
+     */
+    void AddState(EnumT id, std::string_view name, const State<EnumT>& state) {
+        m_states[Index(id)] = state;
+        m_names[Index(id)] = name;
+        m_registered[Index(id)] = true;
+    }
+
+    /**
+     * Adds a child state machine as a state.
+     *
+     * Entering the state enters the child's initial state, and leaving it
+     * exits the child's current state. The child must outlive this state
+     * machine.
+     *
+     * @param id         The ID of the state.
+     * @param name       The name of the state.
+     * @param child      The child state machine.
+     * @param transition Returns the state to transition to, or std::nullopt to
+     *                   keep running the child.
+     */
+    template <typename ChildEnumT>
+    void AddState(EnumT id, std::string_view name,
+                  StateMachine<ChildEnumT>& child,
+                  frc3512::Delegate<std::optional<EnumT>()> transition) {
+        State<EnumT> state;
+        state.entry = [c = &child] { c->Enter(); };
+        state.transition = transition;
+        state.run = [c = &child] { c->Run(); };
+        state.exit = [c = &child] { c->Exit(); };
+        AddState(id, name, state);
+    }
+
+    /**
+     * Verifies a state was added for every ID in the enum.
+     *
+     * Call this after the state machine is constructed so a missing state is
+     * caught at startup instead of when a transition first targets it.
+     *
+     * @throws std::logic_error if a state ID has no state.
+     */
+    void Validate() const {
+        for (size_t i = 0; i < kNumStates; ++i) {
+            if (!m_registered[i]) {
+                throw std::logic_error{m_name + ": state " + std::to_string(i) +
+                                       " is not a known state"};
+            }
+        }
+    }
+
+    /**
+     * Sets how many transitions one call to Run() may follow.
+     *
+     * With the default of one, each state entered is first run by the next
+     * call to Run(), so a chain of states whose transitions are already
+     * satisfied advances one state per robot loop. A larger limit has Run()
+     * keep running and transitioning the states it enters until one stays or
+     * the limit is reached, so the chain settles within one call. The limit
+     * keeps states that transition to each other unconditionally from looping
+     * forever; the rest of such a cycle continues in the next call.
+     *
+     * @param maxTransitions The number of transitions. It must be at least
+     *                       one.
+     */
+    void SetMaxTransitionsPerRun(uint32_t maxTransitions) {
+        assert(maxTransitions >= 1);
+        m_maxTransitionsPerRun = maxTransitions;
+    }
+
+    /**
+     * Sets the state entered by Enter().
+     *
+     * @param initialState The ID of the initial state.
+     */
+    void SetInitialState(EnumT initialState) { m_initialState = initialState; }
+
+    /**
+     * Enters the initial state.
+     */
+    void Enter() { SetState(m_initialState); }
+
+    /**
+     * Exits the current state without entering another one.
+     *
+     * Run() does nothing until the state machine is entered again.
+     */
+    void Exit() {
+        if (m_hasState) {
+            m_states[Index(m_currentState)].exit();
+            EndVisit(frc::RobotController::GetFPGATime());
+            m_hasState = false;
+        }
+    }
+
+    /**
+     * Moves the state machine to the given state. exit() for the current state
+     * and entry() for the next state are called.
+     *
+     * @param nextState The ID of the next state.
+     */
+    void SetState(EnumT nextState) {
+        assert(Index(nextState) < kNumStates && m_registered[Index(nextState)]);
+
+        uint64_t now = frc::RobotController::GetFPGATime();
+
+        if (m_hasState) {
+            m_states[Index(m_currentState)].exit();
+            EndVisit(now);
+        }
+        m_currentState = nextState;
+        m_hasState = true;
+        m_stateStartTime = now;
+        ++m_stats[Index(m_currentState)].entries;
+        ++m_transitions;
+        m_states[Index(m_currentState)].entry();
+    }
+
+    /**
+     * Moves the state machine to the state with the given name.
+     *
      * 'true' is returned if the next state was found and 'false' otherwise.
+     *
+     * @param nextState The name of the next state.
+     */
+    bool SetState(std::string_view nextState) {
+        for (size_t i = 0; i < kNumStates; ++i) {
+            if (m_registered[i] && m_names[i] == nextState) {
+                SetState(static_cast<EnumT>(i));
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Returns the ID of the current state.
+     */
+    EnumT GetState() const { return m_currentState; }
+
+    /**
+     * Returns the name of the current state, or an empty string if no state
+     * has been set.
+     */
+    const std::string& GetStateName() const {
+        static const std::string kEmpty;
+
+        if (m_hasState) {
+            return m_names[Index(m_currentState)];
+        } else {
+            return kEmpty;
+        }
+    }
+
+    /**
+     * Runs the current state and follows its transition, if any.
+     *
+     * See SetMaxTransitionsPerRun() for running the states it leads to in the
+     * same call.
      */
-    bool SetState(const std::string& nextState);
+    void Run() {
+        if (!m_hasState) {
+            return;
+        }
 
-    // Returns name of current state
-    const std::string GetState() const;
+        uint64_t start = frc::RobotController::GetFPGATime();
+
+        for (uint32_t i = 0; i < m_maxTransitionsPerRun; ++i) {
+            auto& state = m_states[Index(m_currentState)];
+            state.run();
+
+            auto nextState = state.transition();
+            if (!nextState) {
+                break;
+            }
+            SetState(*nextState);
+        }
+
+        uint64_t duration = frc::RobotController::GetFPGATime() - start;
+        if (duration > m_worstRunTime) {
+            m_worstRunTime = duration;
+        }
+    }
+
+    /**
+     * Returns the timing statistics for the given state.
+     *
+     * The current visit isn't included until the state is left.
+     *
+     * @param id The ID of the state.
+     */
+    const StateStats& GetStats(EnumT id) const { return m_stats[Index(id)]; }
+
+    /**
+     * Returns how long the state machine has been in the current state.
+     */
+    units::second_t GetTimeInState() const {
+        if (!m_hasState) {
+            return 0_s;
+        }
+
+        return units::microsecond_t{static_cast<double>(
+            frc::RobotController::GetFPGATime() - m_stateStartTime)};
+    }
+
+    /**
+     * Returns the number of state transitions made.
+     */
+    uint32_t GetTransitionCount() const { return m_transitions; }
+
+    /**
+     * Returns the longest time a call to Run() has taken.
+     */
+    units::second_t GetWorstRunTime() const {
+        return units::microsecond_t{static_cast<double>(m_worstRunTime)};
+    }
+
+    /**
+     * Clears the timing statistics.
+     */
+    void ResetStats() {
+        m_stats = {};
+        m_transitions = 0;
+        m_worstRunTime = 0;
+    }
+
+    void InitSendable(frc::SendableBuilder& builder) override {
+        builder.AddStringProperty(
+            "State", [=] { return GetStateName(); }, nullptr);
+        builder.AddDoubleProperty(
+            "Time in state (s)",
+            [=] { return GetTimeInState().template to<double>(); },
+            nullptr);
+        builder.AddDoubleProperty(
+            "Transitions", [=] { return GetTransitionCount(); }, nullptr);
+        builder.AddDoubleProperty(
+            "Worst run (ms)",
+            [=] {
+                return units::millisecond_t{GetWorstRunTime()}
+                    .template to<double>();
+            },
+            nullptr);
+
+        for (size_t i = 0; i < kNumStates; ++i) {
+            const auto& name = m_names[i];
+            builder.AddDoubleProperty(
+                name + "/Entries", [=] { return m_stats[i].entries; }, nullptr);
+            builder.AddDoubleProperty(
+                name + "/Total time (s)",
+                [=] { return m_stats[i].totalTime.template to<double>(); },
+                nullptr);
+            builder.AddDoubleProperty(
+                name + "/Last visit (s)",
+                [=] { return m_stats[i].lastVisitTime.template to<double>(); },
+                nullptr);
+        }
+    }
 
 private:
-    std::vector<State> m_states;
-    const State* m_currentState = nullptr;
+    // Run() only touches the state callbacks, so they're packed contiguously
+    // and aligned to the Cortex-A9's 32-byte cache lines. Everything else is
+    // kept out of the way.
+    alignas(32) std::array<State<EnumT>, kNumStates> m_states;
+
+    std::string m_name;
+    std::array<std::string, kNumStates> m_names;
+    std::array<bool, kNumStates> m_registered{};
+    EnumT m_currentState{};
+    EnumT m_initialState{};
+    bool m_hasState = false;
+    uint32_t m_maxTransitionsPerRun = 1;
+
+    // Timing statistics. Times are FPGA timestamps in microseconds.
+    std::array<StateStats, kNumStates> m_stats{};
+    uint64_t m_stateStartTime = 0;
+    uint32_t m_transitions = 0;
+    uint64_t m_worstRunTime = 0;
+
+    static constexpr size_t Index(EnumT id) { return static_cast<size_t>(id); }
+
+    /**
+     * Records the end of the current state's visit.
+     *
+     * @param now The FPGA timestamp in microseconds.
+     */
+    void EndVisit(uint64_t now) {
+        auto& stats = m_stats[Index(m_currentState)];
+        stats.lastVisitTime =
+            units::microsecond_t{static_cast<double>(now - m_stateStartTime)};
+        stats.totalTime += stats.lastVisitTime;
+    }
 };
@@ -2,15 +2,78 @@
 
 #pragma once
 
+#include <ctre/phoenix/motorcontrol/StatusFrame.h>
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
 #include <frc/SpeedController.h>
+#include <units/time.h>
+#include <units/voltage.h>
 
+#include "CANBusBudget.hpp"
+#include "CoalescedTalonOutput.hpp"
+
+/**
+ * Drives a leader Talon and makes the rest follow it.
+ *
+ * Followers don't report anything the robot reads, so their status frames are
+ * slowed to the minimum rate. The leader's status frames are slowed too except
+ * for Status_1_General and whatever is passed to RequireStatusFrame() or
+ * required by sensors attached to it.
+ *
+ * Commands that match the last one sent to the leader are coalesced by a
+ * CoalescedTalonOutput.
+ *
+ * The leader can also run Motion Magic on its selected sensor. The Talon then
+ * closes the position loop and follows its own trapezoid profile every
+ * millisecond, so CAN latency stays out of the loop and the robot only sends
+ * goals.
+ */
 class TalonSRXGroup : public frc::SpeedController {
 public:
+    /**
+     * Where a subsystem runs its position controller.
+     */
+    enum class ControllerLocation {
+        /// The roboRIO computes and sends an output every controller period
+        kRoboRIO,
+
+        /// The leader runs Motion Magic and the roboRIO only sends goals
+        kTalon
+    };
+
+    /**
+     * Closed-loop gains in the Talon's native units.
+     *
+     * An output of 1023 is full voltage. kP is output per pulse of error, kI is
+     * output per pulse of error summed every millisecond, kD is output per
+     * pulse of error change per millisecond, and kF is output per pulse per
+     * 100 ms of target velocity.
+     */
+    struct ClosedLoopGains {
+        double kP = 0.0;
+        double kI = 0.0;
+        double kD = 0.0;
+        double kF = 0.0;
+    };
+
+    // Voltage that full output is compensated to once closed-loop control is
+    // configured, so gains and feedforwards don't change with the battery
+    static constexpr units::volt_t kNominalVoltage = 12_V;
+
+    // Status_1_General period of followers. It's kept faster than the other
+    // frames so faults still show up in a reasonable time.
+    static constexpr units::millisecond_t kFollowerGeneralPeriod = 100_ms;
+
     template <class... Talons>
     explicit TalonSRXGroup(ctre::phoenix::motorcontrol::can::TalonSRX& leader,
                            Talons&... followers)
-        : m_leader{&leader} {
+        : m_leader{&leader}, m_output{leader} {
+        auto& budget = CANBusBudget::GetInstance();
+        budget.RequireStatusFrame(
+            leader,
+            ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_1_General,
+            10_ms);
+        budget.SlowUnrequiredFrames(leader);
+
         FollowImpl(followers...);
     }
 
@@ -25,15 +88,99 @@ public:
     void StopMotor() override;
     void PIDWrite(double output) override;
 
+    /**
+     * Sets the output voltage.
+     *
+     * If voltage compensation is enabled, the leader compensates for the
+     * battery voltage. Otherwise, the output is scaled by the battery voltage
+     * sampled by PowerMonitor.
+     *
+     * @param output The voltage.
+     */
+    void SetVoltage(units::volt_t output) override;
+
+    /**
+     * Makes the leader scale its output so full output is kNominalVoltage
+     * regardless of the battery voltage.
+     *
+     * The Talon measures its own bus voltage every millisecond, so this holds
+     * the output steadier under load than compensating on the roboRIO.
+     */
+    void EnableVoltageCompensation();
+
+    /**
+     * Configures the leader's closed-loop gains and enables voltage
+     * compensation.
+     *
+     * @param gains The gains in native units.
+     */
+    void ConfigClosedLoop(const ClosedLoopGains& gains);
+
+    /**
+     * Configures the leader's Motion Magic profile.
+     *
+     * @param cruiseVelocity Maximum velocity in pulses per 100 ms.
+     * @param acceleration   Maximum acceleration in pulses per 100 ms per
+     *                       second.
+     * @param sCurveStrength Smoothing of the trapezoid from 0 (none) to 8.
+     */
+    void ConfigMotionMagic(double cruiseVelocity, double acceleration,
+                           int sCurveStrength = 0);
+
+    /**
+     * Makes the leader move its selected sensor to a position with Motion
+     * Magic.
+     *
+     * SetInverted() doesn't apply, so the leader's sensor phase must make its
+     * selected sensor increase when its output is positive.
+     *
+     * @param position             The goal in pulses.
+     * @param arbitraryFeedforward Voltage added to the closed-loop output.
+     */
+    void SetMotionMagic(double position, units::volt_t arbitraryFeedforward);
+
+    /**
+     * Returns the voltage applied by the last command.
+     *
+     * Under Motion Magic, this is the leader's reported output voltage with
+     * the group's inversion applied.
+     */
+    units::volt_t GetVoltage() const;
+
+    /**
+     * Keeps one of the leader's status frames at or below the given period.
+     *
+     * @param frame  The status frame.
+     * @param period The longest acceptable frame period.
+     */
+    void RequireStatusFrame(
+        ctre::phoenix::motorcontrol::StatusFrameEnhanced frame,
+        units::millisecond_t period);
+
+    /**
+     * Returns the output that coalesces the leader's commands.
+     */
+    const CoalescedTalonOutput& GetOutput() const;
+
 private:
     double m_speed = 0.0;
     bool m_isInverted = false;
+    bool m_voltageCompensated = false;
+    bool m_inMotionMagic = false;
     ctre::phoenix::motorcontrol::can::TalonSRX* m_leader;
+    CoalescedTalonOutput m_output;
 
     template <class Talon, class... Talons>
     void FollowImpl(Talon& follower, Talons&... followers) {
         follower.Follow(*m_leader);
 
+        auto& budget = CANBusBudget::GetInstance();
+        budget.RequireStatusFrame(
+            follower,
+            ctre::phoenix::motorcontrol::StatusFrameEnhanced::Status_1_General,
+            kFollowerGeneralPeriod);
+        budget.SlowUnrequiredFrames(follower);
+
         if constexpr (sizeof...(followers) > 0) {
             FollowImpl(followers...);
         }
@@ -0,0 +1,157 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <networktables/NetworkTableEntry.h>
+#include <wpi/mutex.h>
+
+#include "SeqLock.hpp"
+
+namespace frc3512 {
+
+/**
+ * Publishes telemetry to NetworkTables from a background thread.
+ *
+ * NetworkTables writes take a lock shared with the NetworkTables threads, so a
+ * control loop that writes entries directly can stall behind network traffic.
+ * Instead, each source of telemetry stores its latest values somewhere the
+ * control loop can write without blocking, such as a SeqLock, and registers a
+ * function that publishes them. A low-priority thread calls every registered
+ * function at a fixed rate.
+ */
+class TelemetryPublisher {
+public:
+    static constexpr auto kPeriod = std::chrono::milliseconds{50};
+
+    using Handle = uint32_t;
+
+    static TelemetryPublisher& GetInstance();
+
+    ~TelemetryPublisher();
+
+    TelemetryPublisher(const TelemetryPublisher&) = delete;
+    TelemetryPublisher& operator=(const TelemetryPublisher&) = delete;
+
+    /**
+     * Starts the publisher thread.
+     */
+    void Start();
+
+    /**
+     * Stops the publisher thread after one more pass.
+     */
+    void Stop();
+
+    /**
+     * Registers a function that the publisher thread calls every period.
+     *
+     * It should only write values that changed since its last call.
+     *
+     * @param publish The function.
+     * @return A handle for RemovePublisher().
+     */
+    Handle AddPublisher(std::function<void()> publish);
+
+    /**
+     * Unregisters a function. When this returns, the publisher thread isn't
+     * calling it and won't again.
+     *
+     * @param handle The handle returned by AddPublisher().
+     */
+    void RemovePublisher(Handle handle);
+
+    /**
+     * Calls every registered function once on the calling thread.
+     */
+    void PublishAll();
+
+private:
+    struct Publisher {
+        Handle handle;
+        std::function<void()> publish;
+    };
+
+    wpi::mutex m_mutex;
+    std::vector<Publisher> m_publishers;
+    Handle m_nextHandle = 0;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    TelemetryPublisher() = default;
+
+    void RunPublisher();
+};
+
+/**
+ * A fixed set of numeric telemetry fields under one NetworkTables table.
+ *
+ * The owning thread sets fields, then calls Commit() to hand them to the
+ * publisher as one consistent snapshot. Neither call blocks. The publisher
+ * thread writes only the fields that changed since it last published.
+ */
+class TelemetrySource {
+public:
+    static constexpr size_t kMaxFields = 16;
+
+    /**
+     * Constructs a TelemetrySource and registers it with the publisher.
+     *
+     * @param table The NetworkTables table, relative to the root.
+     * @param names The name of each field's entry.
+     */
+    TelemetrySource(std::string_view table,
+                    std::initializer_list<std::string_view> names);
+
+    ~TelemetrySource();
+
+    TelemetrySource(const TelemetrySource&) = delete;
+    TelemetrySource& operator=(const TelemetrySource&) = delete;
+
+    /**
+     * Sets a field's value in the next snapshot.
+     *
+     * @param field The field's index in the names passed to the constructor.
+     * @param value The value.
+     */
+    void Set(size_t field, double value) { m_back[field] = value; }
+
+    /**
+     * Makes the set fields visible to the publisher thread.
+     */
+    void Commit() { m_front.Store(m_back); }
+
+private:
+    using Snapshot = std::array<double, kMaxFields>;
+
+    size_t m_numFields;
+
+    // Written by the owning thread
+    Snapshot m_back{};
+
+    // Shared with the publisher thread
+    SeqLock<Snapshot> m_front;
+
+    // Owned by the publisher thread
+    std::array<nt::NetworkTableEntry, kMaxFields> m_entries;
+    Snapshot m_published;
+    uint32_t m_publishedVersion = 0;
+
+    TelemetryPublisher::Handle m_handle;
+
+    void Publish();
+};
+
+}  // namespace frc3512
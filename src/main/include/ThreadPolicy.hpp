@@ -0,0 +1,198 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <string_view>
+
+#include <units/time.h>
+
+#include "LoopProfiler.hpp"
+
+namespace frc3512 {
+
+/**
+ * The jobs the robot program's threads do.
+ */
+enum class ThreadRole {
+    // The TimedRobot loop
+    kMainLoop,
+
+    // The ControllerScheduler notifier
+    kControllers,
+
+    // The AutonomousChooser worker in ExecutionMode::kThread
+    kAutonomous,
+
+    // The TelemetryPublisher thread
+    kTelemetry,
+
+    // The EventLog and SignalRecorder writers
+    kLogging
+};
+
+/**
+ * Assigns each thread role a scheduling priority and CPU core, and measures
+ * how late the time-critical threads wake up.
+ *
+ * The roboRIO has two cores. The threads that run the robot are real-time and
+ * pinned to core 1, and the threads that do I/O are left at normal priority on
+ * core 0, so the control loops don't wait behind logging or NetworkTables.
+ * The NetworkTables threads belong to ntcore and keep their default policy;
+ * their callbacks only store values for the robot threads to read.
+ *
+ * Each thread applies its own policy when it starts. Affinity, memory locking
+ * and stack prefaulting only take effect on the roboRIO, since the simulation
+ * shares the machine with everything else.
+ */
+class ThreadPolicy {
+public:
+    struct Policy {
+        // Thread name shown by top and ps. At most 15 characters.
+        const char* name;
+
+        // True to use SCHED_FIFO
+        bool realTime;
+
+        // Priority from 1 (lowest) to 99 (highest). Only used if realTime is
+        // true.
+        int priority;
+
+        // The core the thread is pinned to
+        int cpu;
+    };
+
+    // The controllers are above the main loop but below the HAL's notifier
+    // and CAN threads. The autonomous worker only runs while the main loop
+    // waits for it, so they share a priority.
+    static constexpr std::array<Policy, 5> kPolicies{{
+        {"robot main", true, 15, 1},
+        {"robot control", true, 30, 1},
+        {"robot auton", true, 15, 1},
+        {"robot telemetry", false, 0, 0},
+        {"robot logging", false, 0, 0},
+    }};
+
+    // Bytes of stack touched by real-time threads when they start
+    static constexpr size_t kStackPrefaultSize = 64 * 1024;
+
+    static ThreadPolicy& GetInstance();
+
+    ThreadPolicy(const ThreadPolicy&) = delete;
+    ThreadPolicy& operator=(const ThreadPolicy&) = delete;
+
+    /**
+     * Returns the policy of a role.
+     *
+     * @param role The role.
+     */
+    static constexpr const Policy& GetPolicy(ThreadRole role) {
+        return kPolicies[static_cast<size_t>(role)];
+    }
+
+    /**
+     * Keeps freed heap memory from being returned to the system, and serves
+     * large allocations from the heap too, so allocating after startup
+     * doesn't fault in new pages.
+     *
+     * Call this once at startup.
+     */
+    static void RetainHeap();
+
+    /**
+     * Locks a region the real-time threads touch into RAM so page faults
+     * can't stall them, faulting it in now.
+     *
+     * Only the robot's own buffers and the real-time threads' stacks are
+     * locked this way. mlockall() would also lock the whole stack reservation
+     * of every thread in the process, which the roboRIO doesn't have the RAM
+     * for.
+     *
+     * @param data The start of the region.
+     * @param size The size of the region in bytes.
+     * @return True if the region was locked.
+     */
+    static bool LockRegion(const void* data, size_t size);
+
+    /**
+     * Locks the code and data of a loaded object into RAM, faulting it in
+     * now, and prints its size.
+     *
+     * Code is read from flash the first time it runs and can be dropped again
+     * when memory runs low, so code that first runs in a match, such as the
+     * autonomous mode's, would fault in the middle of a loop.
+     *
+     * @param name The file name of a shared library, such as "libwpilibc.so",
+     *             or empty for the robot program itself.
+     * @return True if the object was found and locked.
+     */
+    static bool LockObject(std::string_view name);
+
+    /**
+     * Applies a role's policy to the calling thread.
+     *
+     * @param role The role.
+     * @return True if the priority was set.
+     */
+    static bool Apply(ThreadRole role);
+
+    /**
+     * Records how long a thread took to run after it should have.
+     *
+     * @param role    The thread's role.
+     * @param latency The latency in microseconds.
+     */
+    void RecordLatency(ThreadRole role, uint64_t latency) {
+        m_sections[static_cast<size_t>(role)]->Record(latency);
+    }
+
+    /**
+     * Returns the wakeup latency of each role. Pass it to
+     * frc::SmartDashboard::PutData() to publish the statistics.
+     */
+    LoopProfiler& GetLatencyProfiler();
+
+    /**
+     * Prints the wakeup latency of each role that has recorded any.
+     */
+    void Report() const;
+
+private:
+    LoopProfiler m_latencies;
+    std::array<LoopProfiler::Section*, kPolicies.size()> m_sections;
+
+    ThreadPolicy();
+};
+
+/**
+ * Measures how late a periodic thread wakes up.
+ *
+ * The expected wakeup times are extrapolated from the earliest phase seen, so
+ * a late wakeup doesn't shift the times after it. Gaps of more than a few
+ * periods, such as between modes, restart the measurement.
+ */
+class WakeupMonitor {
+public:
+    /**
+     * Constructs a WakeupMonitor.
+     *
+     * @param role   The thread's role.
+     * @param period The period the thread is woken at.
+     */
+    WakeupMonitor(ThreadRole role, units::second_t period);
+
+    /**
+     * Records a wakeup. Call this first thing each period.
+     */
+    void Record();
+
+private:
+    ThreadRole m_role;
+    uint64_t m_period;
+    uint64_t m_expected = 0;
+};
+
+}  // namespace frc3512
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <frc/controller/SimpleMotorFeedforward.h>
+#include <frc/geometry/Pose2d.h>
+#include <frc/geometry/Translation2d.h>
+#include <frc/trajectory/Trajectory.h>
+#include <units/acceleration.h>
+#include <units/length.h>
+#include <units/velocity.h>
+#include <units/voltage.h>
+
+namespace frc3512 {
+
+/**
+ * Everything that determines the shape and timing of a trajectory.
+ *
+ * Trajectories are generated with a differential drive kinematics constraint
+ * for the track width and a voltage constraint for the feedforward model.
+ */
+struct TrajectoryDefinition {
+    frc::Pose2d start;
+    std::vector<frc::Translation2d> interiorWaypoints;
+    frc::Pose2d end;
+
+    units::meters_per_second_t maxVelocity = 0_mps;
+    units::meters_per_second_squared_t maxAcceleration = 0_mps_sq;
+
+    // True if the robot drives the trajectory backward
+    bool reversed = false;
+
+    units::meter_t trackWidth = 0_m;
+    frc::SimpleMotorFeedforward<units::meters> feedforward;
+    units::volt_t maxVoltage = 0_V;
+};
+
+/**
+ * Keeps the robot's trajectories in memory so none are generated during a
+ * match.
+ *
+ * Each trajectory is stored in its own file in the cache directory along with
+ * a hash of its definition. Load() reads the files whose hash matches and
+ * generates the rest, then writes those back so the next load is fast. The
+ * trajectory generator tool runs Load() on the desktop at build time to fill
+ * src/main/deploy/trajectories, which gets deployed with the robot program.
+ */
+class TrajectoryCache {
+public:
+    /**
+     * Returns the deploy directory's trajectories subdirectory.
+     */
+    static std::string GetDefaultDirectory();
+
+    /**
+     * Constructs a TrajectoryCache.
+     *
+     * @param directory The directory containing the trajectory files.
+     */
+    explicit TrajectoryCache(std::string directory = GetDefaultDirectory());
+
+    /**
+     * Adds a trajectory to the cache. Call Load() afterward to make it
+     * available from Get().
+     *
+     * @param name       The name of the trajectory. It's also the name of its
+     *                   file, so it must be a valid file name.
+     * @param definition Waypoints and constraints of the trajectory.
+     */
+    void Add(std::string_view name, const TrajectoryDefinition& definition);
+
+    /**
+     * Loads every added trajectory that hasn't been loaded yet.
+     *
+     * Trajectories without an up to date file are generated and saved.
+     *
+     * @return The number of trajectories that had to be generated.
+     */
+    int Load();
+
+    /**
+     * Returns a loaded trajectory.
+     *
+     * @param name The name of the trajectory.
+     * @throws std::out_of_range if no trajectory with that name was loaded.
+     */
+    const frc::Trajectory& Get(std::string_view name) const;
+
+    /**
+     * Returns the hash stored in a trajectory's file.
+     *
+     * It changes whenever anything in the definition changes.
+     *
+     * @param definition The definition of the trajectory.
+     */
+    static uint64_t Hash(const TrajectoryDefinition& definition);
+
+    /**
+     * Generates a trajectory from its definition.
+     *
+     * @param definition The definition of the trajectory.
+     */
+    static frc::Trajectory Generate(const TrajectoryDefinition& definition);
+
+private:
+    struct Entry {
+        TrajectoryDefinition definition;
+        frc::Trajectory trajectory;
+        bool loaded = false;
+    };
+
+    std::string m_directory;
+    std::map<std::string, Entry, std::less<>> m_entries;
+
+    std::string GetPath(std::string_view name) const;
+};
+
+}  // namespace frc3512
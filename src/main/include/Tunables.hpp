@@ -0,0 +1,163 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <wpi/mutex.h>
+
+namespace frc3512 {
+
+/**
+ * Numbers that can be changed by editing a file in the deploy directory
+ * instead of rebuilding the robot program.
+ *
+ * The file has one "name = value" line per number. Blank lines and lines
+ * starting with '#' are ignored, and numbers missing from the file keep the
+ * defaults they were registered with. Values are in the units of the Tunable
+ * that reads them.
+ *
+ * The file is memory-mapped and parsed only by Load(). The parsed values are
+ * stored in a flat array, and each Tunable keeps its index into it, so reading
+ * one is an atomic pointer load and an array access. Reloading builds a new
+ * array and swaps the pointer, so readers on other threads never block or see
+ * a partly updated set. Replaced arrays are freed after a grace period, since a
+ * reader may still hold one.
+ *
+ * Names in the file that no Tunable registered are reported by Load() and
+ * ReportUnknownNames(), so a misspelled name doesn't silently do nothing.
+ */
+class Tunables {
+public:
+    static Tunables& GetInstance();
+
+    Tunables(const Tunables&) = delete;
+    Tunables& operator=(const Tunables&) = delete;
+
+    /**
+     * Returns the path of tunables.txt in the deploy directory.
+     */
+    static std::string GetDefaultPath();
+
+    /**
+     * Reads values from a file and publishes them to every Tunable.
+     *
+     * The instance loads the default path when it's first used. Call this
+     * again after changing the file to apply the changes.
+     *
+     * @param path The file.
+     * @return True if the file was read. If it wasn't, the values don't change.
+     */
+    bool Load(std::string_view path = GetDefaultPath());
+
+    /**
+     * Prints the names in the loaded file that no Tunable registered.
+     *
+     * Load() does this itself. The load when the instance is first used
+     * happens before anything is registered, so call this once every Tunable
+     * has been constructed.
+     */
+    void ReportUnknownNames();
+
+    /**
+     * Adds a number and returns its index. Registering a name again returns
+     * the existing index.
+     *
+     * @param name         The number's name in the file.
+     * @param defaultValue The value used if the file doesn't set it.
+     */
+    size_t Register(std::string_view name, double defaultValue);
+
+    /**
+     * Returns the current value of a registered number.
+     *
+     * @param index The index returned by Register().
+     */
+    double Get(size_t index) const {
+        return m_values.load(std::memory_order_acquire)[index];
+    }
+
+private:
+    wpi::mutex m_mutex;
+
+    std::vector<std::string> m_names;
+    std::vector<double> m_defaults;
+    std::map<std::string, double, std::less<>> m_fileValues;
+
+    // How long a replaced array is kept before it's freed
+    static constexpr std::chrono::seconds kGracePeriod{1};
+
+    struct RetiredTable {
+        std::unique_ptr<double[]> table;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // The array in m_values, and the ones it replaced within the grace period
+    std::unique_ptr<double[]> m_table;
+    std::vector<RetiredTable> m_retired;
+    std::atomic<const double*> m_values{nullptr};
+
+    Tunables();
+
+    /**
+     * Reads values from a file and publishes them without reporting unknown
+     * names.
+     *
+     * @param path The file.
+     * @return True if the file was read.
+     */
+    bool Read(std::string_view path);
+
+    /**
+     * Builds and publishes a new array from the defaults and the file.
+     */
+    void Publish();
+};
+
+/**
+ * A handle to a number in Tunables.
+ *
+ * @tparam T The units of the number, or double.
+ */
+template <typename T>
+class Tunable {
+public:
+    /**
+     * Registers a number with Tunables.
+     *
+     * @param name         The number's name in the file.
+     * @param defaultValue The value used if the file doesn't set it.
+     */
+    Tunable(std::string_view name, T defaultValue)
+        : m_tunables{&Tunables::GetInstance()},
+          m_index{Tunables::GetInstance().Register(name,
+                                                   ToDouble(defaultValue))} {}
+
+    /**
+     * Returns the number's current value.
+     */
+    T Get() const { return T{m_tunables->Get(m_index)}; }
+
+private:
+    const Tunables* m_tunables;
+    size_t m_index;
+
+    static double ToDouble(T value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return value;
+        } else {
+            return value.template to<double>();
+        }
+    }
+};
+
+}  // namespace frc3512
@@ -2,16 +2,44 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonSRX.h>
-#include <frc/controller/ProfiledPIDController.h>
+#include <frc/ADXRS450_Gyro.h>
+#include <frc/controller/RamseteController.h>
+#include <frc/controller/SimpleMotorFeedforward.h>
 #include <frc/drive/DifferentialDrive.h>
+#include <frc/geometry/Pose2d.h>
+#include <frc/geometry/Translation2d.h>
+#include <frc/kinematics/DifferentialDriveKinematics.h>
+#include <frc/kinematics/DifferentialDriveOdometry.h>
+#include <frc/simulation/ADXRS450_GyroSim.h>
+#include <frc/simulation/DifferentialDrivetrainSim.h>
+#include <frc/system/plant/DCMotor.h>
+#include <frc/system/plant/LinearSystemId.h>
+#include <frc/trajectory/Trajectory.h>
 #include <units/acceleration.h>
+#include <units/angular_velocity.h>
 #include <units/length.h>
+#include <units/mass.h>
+#include <units/moment_of_inertia.h>
+#include <units/time.h>
 #include <units/velocity.h>
 #include <units/voltage.h>
 
 #include "CANEncoder.hpp"
+#include "Constants.hpp"
+#include "DrivetrainEstimator.hpp"
+#include "MultiProfiledPIDController.hpp"
+#include "SignalRecorder.hpp"
 #include "TalonSRXGroup.hpp"
+#include "TelemetryPublisher.hpp"
+#include "TrajectoryCache.hpp"
 
 /**
  * Provides an interface for this year's drive train
@@ -21,7 +49,61 @@ public:
     static constexpr units::feet_per_second_t kMaxV = 80_in / 1_s;
     static constexpr units::feet_per_second_squared_t kMaxA = 80_in / 1_s / 2_s;
 
-    Drivetrain();
+    // Encoder distance per pulse in inches
+    static constexpr double kDistancePerPulse = 72.0 / 2800.0;
+
+    // Drivetrain model used to generate and follow trajectories. The
+    // feedforward gains are estimated from the physics model in
+    // SimulationPeriodic() and should be replaced with characterized ones.
+    static constexpr units::meter_t kTrackWidth = 24_in;
+    static constexpr frc::SimpleMotorFeedforward<units::meters> kFeedforward{
+        0.5_V, 3.0_V / 1_mps, 0.44_V / 1_mps_sq};
+    static constexpr units::volt_t kMaxTrajectoryVoltage = 10_V;
+    static constexpr units::meters_per_second_t kMaxTrajectoryV = 2_mps;
+    static constexpr units::meters_per_second_squared_t kMaxTrajectoryA =
+        2_mps_sq;
+
+    // Proportional gain of the wheel velocity loops in V/(m/s)
+    static constexpr double kWheelVelocityP = 1.0;
+
+    // Physics model shared by the simulation and the state estimator: two CIMs
+    // per side driving 6 in wheels
+    static constexpr double kGearing = 10.71;
+    static constexpr units::kilogram_square_meter_t kMomentOfInertia =
+        3_kg_sq_m;
+    static constexpr units::kilogram_t kMass = 50_kg;
+    static constexpr units::meter_t kWheelRadius = 3_in;
+
+    // LeftAtGoal() and RightAtGoal() require the distance to be this close to
+    // the goal when the Talons run the position controllers
+    static constexpr units::inch_t kTalonGoalTolerance = 0.6_in;
+
+    // A gyro calibration is rejected if either side's estimated speed exceeds
+    // this while it runs
+    static constexpr units::feet_per_second_t kGyroCalibrationMaxSpeed =
+        0.5_in / 1_s;
+
+    /**
+     * Constructs a Drivetrain.
+     *
+     * @param controllerLocation Where the position controllers run. On the
+     *                           Talons, Motion Magic uses the same gains and
+     *                           constraints plus the velocity feedforward of
+     *                           kFeedforward.
+     */
+    explicit Drivetrain(TalonSRXGroup::ControllerLocation controllerLocation =
+                            TalonSRXGroup::ControllerLocation::kRoboRIO);
+
+    ~Drivetrain();
+
+    Drivetrain(const Drivetrain&) = delete;
+    Drivetrain& operator=(const Drivetrain&) = delete;
+
+    /**
+     * Returns true once the gyro has finished a calibration taken with the
+     * wheels still and is used for the heading.
+     */
+    bool IsGyroReady() const;
 
     /* Drives robot with given speed and turn values [-1..1].
      * This is a convenience function for use in Operator Control.
@@ -29,20 +111,41 @@ public:
     void Drive(double throttle, double turn, bool isQuickTurn = false);
 
     /**
-     * Sets encoder distances to 0.
+     * Returns the last percent output sent to the left gearbox.
+     */
+    double GetLeftOutput() const;
+
+    /**
+     * Returns the last percent output sent to the right gearbox.
+     */
+    double GetRightOutput() const;
+
+    /**
+     * Sets encoder distances to 0 and resets the pose estimate to the origin.
      */
     void ResetEncoders();
 
     /**
-     * Returns left encoder distance.
+     * Returns the left wheel distance estimated at the last controller update.
      */
     units::inch_t GetLeftDistance();
 
     /**
-     * Returns right encoder distance.
+     * Returns the right wheel distance estimated at the last controller
+     * update.
      */
     units::inch_t GetRightDistance();
 
+    /**
+     * Returns the wheel distances and velocities estimated at the last
+     * controller update.
+     *
+     * The estimate fuses the encoders, the gyro, and the applied voltages and
+     * is brought forward from when the encoders were measured to the time of
+     * the update.
+     */
+    frc3512::DrivetrainEstimator::Estimate GetStateEstimate() const;
+
     void SetLeftGoal(units::foot_t goal);
 
     void SetRightGoal(units::foot_t goal);
@@ -60,28 +163,271 @@ public:
     void SetSetpointsToMeasurements();
 
     /**
-     * Runs closed-loop position control on motors.
+     * Enables or disables closed-loop position control.
+     *
+     * The controllers are disabled by default so they don't fight Drive().
+     *
+     * @param enabled True to enable the controllers.
+     */
+    void SetControllersEnabled(bool enabled);
+
+    /**
+     * Returns true if closed-loop position control is enabled.
+     */
+    bool AreControllersEnabled() const;
+
+    /**
+     * Updates the state and pose estimates, then follows the current
+     * trajectory or runs
+     * closed-loop position control on motors if it's enabled.
+     * ControllerScheduler calls this every Constants::kControllerPeriod.
      */
     void UpdateControllers();
 
+    /**
+     * Returns the definition of a trajectory that this drivetrain can follow.
+     *
+     * @param start    The starting pose.
+     * @param interior The waypoints between the start and end.
+     * @param end      The ending pose.
+     * @param reversed True to drive the trajectory backward.
+     */
+    static frc3512::TrajectoryDefinition MakeTrajectory(
+        const frc::Pose2d& start,
+        const std::vector<frc::Translation2d>& interior,
+        const frc::Pose2d& end, bool reversed = false);
+
+    /**
+     * Returns the pose estimated from the wheel distances and the gyro.
+     */
+    frc::Pose2d GetPose() const;
+
+    /**
+     * Resets the encoders and sets the pose estimate.
+     *
+     * @param pose The robot's current pose.
+     */
+    void ResetOdometry(const frc::Pose2d& pose);
+
+    /**
+     * Starts following a trajectory.
+     *
+     * The pose estimate is reset to the trajectory's initial pose. Until the
+     * trajectory ends or StopTrajectory() is called, UpdateControllers()
+     * drives the robot along it instead of running the position controllers.
+     *
+     * @param trajectory The trajectory. It must outlive the call to
+     *                   UpdateControllers() in which it ends.
+     */
+    void FollowTrajectory(const frc::Trajectory& trajectory);
+
+    /**
+     * Stops following the trajectory and the drive motors.
+     */
+    void StopTrajectory();
+
+    /**
+     * Returns true if a trajectory is being followed.
+     */
+    bool IsFollowingTrajectory() const;
+
+    /**
+     * Runs the trajectory tracking computations along a trajectory on scratch
+     * state, so the first loops of following it don't run cold.
+     *
+     * The pose estimate, setpoints, and outputs don't change.
+     *
+     * @param trajectory The trajectory.
+     */
+    void WarmUp(const frc::Trajectory& trajectory) const;
+
+    /**
+     * Writes the controller signals recorded since the last flush to a file in
+     * the background.
+     *
+     * @param directory The directory in which to create the file.
+     */
+    void FlushSignals(std::string_view directory);
+
+    /**
+     * Steps the drivetrain physics model and feeds it to the simulated
+     * encoders.
+     *
+     * @param dt The time since the last call.
+     */
+    void SimulationPeriodic(units::second_t dt);
+
+    /**
+     * Returns the pose of the drivetrain physics model.
+     */
+    frc::Pose2d GetSimulatedPose() const;
+
 private:
+    /**
+     * The scalars UpdateControllers() reads or writes each tick.
+     *
+     * They're kept together at the front of the object and aligned to the
+     * Cortex-A9's 32-byte cache lines, followed by the controllers and the
+     * estimator, so a tick touches adjacent lines instead of ones scattered
+     * between the hardware handles, recorders and simulation model that come
+     * after.
+     */
+    struct alignas(32) ControllerState {
+        TalonSRXGroup::ControllerLocation controllerLocation =
+            TalonSRXGroup::ControllerLocation::kRoboRIO;
+        bool controllersEnabled = false;
+
+        // Set by the controller thread when it switches to the gyro. The
+        // offset keeps the heading continuous across the switch.
+        bool gyroInUse = false;
+        units::radian_t gyroHeadingOffset = 0_rad;
+
+        units::foot_t leftGoal = 0_ft;
+        units::foot_t rightGoal = 0_ft;
+
+        units::meter_t leftOdometryOffset = 0_m;
+        units::meter_t rightOdometryOffset = 0_m;
+
+        const frc::Trajectory* trajectory = nullptr;
+        units::second_t trajectoryStartTime = 0_s;
+        frc::DifferentialDriveWheelSpeeds lastWheelSpeeds;
+    };
+
+    ControllerState m_state;
+
+    using PositionController =
+        frc3512::MultiProfiledPIDController<2, units::feet>;
+
+    // Channels of the position controller
+    static constexpr size_t kLeft = 0;
+    static constexpr size_t kRight = 1;
+
+    PositionController m_controllers{
+        {{{5.0, 0.0, 2.0}, {8.0, 0.0, 3.0}}},
+        PositionController::Constraints{kMaxV, kMaxA},
+        frc3512::Constants::kControllerPeriod};
+
+    static constexpr frc::DifferentialDriveKinematics kKinematics{kTrackWidth};
+
+    frc3512::DrivetrainEstimator m_estimator{
+        frc::LinearSystemId::DrivetrainVelocitySystem(
+            frc::DCMotor::CIM(2), kMass, kWheelRadius, kTrackWidth / 2.0,
+            kMomentOfInertia, kGearing),
+        kTrackWidth};
+    frc::DifferentialDriveOdometry m_odometry{frc::Rotation2d{}};
+    frc::RamseteController m_ramsete;
+
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_frontLeftMotor{4};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_backLeftMotor{1};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_frontRightMotor{5};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_backRightMotor{8};
 
-    CANEncoder m_leftEncoder{m_frontLeftMotor, 72.0 / 2800.0, true};
-    CANEncoder m_rightEncoder{m_frontRightMotor, 72.0 / 2800.0, true};
+    CANEncoder m_leftEncoder{m_frontLeftMotor, kDistancePerPulse, true};
+    CANEncoder m_rightEncoder{m_frontRightMotor, kDistancePerPulse, true};
 
     TalonSRXGroup m_leftGrbx{m_frontLeftMotor, m_backLeftMotor};
     TalonSRXGroup m_rightGrbx{m_frontRightMotor, m_backRightMotor};
 
+    // Calibrating the gyro takes five seconds in its constructor, so it's
+    // constructed on m_gyroThread instead of delaying robot startup. Until
+    // m_gyroReady is set, the heading comes from the wheel distances.
+    //
+    // The robot may already be driving by then, and a calibration taken while
+    // it moves biases the gyro. The controller thread sets
+    // m_gyroMovedWhileCalibrating when it sees the wheels turn during one, and
+    // m_gyroThread then calibrates again the next time the robot is disabled.
+    std::unique_ptr<frc::ADXRS450_Gyro> m_gyro;
+    std::atomic<bool> m_gyroReady{false};
+    std::atomic<bool> m_gyroCalibrating{false};
+    std::atomic<bool> m_gyroMovedWhileCalibrating{false};
+    std::atomic<bool> m_stopGyroThread{false};
+    std::thread m_gyroThread;
+
     frc::DifferentialDrive m_drive{m_leftGrbx, m_rightGrbx};
 
-    frc::ProfiledPIDController<units::feet> m_leftController{
-        5, 0, 2, frc::TrapezoidProfile<units::feet>::Constraints{kMaxV, kMaxA},
-        20_ms};
-    frc::ProfiledPIDController<units::feet> m_rightController{
-        8, 0, 3, frc::TrapezoidProfile<units::feet>::Constraints{kMaxV, kMaxA},
-        20_ms};
+    frc3512::SignalRecorder m_recorder{"drivetrain",
+                                       {"Left setpoint (ft)",
+                                        "Left measurement (ft)",
+                                        "Left output (V)",
+                                        "Left at goal",
+                                        "Right setpoint (ft)",
+                                        "Right measurement (ft)",
+                                        "Right output (V)",
+                                        "Right at goal"}};
+    // Indices of the telemetry fields
+    enum TelemetryField : size_t {
+        kPoseX,
+        kPoseY,
+        kPoseHeading,
+        kLeftVelocity,
+        kRightVelocity
+    };
+
+    frc3512::TelemetrySource m_telemetry{"Drivetrain",
+                                         {"Pose x (m)", "Pose y (m)",
+                                          "Pose heading (rad)",
+                                          "Left velocity (m/s)",
+                                          "Right velocity (m/s)"}};
+    frc3512::SignalRecorder m_trajectoryRecorder{"trajectory",
+                                                 {"Reference x (m)",
+                                                  "Reference y (m)",
+                                                  "Reference heading (rad)",
+                                                  "Estimated x (m)",
+                                                  "Estimated y (m)",
+                                                  "Estimated heading (rad)",
+                                                  "Left output (V)",
+                                                  "Right output (V)"}};
+
+    frc::sim::DifferentialDrivetrainSim m_drivetrainSim{
+        frc::DCMotor::CIM(2), kGearing, kMomentOfInertia, kMass, kWheelRadius,
+        kTrackWidth};
+    std::optional<frc::sim::ADXRS450_GyroSim> m_gyroSim;
+    int m_leftSimPulses = 0;
+    int m_rightSimPulses = 0;
+
+    /**
+     * Returns the counterclockwise heading measured by the gyro, or by the
+     * wheel distances if the gyro isn't ready yet.
+     */
+    frc::Rotation2d GetGyroHeading() const;
+
+    /**
+     * Returns the counterclockwise yaw rate measured by the gyro.
+     */
+    units::radians_per_second_t GetGyroRate() const;
+
+    /**
+     * Calibrates the gyro until a calibration finishes without the wheels
+     * moving, then marks it ready. Runs on m_gyroThread.
+     */
+    void CalibrateGyro();
+
+    /**
+     * Returns the counterclockwise heading from the difference between the
+     * estimated wheel distances.
+     */
+    units::radian_t GetWheelHeading() const;
+
+    /**
+     * Advances the state estimate to now and corrects it with the gyro and
+     * encoders.
+     */
+    void UpdateEstimate();
+
+    /**
+     * Runs the trajectory follower for one controller period.
+     */
+    void UpdateTrajectory();
+
+    /**
+     * Configures a gearbox's leader for Motion Magic with a position
+     * controller channel's gains.
+     *
+     * @param gearbox The gearbox.
+     * @param encoder The encoder attached to the gearbox's leader.
+     * @param gains   The channel's gains.
+     */
+    static void ConfigTalonController(TalonSRXGroup& gearbox,
+                                      const CANEncoder& encoder,
+                                      const PositionController::Gains& gains);
 };
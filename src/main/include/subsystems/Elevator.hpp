@@ -2,31 +2,65 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
 #include <atomic>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonSRX.h>
 #include <frc/Solenoid.h>
-#include <frc/controller/ProfiledPIDController.h>
+#include <frc/controller/ElevatorFeedforward.h>
+#include <frc/controller/LinearQuadraticRegulator.h>
+#include <frc/simulation/ElevatorSim.h>
+#include <frc/system/LinearSystem.h>
+#include <frc/system/plant/DCMotor.h>
+#include <frc/system/plant/LinearSystemId.h>
 #include <frc2/Timer.h>
+#include <frc2/controller/PIDController.h>
 #include <units/acceleration.h>
 #include <units/length.h>
+#include <units/mass.h>
+#include <units/time.h>
 #include <units/velocity.h>
 #include <units/voltage.h>
 
 #include "CANDigitalInput.hpp"
 #include "CANEncoder.hpp"
+#include "CoalescedTalonOutput.hpp"
+#include "Constants.hpp"
+#include "SCurveProfile.hpp"
+#include "SignalRecorder.hpp"
 #include "StateMachine.hpp"
 #include "TalonSRXGroup.hpp"
+#include "TelemetryPublisher.hpp"
+#include "Tunables.hpp"
 
 /**
  * Provides an interface for the robot's elevator
  */
 class Elevator {
 public:
+    using Profile = frc3512::SCurveProfile<units::inches>;
+
+    /**
+     * Selects the lift's feedback controller. Both run on top of a
+     * feedforward computed from the lift model.
+     */
+    enum class FeedbackMode {
+        /// PD on the height error with gains from the LQR below
+        kPD,
+
+        /// LQR on height and the encoder's velocity
+        kLQR
+    };
+
     enum IntakeMotorState {
         S_STOPPED,
         S_FORWARD,
@@ -53,8 +87,85 @@ public:
     static constexpr units::feet_per_second_squared_t kMaxADown =
         91.26_in / 1_s / 0.4_s;
     static constexpr units::feet_per_second_t kMaxVDownZeroing = 35.63_in / 1_s;
+    static constexpr Profile::Jerk_t kMaxJUp = kMaxAUp / 0.1_s;
+    static constexpr Profile::Jerk_t kMaxJDown = kMaxADown / 0.1_s;
+
+    // AtGoal() requires the height to be this close to the goal
+    static constexpr units::inch_t kPositionTolerance = 0.25_in;
+
+    // Lift model shared by the simulation, the feedforward, and the LQR: two
+    // CIMs through a 5:1 reduction winding a 1 in drum. The real lift hasn't
+    // been measured. The reduction was picked so the model can reach kMaxVUp,
+    // so it only stands in for the real one until the lift is characterized.
+    static constexpr double kGearing = 5.0;
+    static constexpr units::kilogram_t kCarriageMass = 10_kg;
+    static constexpr units::meter_t kDrumRadius = 1_in;
+
+    // Set to true once the model above has been fit to the real lift. Until
+    // then, the roboRIO runs feedback only, with kUncharacterizedP, and
+    // ignores kLQR. The simulation always uses the model.
+    static constexpr bool kModelCharacterized = false;
+
+    // The P gain of the lift's controller before it had a model: 3.0 of full
+    // output per inch of error, in volts per inch
+    static constexpr double kUncharacterizedP = 3.0 * 12.0;
 
-    Elevator();
+    // Time for the tine and intake cylinders to finish a stroke after their
+    // solenoids switch
+    static constexpr units::second_t kCylinderStrokeTime = 0.1_s;
+
+    // Lift encoder distance per pulse in inches
+    static constexpr double kDistancePerPulse = 70.5 / 5090.0;
+
+    // Commands that can wait behind a running auto-stack cycle or preset move
+    static constexpr size_t kMaxQueuedCommands = 4;
+
+    // Motion Magic smoothing used when the Talon runs the lift's controller.
+    // It approximates the acceleration ramp of the S-curve profile.
+    static constexpr int kMotionMagicSCurveStrength = 4;
+
+    // Heights and constraints read from tunables.txt in the deploy directory
+    // so they can be changed without rebuilding. The constants above are their
+    // defaults. The jerk limits aren't tunable.
+    const frc3512::Tunable<units::inch_t> toteHeight1{
+        "Elevator/Tote height 1 (in)", kToteHeight1};
+    const frc3512::Tunable<units::inch_t> toteHeight2{
+        "Elevator/Tote height 2 (in)", kToteHeight2};
+    const frc3512::Tunable<units::inch_t> toteHeight3{
+        "Elevator/Tote height 3 (in)", kToteHeight3};
+    const frc3512::Tunable<units::inch_t> toteHeight4{
+        "Elevator/Tote height 4 (in)", kToteHeight4};
+    const frc3512::Tunable<units::inch_t> toteHeight5{
+        "Elevator/Tote height 5 (in)", kToteHeight5};
+    const frc3512::Tunable<units::inch_t> garbageCanHeight{
+        "Elevator/Garbage can height (in)", kGarbageCanHeight};
+    const frc3512::Tunable<units::inch_t> autoDropHeight{
+        "Elevator/Auto-stack drop height (in)", kAutoDropHeight};
+    const frc3512::Tunable<units::feet_per_second_t> maxVUp{
+        "Elevator/Max up velocity (ft/s)", kMaxVUp};
+    const frc3512::Tunable<units::feet_per_second_squared_t> maxAUp{
+        "Elevator/Max up acceleration (ft/s^2)", kMaxAUp};
+    const frc3512::Tunable<units::feet_per_second_t> maxVDown{
+        "Elevator/Max down velocity (ft/s)", kMaxVDown};
+    const frc3512::Tunable<units::feet_per_second_squared_t> maxADown{
+        "Elevator/Max down acceleration (ft/s^2)", kMaxADown};
+    const frc3512::Tunable<units::feet_per_second_t> maxVDownZeroing{
+        "Elevator/Max zeroing velocity (ft/s)", kMaxVDownZeroing};
+
+    /**
+     * Constructs an Elevator.
+     *
+     * @param feedbackMode       The feedback controller used when the roboRIO
+     *                           runs the lift's controller. On the robot,
+     *                           it's ignored until kModelCharacterized.
+     * @param controllerLocation Where the lift's controller runs. On the Talon,
+     *                           Motion Magic follows a trapezoid profile with
+     *                           the PD gains and the velocity and gravity
+     *                           feedforwards.
+     */
+    explicit Elevator(FeedbackMode feedbackMode = FeedbackMode::kPD,
+                      TalonSRXGroup::ControllerLocation controllerLocation =
+                          TalonSRXGroup::ControllerLocation::kRoboRIO);
 
     // Actuates elevator tines in/out
     void ElevatorGrab(bool state);
@@ -90,27 +201,133 @@ public:
     // Returns if controller is at goal
     bool AtGoal() const;
 
+    // Returns the goal of the elevator height motion profile
+    units::meter_t GetGoal() const;
+
+    // Sets the motion profile constraints used when raising the elevator in
+    // place of maxVUp and maxAUp. The jerk limit stays kMaxJUp.
+    void SetUpConstraints(units::feet_per_second_t maxVelocity,
+                          units::feet_per_second_squared_t maxAcceleration);
+
     void ResetEncoders();
 
-    // Takes a string representing the name of the height
-    void RaiseElevator(units::meter_t level);
+    // Plans the profile a move from the current setpoint to each preset
+    // height would use and evaluates the controller along it on scratch
+    // state, so the first move of an autonomous mode doesn't run cold. The
+    // elevator's goal and outputs don't change.
+    void WarmUp();
+
+    // Moves the elevator to a height. While an auto-stack cycle or queued move
+    // is running or waiting to start, the move is queued behind it instead.
+    // Returns false if the queue is full.
+    bool RaiseElevator(units::meter_t level);
 
-    void StackTotes();
+    // Queues an auto-stack cycle. Each cycle starts as soon as the command
+    // ahead of it finishes. Returns false if the queue is full.
+    bool StackTotes();
+
+    // Returns true while an auto-stack cycle or queued move is running
     bool IsStacking() const;
+
+    // Stops the running command and drops the queued ones
     void CancelStack();
 
+    // Returns the number of commands waiting to run
+    size_t GetQueuedCommandCount() const;
+
+    // Overlaps the auto-stack phases instead of running each to completion.
+    // The lift starts down once the tines have had a stroke to open, and the
+    // tines and intake close when the motion profile predicts the lift will
+    // arrive within a stroke rather than after it arrives.
+    void SetPipelinedStacking(bool on);
+    bool IsPipelinedStacking() const;
+
     // Periodically update the tote auto stacking state
     void UpdateState();
 
+    // Runs the lift's closed-loop control. ControllerScheduler calls this
+    // every Constants::kControllerPeriod.
+    void UpdateController();
+
+    // Writes the controller signals recorded since the last flush to a file
+    // in the given directory in the background
+    void FlushSignals(std::string_view directory);
+
+    // Steps the lift physics model by dt and feeds it to the simulated encoder
+    // and limit switch
+    void SimulationPeriodic(units::second_t dt);
+
 private:
+    enum class AutoStackState {
+        kIdle,
+        kWaitInitialHeight,
+        kSeekDropTotes,
+        kRelease,
+        kSeekGround,
+        kGrab,
+        kSeekHalfTote,
+        kIntakeIn,
+        kSeekPreset,
+        kNumStates
+    };
+
+    /**
+     * A request waiting in the command queue.
+     */
+    struct Command {
+        enum class Type { kStack, kRaise };
+
+        Type type = Type::kStack;
+
+        // The height of a kRaise
+        units::meter_t height = 0_m;
+
+        // The time the input that queued it was read, for LatencyTracer. Zero
+        // if it wasn't traced.
+        uint64_t inputTime = 0;
+    };
+
+    /**
+     * Everything UpdateController() reads or writes each tick besides the
+     * sensors and motors.
+     *
+     * It's kept together at the front of the object and aligned to the
+     * Cortex-A9's 32-byte cache lines, so a tick touches a few adjacent lines
+     * instead of ones scattered between the hardware handles, the simulation
+     * model and the auto-stack state machine that follow it.
+     */
+    struct alignas(32) ControllerState {
+        FeedbackMode feedbackMode = FeedbackMode::kPD;
+        TalonSRXGroup::ControllerLocation controllerLocation =
+            TalonSRXGroup::ControllerLocation::kRoboRIO;
+        bool manual = false;
+        bool atSetpoint = false;
+        bool lastLimitSwitchValue = false;
+
+        // The input time of a traced goal the lift hasn't been driven toward
+        // yet, or zero
+        uint64_t liftInputTime = 0;
+
+        units::second_t profileTime = 0_s;
+        units::inch_t goal = 0_in;
+        Profile::State setpoint;
+
+        // The gain of the LQR in kLQR mode. The regulator itself is only
+        // needed to compute it.
+        Eigen::Matrix<double, 1, 2> lqrGain;
+
+        Profile profile;
+    };
+
+    ControllerState m_state;
+
     frc::Solenoid m_elevatorGrabber{3};
     frc::Solenoid m_containerGrabber{4};
 
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_liftLeftMotor{7};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_liftRightMotor{2};
     TalonSRXGroup m_liftGrbx{m_liftLeftMotor, m_liftRightMotor};
-    CANEncoder m_liftEncoder{m_liftLeftMotor, 70.5 / 5090.0, true};
-    bool m_manual = false;
+    CANEncoder m_liftEncoder{m_liftLeftMotor, kDistancePerPulse, true};
 
     // Intake
     IntakeMotorState m_intakeState = S_STOPPED;
@@ -118,18 +335,122 @@ private:
     frc::Solenoid m_intakeGrabber{2};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_intakeLeftMotor{3};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_intakeRightMotor{6};
+    CoalescedTalonOutput m_intakeLeftOutput{m_intakeLeftMotor};
+    CoalescedTalonOutput m_intakeRightOutput{m_intakeRightMotor};
+
+    frc::LinearSystem<2, 1, 1> m_liftPlant =
+        frc::LinearSystemId::ElevatorSystem(frc::DCMotor::CIM(2), kCarriageMass,
+                                            kDrumRadius, kGearing);
+    frc::ElevatorFeedforward<units::inches> m_feedforward =
+        MakeFeedforward(m_liftPlant);
+
+    // The PD gains are the LQR's gains with the default weights, in volts per
+    // inch and volts per inch per second
+    frc2::PIDController m_feedback{5.5, 0.0, 0.48,
+                                   frc3512::Constants::kControllerPeriod};
+
+    // Set by SetUpConstraints()
+    std::optional<Profile::Constraints> m_upConstraints;
+
+    // The constraints of the current motion profile
+    Profile::Constraints m_activeConstraints{kMaxVUp, kMaxAUp, kMaxJUp};
+
+    // The constraints last sent to the Talon for Motion Magic
+    Profile::Constraints m_talonConstraints;
 
-    frc::ProfiledPIDController<units::inches> m_controller{
-        3.0, 0.0, 0.0, {kMaxVUp, kMaxAUp}};
     CANDigitalInput m_limitSwitch{m_liftLeftMotor};
-    bool m_lastLimitSwitchValue = false;
 
-    StateMachine m_autoStackSM{"AUTO_STACK"};
+    frc3512::SignalRecorder m_recorder{
+        "elevator",
+        {"Setpoint (in)", "Measurement (in)", "Output (V)", "At goal"}};
+
+    // Indices of the telemetry fields
+    enum TelemetryField : size_t { kHeight, kGoal, kOutput, kAtGoal };
+
+    frc3512::TelemetrySource m_telemetry{
+        "Elevator", {"Height (in)", "Goal (in)", "Output (V)", "At goal"}};
+
+    // Approximate physics model of the lift
+    frc::sim::ElevatorSim m_liftSim{m_liftPlant, frc::DCMotor::CIM(2), kGearing,
+                                    kDrumRadius, 0_in, kMaxHeight};
+    int m_liftSimPulses = 0;
+
+    StateMachine<AutoStackState> m_autoStackSM{"AUTO_STACK"};
     frc2::Timer m_grabTimer;
-    bool m_startAutoStacking = false;
+    bool m_pipelinedStacking = false;
+
+    // Ring buffer of commands run by the auto-stack state machine, oldest at
+    // m_queueHead
+    std::array<Command, kMaxQueuedCommands> m_queue;
+    size_t m_queueHead = 0;
+    size_t m_queueSize = 0;
+
+    // The goal of SEEK_PRESET
+    units::meter_t m_presetGoal = 0_m;
+
+    // The input time of the running command until it sets its first goal
+    uint64_t m_commandInputTime = 0;
+
+    /**
+     * Adds a command to the back of the queue. Returns false if the queue is
+     * full.
+     */
+    bool EnqueueCommand(const Command& command);
+
+    /**
+     * Removes the command at the front of the queue and returns the
+     * auto-stack state that starts it, or IDLE if the queue is empty.
+     */
+    AutoStackState StartNextCommand();
+
+    /**
+     * The goal and constraints of a motion profile to a height.
+     */
+    struct Move {
+        units::inch_t goal;
+        Profile::Constraints constraints;
+    };
+
+    /**
+     * Returns the move SetGoal() plans for a height.
+     *
+     * Moves up use the up constraints. Moves to the ground or below seek past
+     * it at the zeroing velocity until the limit switch stops them.
+     */
+    Move PlanMove(units::meter_t height) const;
 
     /**
      * Set the goal for the elevator height motion profile.
+     *
+     * The profile in flight is kept if the goal and constraints haven't
+     * changed, so this can be called every loop.
      */
     void SetGoal(units::meter_t height);
+
+    /**
+     * Plans a motion profile from the current setpoint to a new goal.
+     *
+     * The new profile starts from the state the last controller tick
+     * commanded, so the next tick continues the motion without a jump in
+     * setpoint or voltage.
+     */
+    void PlanProfile(units::meter_t goal);
+
+    /**
+     * Returns the time left until the motion profile setpoint reaches the
+     * given height.
+     */
+    units::second_t TimeUntilHeight(units::meter_t height) const;
+
+    /**
+     * Returns the gravity, velocity, and acceleration feedforward of a lift
+     * model.
+     */
+    static frc::ElevatorFeedforward<units::inches> MakeFeedforward(
+        const frc::LinearSystem<2, 1, 1>& plant);
+
+    /**
+     * Configures the lift Talon's gains for Motion Magic.
+     */
+    void ConfigTalonController();
 };
@@ -0,0 +1,106 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+// Replays a recorded teleop period through the robot code and reports every
+// output that differs from the recording.
+//
+// The robot records teleop-*.sig and cansensors-*.sig files each time it's
+// disabled. Pass the pair from one match. Replays run as fast as the robot
+// code does, so this also works for profiling the robot code on the inputs
+// from a real match, e.g. under perf.
+//
+// Usage:
+//   replay --teleop <file> --sensors <file> [--tolerance <value>]
+//          [--max-mismatches <count>]
+//
+// Exits with 0 if every output matched, 1 if any differed, and 2 on errors.
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+#include <hal/HAL.h>
+
+#include "MatchReplay.hpp"
+#include "SignalLog.hpp"
+
+namespace {
+
+constexpr int kExitMismatch = 1;
+constexpr int kExitError = 2;
+
+void PrintUsage(const char* program) {
+    fmt::print(stderr,
+               "Usage: {} --teleop <file> --sensors <file> "
+               "[--tolerance <value>] [--max-mismatches <count>]\n",
+               program);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string teleopFile;
+    std::string sensorsFile;
+    float tolerance = 1e-4f;
+    size_t maxMismatches = 20;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--help") {
+            PrintUsage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 == argc) {
+            PrintUsage(argv[0]);
+            return kExitError;
+        }
+
+        if (arg == "--teleop") {
+            teleopFile = argv[++i];
+        } else if (arg == "--sensors") {
+            sensorsFile = argv[++i];
+        } else if (arg == "--tolerance") {
+            tolerance = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--max-mismatches") {
+            maxMismatches = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return kExitError;
+        }
+    }
+
+    if (teleopFile.empty() || sensorsFile.empty()) {
+        PrintUsage(argv[0]);
+        return kExitError;
+    }
+
+    try {
+        SignalLog teleop{teleopFile};
+        SignalLog sensors{sensorsFile};
+
+        HAL_Initialize(500, 0);
+
+        auto result = ReplayTeleop(teleop, sensors, tolerance);
+
+        for (size_t i = 0;
+             i < result.mismatches.size() && i < maxMismatches; ++i) {
+            const auto& mismatch = result.mismatches[i];
+            fmt::print("Loop {}: {} was {}, replayed as {}\n",
+                       mismatch.sample, mismatch.signal, mismatch.recorded,
+                       mismatch.replayed);
+        }
+        if (result.mismatches.size() > maxMismatches) {
+            fmt::print("... and {} more\n",
+                       result.mismatches.size() - maxMismatches);
+        }
+        fmt::print("Replayed {} loops with {} mismatched outputs\n",
+                   result.samples, result.mismatches.size());
+
+        return result.mismatches.empty() ? EXIT_SUCCESS : kExitMismatch;
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return kExitError;
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AutonomousSimulation.hpp"
+
+#include <thread>
+
+#include <frc/simulation/DriverStationSim.h>
+#include <frc/simulation/SimHooks.h>
+#include <frc2/Timer.h>
+#include <units/math.h>
+
+#include "Robot.hpp"
+
+AutonomousResult SimulateAutonomous(wpi::StringRef name,
+                                    std::function<void(Robot&)> configure,
+                                    units::second_t timeout) {
+    frc::sim::PauseTiming();
+
+    frc::sim::DriverStationSim::ResetData();
+    frc::sim::DriverStationSim::SetDsAttached(true);
+    frc::sim::DriverStationSim::SetAutonomous(true);
+    frc::sim::DriverStationSim::SetEnabled(false);
+    frc::sim::DriverStationSim::NotifyNewData();
+
+    AutonomousResult result;
+
+    Robot robot;
+    robot.SelectAutonomous(name);
+    if (configure) {
+        configure(robot);
+    }
+
+    std::thread robotThread{[&] { robot.StartCompetition(); }};
+
+    // Wait for the robot to reach its first loop
+    frc::sim::StepTiming(0_s);
+
+    frc::sim::DriverStationSim::SetEnabled(true);
+    frc::sim::DriverStationSim::NotifyNewData();
+
+    // The first step runs AutonomousInit(), which starts the mode
+    auto start = frc2::Timer::GetFPGATimestamp();
+    do {
+        frc::sim::StepTiming(robot.GetPeriod());
+        result.duration = frc2::Timer::GetFPGATimestamp() - start;
+    } while (robot.IsAutonomousRunning() && result.duration < timeout);
+
+    result.finished = !robot.IsAutonomousRunning();
+    result.leftDistance = robot.drivetrain.GetLeftDistance();
+    result.rightDistance = robot.drivetrain.GetRightDistance();
+    result.elevatorHeight = robot.elevator.GetHeight();
+    result.pose = robot.drivetrain.GetSimulatedPose();
+    result.elevatorGoal = robot.elevator.GetGoal();
+    result.elevatorError =
+        units::math::abs(result.elevatorGoal - result.elevatorHeight);
+
+    // Disabling the robot makes an unfinished mode return
+    frc::sim::DriverStationSim::SetEnabled(false);
+    frc::sim::DriverStationSim::NotifyNewData();
+    frc::sim::StepTiming(robot.GetPeriod());
+
+    robot.EndCompetition();
+    robotThread.join();
+
+    return result;
+}
@@ -0,0 +1,228 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "MatchReplay.hpp"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <string_view>
+#include <thread>
+
+#include <fmt/format.h>
+#include <frc/RobotController.h>
+#include <frc/simulation/DriverStationSim.h>
+#include <frc/simulation/RoboRioSim.h>
+#include <frc/simulation/SimHooks.h>
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <networktables/NetworkTableInstance.h>
+
+#include "CANSensorSnapshot.hpp"
+#include "Robot.hpp"
+#include "SignalLog.hpp"
+
+namespace {
+
+/**
+ * The recorded input columns of one joystick.
+ */
+struct JoystickColumns {
+    int port;
+    int axis;
+    const std::vector<float>* axisValues;
+    const std::vector<float>* buttons;
+    const std::vector<float>* pov;
+};
+
+/**
+ * The recorded columns of one Talon in the CAN sensor file.
+ */
+struct TalonColumns {
+    const std::vector<float>* position;
+    const std::vector<float>* velocity;
+    const std::vector<float>* limitSwitches;
+};
+
+/**
+ * Returns the columns of every Talon in a CAN sensor file by CAN ID.
+ */
+std::map<int, TalonColumns> FindTalons(const SignalLog& sensors) {
+    constexpr std::string_view kPrefix = "talon";
+    constexpr std::string_view kSuffix = " position";
+
+    std::map<int, TalonColumns> talons;
+    for (std::string_view signal : sensors.GetSignals()) {
+        if (signal.size() <= kPrefix.size() + kSuffix.size() ||
+            signal.substr(0, kPrefix.size()) != kPrefix ||
+            signal.substr(signal.size() - kSuffix.size()) != kSuffix) {
+            continue;
+        }
+
+        int id = std::atoi(signal.data() + kPrefix.size());
+        auto column = [&](std::string_view name) {
+            return &sensors.GetColumn(fmt::format("talon{} {}", id, name));
+        };
+        talons.emplace(id, TalonColumns{column("position"), column("velocity"),
+                                        column("limit switches")});
+    }
+    return talons;
+}
+
+/**
+ * Sets a joystick's axis, buttons, and POV hat to their values in a sample.
+ */
+void SetJoystick(const JoystickColumns& joystick, size_t sample) {
+    using frc::sim::DriverStationSim;
+
+    DriverStationSim::SetJoystickAxis(joystick.port, joystick.axis,
+                                      (*joystick.axisValues)[sample]);
+    if (joystick.buttons != nullptr) {
+        DriverStationSim::SetJoystickButtons(
+            joystick.port, static_cast<uint32_t>((*joystick.buttons)[sample]));
+    }
+    if (joystick.pov != nullptr) {
+        DriverStationSim::SetJoystickPOV(
+            joystick.port, 0, static_cast<int>((*joystick.pov)[sample]));
+    }
+}
+
+}  // namespace
+
+ReplayResult ReplayTeleop(const SignalLog& teleop, const SignalLog& sensors,
+                          float tolerance) {
+    // Matches the ports and axes read by Robot::TeleopPeriodic()
+    const std::array<JoystickColumns, 3> joysticks{{
+        {0, 1, &teleop.GetColumn("driveStick1 y"), nullptr, nullptr},
+        {1, 0, &teleop.GetColumn("driveStick2 x"),
+         &teleop.GetColumn("driveStick2 buttons"),
+         &teleop.GetColumn("driveStick2 pov")},
+        {2, 1, &teleop.GetColumn("appendageStick y"),
+         &teleop.GetColumn("appendageStick buttons"),
+         &teleop.GetColumn("appendageStick pov")},
+    }};
+    const auto& pipelinedStacking = teleop.GetColumn("pipelined stacking");
+
+    // Files recorded before the battery voltage was logged replay at 12 V
+    const std::vector<float>* batteryVoltage = nullptr;
+    if (teleop.HasSignal("battery voltage")) {
+        batteryVoltage = &teleop.GetColumn("battery voltage");
+    }
+
+    std::array<const std::vector<float>*, Robot::kTeleopOutputSignals.size()>
+        recordedOutputs;
+    for (size_t i = 0; i < recordedOutputs.size(); ++i) {
+        recordedOutputs[i] =
+            &teleop.GetColumn(Robot::kTeleopOutputSignals[i]);
+    }
+
+    // Recorded FPGA time minus replayed FPGA time. It's realigned before each
+    // loop so jitter in the recorded loop period doesn't accumulate.
+    std::atomic<int64_t> timeOffset{0};
+
+    // Talons missing from the file read as zero
+    auto talons = FindTalons(sensors);
+    auto& snapshot = CANSensorSnapshot::GetInstance();
+    snapshot.SetReadingSource([&](int deviceID) {
+        CANSensorSnapshot::Reading reading;
+
+        auto it = talons.find(deviceID);
+        if (it == talons.end() || sensors.GetSize() == 0) {
+            return reading;
+        }
+
+        int64_t now = static_cast<int64_t>(
+                          frc::RobotController::GetFPGATime()) +
+                      timeOffset.load();
+        size_t sample = sensors.FindSample(static_cast<uint64_t>(
+            std::max<int64_t>(now, 0)));
+        const auto& columns = it->second;
+        reading.quadraturePosition =
+            static_cast<int>((*columns.position)[sample]);
+        reading.quadratureVelocity =
+            static_cast<int>((*columns.velocity)[sample]);
+        int limitSwitches = static_cast<int>((*columns.limitSwitches)[sample]);
+        reading.isFwdLimitSwitchClosed = (limitSwitches & 1) != 0;
+        reading.isRevLimitSwitchClosed = (limitSwitches & 2) != 0;
+        return reading;
+    });
+
+    frc::sim::PauseTiming();
+
+    frc::sim::DriverStationSim::ResetData();
+    frc::sim::DriverStationSim::SetDsAttached(true);
+    frc::sim::DriverStationSim::SetAutonomous(false);
+    frc::sim::DriverStationSim::SetEnabled(false);
+    for (const auto& joystick : joysticks) {
+        frc::sim::DriverStationSim::SetJoystickAxisCount(joystick.port, 6);
+        frc::sim::DriverStationSim::SetJoystickButtonCount(joystick.port, 12);
+        frc::sim::DriverStationSim::SetJoystickPOVCount(joystick.port, 1);
+    }
+    frc::sim::DriverStationSim::NotifyNewData();
+
+    ReplayResult result;
+
+    {
+        Robot robot;
+        std::thread robotThread{[&] { robot.StartCompetition(); }};
+
+        // Wait for the robot to reach its first loop
+        frc::sim::StepTiming(0_s);
+
+        frc::sim::DriverStationSim::SetEnabled(true);
+
+        // The first step runs TeleopInit(), then the first TeleopPeriodic()
+        auto period = robot.GetPeriod();
+        for (size_t sample = 0; sample < teleop.GetSize(); ++sample) {
+            for (const auto& joystick : joysticks) {
+                SetJoystick(joystick, sample);
+            }
+            frc::SmartDashboard::PutBoolean("Pipelined stacking",
+                                            pipelinedStacking[sample] != 0.f);
+
+            // The robot reads the setting through an entry listener, so let
+            // it run before the loop does
+            nt::NetworkTableInstance::GetDefault().WaitForEntryListenerQueue(
+                -1.0);
+            if (batteryVoltage != nullptr) {
+                frc::sim::RoboRioSim::SetVInVoltage(
+                    units::volt_t{(*batteryVoltage)[sample]});
+            }
+            frc::sim::DriverStationSim::NotifyNewData();
+
+            // The loop runs at the end of the step, so align that with the
+            // recorded loop
+            auto loopTime = frc::RobotController::GetFPGATime() +
+                            static_cast<uint64_t>(period.to<double>() * 1e6);
+            timeOffset = static_cast<int64_t>(teleop.GetTimestamp(sample)) -
+                         static_cast<int64_t>(loopTime);
+
+            frc::sim::StepTiming(period);
+
+            auto outputs = robot.GetTeleopOutputs();
+            for (size_t i = 0; i < outputs.size(); ++i) {
+                float recorded = (*recordedOutputs[i])[sample];
+                if (std::abs(outputs[i] - recorded) > tolerance) {
+                    result.mismatches.push_back(
+                        {sample, std::string{Robot::kTeleopOutputSignals[i]},
+                         recorded, outputs[i]});
+                }
+            }
+            ++result.samples;
+        }
+
+        frc::sim::DriverStationSim::SetEnabled(false);
+        frc::sim::DriverStationSim::NotifyNewData();
+        frc::sim::StepTiming(period);
+
+        robot.EndCompetition();
+        robotThread.join();
+    }
+
+    snapshot.SetReadingSource(nullptr);
+
+    return result;
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "SignalLog.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "SignalRecorder.hpp"
+
+namespace {
+
+// Matches FileHeader in SignalRecorder.cpp
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numSignals;
+    uint32_t numSamples;
+    uint32_t reserved;
+    uint64_t startTime;
+};
+
+constexpr char kMagic[8] = {'F', '3', '5', '1', '2', 'S', 'I', 'G'};
+
+struct FileCloser {
+    void operator()(std::FILE* file) const { std::fclose(file); }
+};
+
+}  // namespace
+
+SignalLog::SignalLog(const std::string& path) {
+    std::unique_ptr<std::FILE, FileCloser> file{std::fopen(path.c_str(), "rb")};
+    if (!file) {
+        throw std::runtime_error{fmt::format("couldn't open {}", path)};
+    }
+
+    auto read = [&](void* data, size_t size) {
+        if (size > 0 && std::fread(data, size, 1, file.get()) != 1) {
+            throw std::runtime_error{fmt::format("{} is truncated", path)};
+        }
+    };
+
+    FileHeader header;
+    read(&header, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error{
+            fmt::format("{} isn't a signal file", path)};
+    }
+    if (header.version != frc3512::SignalRecorder::kVersion) {
+        throw std::runtime_error{fmt::format(
+            "{} is version {}, but version {} is supported", path,
+            header.version, frc3512::SignalRecorder::kVersion)};
+    }
+    m_startTime = header.startTime;
+
+    for (uint32_t i = 0; i < header.numSignals; ++i) {
+        uint16_t length;
+        read(&length, sizeof(length));
+        std::string signal(length, '\0');
+        read(signal.data(), length);
+        m_signals.emplace_back(std::move(signal));
+    }
+
+    m_timestamps.resize(header.numSamples);
+    read(m_timestamps.data(), header.numSamples * sizeof(uint32_t));
+
+    m_columns.resize(header.numSignals);
+    for (auto& column : m_columns) {
+        column.resize(header.numSamples);
+        read(column.data(), header.numSamples * sizeof(float));
+    }
+}
+
+size_t SignalLog::GetSize() const { return m_timestamps.size(); }
+
+const std::vector<std::string>& SignalLog::GetSignals() const {
+    return m_signals;
+}
+
+bool SignalLog::HasSignal(std::string_view signal) const {
+    return std::find(m_signals.begin(), m_signals.end(), signal) !=
+           m_signals.end();
+}
+
+uint64_t SignalLog::GetTimestamp(size_t sample) const {
+    return m_startTime + m_timestamps[sample];
+}
+
+size_t SignalLog::FindSample(uint64_t timestamp) const {
+    if (timestamp < m_startTime) {
+        return 0;
+    }
+
+    uint64_t offset = timestamp - m_startTime;
+    auto it = std::upper_bound(m_timestamps.begin(), m_timestamps.end(),
+                               offset, [](uint64_t value, uint32_t sample) {
+                                   return value < sample;
+                               });
+    if (it == m_timestamps.begin()) {
+        return 0;
+    }
+    return static_cast<size_t>(it - m_timestamps.begin()) - 1;
+}
+
+const std::vector<float>& SignalLog::GetColumn(std::string_view signal) const {
+    auto it = std::find(m_signals.begin(), m_signals.end(), signal);
+    if (it == m_signals.end()) {
+        throw std::out_of_range{
+            fmt::format("the signal file has no '{}' signal", signal)};
+    }
+    return m_columns[it - m_signals.begin()];
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <functional>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <wpi/StringRef.h>
+
+class Robot;
+
+/**
+ * The outcome of one simulated autonomous mode.
+ */
+struct AutonomousResult {
+    // True if the mode returned before the timeout
+    bool finished = false;
+
+    // Simulated time from enabling the robot until the mode returned or timed
+    // out
+    units::second_t duration = 0_s;
+
+    // Robot state at the end of the run
+    units::inch_t leftDistance = 0_in;
+    units::inch_t rightDistance = 0_in;
+    units::inch_t elevatorHeight = 0_in;
+
+    // Pose of the drivetrain physics model relative to where the robot started
+    frc::Pose2d pose;
+
+    // Goal of the elevator's motion profile and how far the elevator was from
+    // it
+    units::inch_t elevatorGoal = 0_in;
+    units::inch_t elevatorError = 0_in;
+};
+
+/**
+ * Runs an autonomous mode on a new Robot in simulated time.
+ *
+ * The HAL's clock is paused and stepped one robot loop at a time, so the run is
+ * deterministic and only takes as long as the robot code does to execute.
+ *
+ * Only one simulation can run in a process at a time because the HAL's state
+ * is global. Run each simulation in its own process to run them in parallel.
+ *
+ * @param name      Name of the autonomous mode.
+ * @param configure Called with the Robot before it's enabled so tunable
+ *                  parameters can be changed. May be empty.
+ * @param timeout   Simulated time after which the mode is abandoned.
+ */
+AutonomousResult SimulateAutonomous(
+    wpi::StringRef name, std::function<void(Robot&)> configure = nullptr,
+    units::second_t timeout = 15_s);
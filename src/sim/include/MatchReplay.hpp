@@ -0,0 +1,60 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+class SignalLog;
+
+/**
+ * A teleop output that differed between a recording and its replay.
+ */
+struct ReplayMismatch {
+    // Index of the TeleopPeriodic() call in the recording
+    size_t sample = 0;
+
+    std::string signal;
+    float recorded = 0.f;
+    float replayed = 0.f;
+};
+
+/**
+ * The outcome of replaying a recorded teleop period.
+ */
+struct ReplayResult {
+    // Number of TeleopPeriodic() calls replayed
+    size_t samples = 0;
+
+    // Every output that differed, in the order they happened
+    std::vector<ReplayMismatch> mismatches;
+};
+
+/**
+ * Reruns a recorded teleop period on a new Robot in simulated time.
+ *
+ * The teleop signal file recorded by Robot supplies the joystick inputs of
+ * each TeleopPeriodic(), and the CAN sensor file recorded by
+ * CANSensorSnapshot supplies the encoder and limit switch readings. The HAL's
+ * clock is stepped one robot loop at a time, as fast as the robot code runs,
+ * and aligned with the recorded loop timestamps so the controller ticks in
+ * between see the readings recorded at the same point in the loop. After each
+ * loop, the robot's teleop outputs are compared with the recorded ones.
+ *
+ * Inputs that aren't recorded, like the gyro and battery voltage, come from
+ * the simulation instead, so closed-loop signals that depend on them may
+ * differ.
+ *
+ * Only one replay or simulation can run in a process at a time because the
+ * HAL's state is global. Run each replay in its own process to run them in
+ * parallel.
+ *
+ * @param teleop    A teleop signal file.
+ * @param sensors   The CAN sensor signal file recorded in the same match.
+ * @param tolerance The largest difference between a recorded and replayed
+ *                  output that isn't a mismatch.
+ */
+ReplayResult ReplayTeleop(const SignalLog& teleop, const SignalLog& sensors,
+                          float tolerance = 1e-4f);
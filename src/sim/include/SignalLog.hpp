@@ -0,0 +1,71 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A signal file written by frc3512::SignalRecorder, loaded into memory.
+ */
+class SignalLog {
+public:
+    /**
+     * Reads a signal file.
+     *
+     * @param path The file.
+     * @throws std::runtime_error if the file can't be read or isn't a signal
+     *         file of the current version.
+     */
+    explicit SignalLog(const std::string& path);
+
+    /**
+     * Returns the number of samples.
+     */
+    size_t GetSize() const;
+
+    /**
+     * Returns the names of the signals.
+     */
+    const std::vector<std::string>& GetSignals() const;
+
+    /**
+     * Returns true if the file has a signal.
+     *
+     * @param signal The signal's name.
+     */
+    bool HasSignal(std::string_view signal) const;
+
+    /**
+     * Returns the FPGA time in microseconds at which a sample was recorded.
+     *
+     * @param sample The sample's index.
+     */
+    uint64_t GetTimestamp(size_t sample) const;
+
+    /**
+     * Returns the index of the last sample recorded at or before a time, or
+     * the first sample if they were all recorded after it.
+     *
+     * @param timestamp FPGA time in microseconds.
+     */
+    size_t FindSample(uint64_t timestamp) const;
+
+    /**
+     * Returns every sample of a signal.
+     *
+     * @param signal The signal's name.
+     * @throws std::out_of_range if the file doesn't have the signal.
+     */
+    const std::vector<float>& GetColumn(std::string_view signal) const;
+
+private:
+    uint64_t m_startTime = 0;
+    std::vector<uint32_t> m_timestamps;
+    std::vector<std::string> m_signals;
+    std::vector<std::vector<float>> m_columns;
+};
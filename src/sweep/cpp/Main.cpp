@@ -0,0 +1,461 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+// Runs an autonomous mode in simulation over a grid of parameter values and
+// writes the outcome of each run to a CSV file.
+//
+// The HAL's state is global, so only one Robot can exist per process. The
+// sweep process never initializes the HAL. Instead, it reruns its own
+// executable in worker mode once per grid point, keeping up to one worker per
+// host core running at a time. Each worker runs in its own temporary directory
+// so the logs it writes can't collide with those of other workers.
+//
+// Usage:
+//   sweep --mode <name> [--param <name>=<v1>,<v2>,...]... [--output <file>]
+//         [--jobs <count>]
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <hal/HAL.h>
+
+#include "AutonomousSimulation.hpp"
+#include "Robot.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * The tunable values a worker applies to its Robot before enabling it.
+ */
+struct SweepConfig {
+    AutoOneToteConfig autoOneTote;
+    units::feet_per_second_t elevatorMaxVUp = Elevator::kMaxVUp;
+    units::feet_per_second_squared_t elevatorMaxAUp = Elevator::kMaxAUp;
+};
+
+struct Parameter {
+    const char* name;
+    const char* description;
+    void (*apply)(SweepConfig& config, double value);
+};
+
+const std::array<Parameter, 10> kParameters{{
+    {"approachPower", "AutoOneTote drive power toward the tote",
+     [](SweepConfig& c, double v) { c.autoOneTote.approachPower = v; }},
+    {"approachTime", "AutoOneTote drive time toward the tote (s)",
+     [](SweepConfig& c, double v) {
+         c.autoOneTote.approachTime = units::second_t{v};
+     }},
+    {"intakeTime", "AutoOneTote intake time (s)",
+     [](SweepConfig& c, double v) {
+         c.autoOneTote.intakeTime = units::second_t{v};
+     }},
+    {"turnThrottle", "AutoOneTote throttle while turning",
+     [](SweepConfig& c, double v) { c.autoOneTote.turnThrottle = v; }},
+    {"turnRate", "AutoOneTote turn rate",
+     [](SweepConfig& c, double v) { c.autoOneTote.turnRate = v; }},
+    {"turnTime", "AutoOneTote turn time (s)",
+     [](SweepConfig& c, double v) {
+         c.autoOneTote.turnTime = units::second_t{v};
+     }},
+    {"retreatPower", "AutoOneTote drive power away from the tote",
+     [](SweepConfig& c, double v) { c.autoOneTote.retreatPower = v; }},
+    {"retreatTime", "AutoOneTote drive time away from the tote (s)",
+     [](SweepConfig& c, double v) {
+         c.autoOneTote.retreatTime = units::second_t{v};
+     }},
+    {"elevatorMaxVUp", "Elevator velocity limit when raising (in/s)",
+     [](SweepConfig& c, double v) {
+         c.elevatorMaxVUp = units::inch_t{v} / 1_s;
+     }},
+    {"elevatorMaxAUp", "Elevator acceleration limit when raising (in/s^2)",
+     [](SweepConfig& c, double v) {
+         c.elevatorMaxAUp = units::inch_t{v} / 1_s / 1_s;
+     }},
+}};
+
+constexpr const char* kResultColumns =
+    "status,duration_s,x_m,y_m,heading_deg,elevator_height_in,"
+    "elevator_goal_in,elevator_error_in";
+
+const Parameter* FindParameter(std::string_view name) {
+    for (const auto& parameter : kParameters) {
+        if (name == parameter.name) {
+            return &parameter;
+        }
+    }
+    throw std::invalid_argument{fmt::format("unknown parameter '{}'", name)};
+}
+
+/**
+ * Splits "name=value" into its name and value.
+ */
+std::pair<std::string_view, std::string_view> SplitAssignment(
+    std::string_view arg) {
+    auto pos = arg.find('=');
+    if (pos == std::string_view::npos) {
+        throw std::invalid_argument{
+            fmt::format("expected <name>=<value>, got '{}'", arg)};
+    }
+    return {arg.substr(0, pos), arg.substr(pos + 1)};
+}
+
+double ParseValue(std::string_view value) {
+    std::string str{value};
+    size_t length = 0;
+    double result = 0.0;
+    try {
+        result = std::stod(str, &length);
+    } catch (const std::logic_error&) {
+    }
+    if (length == 0 || length != str.size()) {
+        throw std::invalid_argument{
+            fmt::format("'{}' isn't a number", value)};
+    }
+    return result;
+}
+
+void PrintUsage(const char* program) {
+    fmt::print(stderr,
+               "Usage: {} --mode <name> [--param <name>=<v1>,<v2>,...]... "
+               "[--output <file>] [--jobs <count>]\n\n"
+               "Every combination of the parameter values is simulated. "
+               "Parameters:\n",
+               program);
+    for (const auto& parameter : kParameters) {
+        fmt::print(stderr, "  {:<16} {}\n", parameter.name,
+                   parameter.description);
+    }
+}
+
+/**
+ * Runs one simulation and writes its result columns to a file.
+ *
+ * Arguments are --mode <name> --result <file> --workdir <dir> followed by any
+ * number of --set <name>=<value>.
+ */
+int RunWorker(int argc, char* argv[]) {
+    std::string mode;
+    std::string resultFile;
+    std::string workdir;
+    SweepConfig config;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string_view arg = argv[i];
+        if (arg == "--mode") {
+            mode = argv[i + 1];
+        } else if (arg == "--result") {
+            resultFile = argv[i + 1];
+        } else if (arg == "--workdir") {
+            workdir = argv[i + 1];
+        } else if (arg == "--set") {
+            auto [name, value] = SplitAssignment(argv[i + 1]);
+            FindParameter(name)->apply(config, ParseValue(value));
+        }
+    }
+
+    // Logs written by the robot code go into the worker's own directory
+    fs::current_path(workdir);
+
+    HAL_Initialize(500, 0);
+
+    auto result = SimulateAutonomous(mode, [&](Robot& robot) {
+        const auto& names = robot.GetAutonomousNames();
+        if (std::find(names.begin(), names.end(), mode) == names.end()) {
+            throw std::invalid_argument{
+                fmt::format("unknown autonomous mode '{}'", mode)};
+        }
+
+        robot.autoOneToteConfig = config.autoOneTote;
+        robot.elevator.SetUpConstraints(config.elevatorMaxVUp,
+                                        config.elevatorMaxAUp);
+    });
+
+    std::FILE* file = std::fopen(resultFile.c_str(), "w");
+    if (file == nullptr) {
+        return EXIT_FAILURE;
+    }
+    fmt::print(file, "{},{},{},{},{},{},{},{}\n",
+               result.finished ? "finished" : "timeout",
+               result.duration.to<double>(), result.pose.X().to<double>(),
+               result.pose.Y().to<double>(),
+               result.pose.Rotation().Degrees().to<double>(),
+               result.elevatorHeight.to<double>(),
+               result.elevatorGoal.to<double>(),
+               result.elevatorError.to<double>());
+    std::fclose(file);
+
+    return EXIT_SUCCESS;
+}
+
+#ifndef _WIN32
+
+/**
+ * Starts a worker process.
+ *
+ * The worker's stdout is discarded and its stderr goes to a log in its working
+ * directory.
+ *
+ * @param executable Path to this executable.
+ * @param args       Arguments to pass after the executable name.
+ * @param workdir    The worker's working directory.
+ * @return The worker's process ID.
+ */
+pid_t SpawnWorker(const std::string& executable,
+                  const std::vector<std::string>& args,
+                  const fs::path& workdir) {
+    std::string logFile = (workdir / "stderr.log").string();
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, logFile.c_str(),
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    std::vector<char*> argv;
+    argv.emplace_back(const_cast<char*>(executable.c_str()));
+    for (const auto& arg : args) {
+        argv.emplace_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.emplace_back(nullptr);
+
+    pid_t pid = 0;
+    int error = posix_spawn(&pid, executable.c_str(), &actions, nullptr,
+                            argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (error != 0) {
+        throw std::runtime_error{fmt::format("failed to start worker: {}",
+                                             std::strerror(error))};
+    }
+    return pid;
+}
+
+/**
+ * Reads the first line of a file without its newline.
+ */
+std::string ReadLine(const fs::path& path) {
+    std::string line;
+
+    std::FILE* file = std::fopen(path.string().c_str(), "r");
+    if (file == nullptr) {
+        return line;
+    }
+    int c;
+    while ((c = std::fgetc(file)) != EOF && c != '\n') {
+        line += static_cast<char>(c);
+    }
+    std::fclose(file);
+
+    return line;
+}
+
+#endif
+
+int RunSweep(int argc, char* argv[]) {
+    std::string mode;
+    std::string output = "sweep.csv";
+    unsigned int jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::pair<const Parameter*, std::vector<std::string>>> axes;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 == argc) {
+            throw std::invalid_argument{
+                fmt::format("{} requires a value", arg)};
+        }
+
+        std::string_view value = argv[++i];
+        if (arg == "--mode") {
+            mode = value;
+        } else if (arg == "--output") {
+            output = value;
+        } else if (arg == "--jobs") {
+            jobs = std::max(static_cast<unsigned int>(ParseValue(value)), 1u);
+        } else if (arg == "--param") {
+            auto [name, list] = SplitAssignment(value);
+            std::vector<std::string> values;
+            while (true) {
+                auto comma = list.find(',');
+                auto item = list.substr(0, comma);
+                ParseValue(item);
+                values.emplace_back(item);
+                if (comma == std::string_view::npos) {
+                    break;
+                }
+                list.remove_prefix(comma + 1);
+            }
+            axes.emplace_back(FindParameter(name), std::move(values));
+        } else {
+            throw std::invalid_argument{
+                fmt::format("unknown argument '{}'", arg)};
+        }
+    }
+
+    if (mode.empty()) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+#ifdef _WIN32
+    fmt::print(stderr, "Parameter sweeps aren't supported on Windows\n");
+    return EXIT_FAILURE;
+#else
+#ifdef __linux__
+    std::string executable = "/proc/self/exe";
+#else
+    std::string executable = argv[0];
+#endif
+
+    // Grid point i selects value (i / stride) % size along each axis, where
+    // stride is the product of the sizes of the axes after it
+    size_t numRuns = 1;
+    for (const auto& axis : axes) {
+        numRuns *= axis.second.size();
+    }
+    auto gridPoint = [&](size_t run) {
+        std::vector<const std::string*> values(axes.size());
+        for (size_t axis = axes.size(); axis-- > 0;) {
+            const auto& axisValues = axes[axis].second;
+            values[axis] = &axisValues[run % axisValues.size()];
+            run /= axisValues.size();
+        }
+        return values;
+    };
+
+    fs::path tempDir = fs::temp_directory_path() /
+                       fmt::format("frc3512-sweep-{}", ::getpid());
+    fs::create_directories(tempDir);
+
+    std::vector<std::string> rows(numRuns);
+    std::map<pid_t, size_t> running;
+    size_t nextRun = 0;
+    size_t numFailed = 0;
+
+    fmt::print("Simulating {} runs of '{}' with {} workers\n", numRuns, mode,
+               jobs);
+
+    while (nextRun < numRuns || !running.empty()) {
+        while (nextRun < numRuns && running.size() < jobs) {
+            fs::path workdir = tempDir / std::to_string(nextRun);
+            fs::create_directory(workdir);
+
+            std::vector<std::string> args{
+                "--worker", "--mode",    mode, "--result", "result.csv",
+                "--workdir", workdir.string()};
+            auto values = gridPoint(nextRun);
+            for (size_t axis = 0; axis < axes.size(); ++axis) {
+                args.emplace_back("--set");
+                args.emplace_back(
+                    fmt::format("{}={}", axes[axis].first->name,
+                                *values[axis]));
+            }
+
+            running.emplace(SpawnWorker(executable, args, workdir), nextRun);
+            ++nextRun;
+        }
+
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid == -1) {
+            throw std::runtime_error{fmt::format("waitpid() failed: {}",
+                                                 std::strerror(errno))};
+        }
+        auto it = running.find(pid);
+        if (it == running.end()) {
+            continue;
+        }
+        size_t run = it->second;
+        running.erase(it);
+
+        fs::path workdir = tempDir / std::to_string(run);
+        std::string result;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+            result = ReadLine(workdir / "result.csv");
+        }
+
+        std::string& row = rows[run];
+        for (auto value : gridPoint(run)) {
+            row += *value;
+            row += ',';
+        }
+        if (result.empty()) {
+            // Keep the failed worker's directory so its log can be read
+            ++numFailed;
+            row += "failed,,,,,,,";
+            fmt::print(stderr, "Run {} failed; see {}\n", run,
+                       (workdir / "stderr.log").string());
+        } else {
+            row += result;
+            fs::remove_all(workdir);
+        }
+    }
+
+    std::FILE* file = std::fopen(output.c_str(), "w");
+    if (file == nullptr) {
+        throw std::runtime_error{
+            fmt::format("failed to open '{}': {}", output,
+                        std::strerror(errno))};
+    }
+    for (const auto& axis : axes) {
+        fmt::print(file, "{},", axis.first->name);
+    }
+    fmt::print(file, "{}\n", kResultColumns);
+    for (const auto& row : rows) {
+        fmt::print(file, "{}\n", row);
+    }
+    std::fclose(file);
+
+    if (numFailed == 0) {
+        fs::remove_all(tempDir);
+    }
+
+    fmt::print("Wrote {} ({} of {} runs failed)\n", output, numFailed,
+               numRuns);
+
+    return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 1 && std::string_view{argv[1]} == "--worker") {
+            return RunWorker(argc, argv);
+        } else {
+            return RunSweep(argc, argv);
+        }
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
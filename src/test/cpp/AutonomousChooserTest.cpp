@@ -0,0 +1,174 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "AutonomousChooser.hpp"
+#include "AutonomousSequence.hpp"
+
+namespace {
+
+using frc3512::AutonomousChooser;
+using frc3512::AutonomousSequence;
+
+// The number of times the "Count" mode yields before it returns
+constexpr int kCountSteps = 3;
+
+class AutonomousChooserTest : public testing::Test {
+protected:
+    // The number of steps the "Count" mode has started
+    int steps = 0;
+
+    std::unique_ptr<AutonomousChooser> chooser;
+
+    /**
+     * Creates the chooser with a "No-op" default mode and a "Count" mode.
+     *
+     * @param mode How the autonomous modes are run.
+     */
+    void CreateChooser(AutonomousChooser::ExecutionMode mode) {
+        chooser = std::make_unique<AutonomousChooser>("No-op", [] {}, mode);
+        chooser->AddAutonomous("Count", [this] {
+            for (int i = 0; i < kCountSteps; ++i) {
+                ++steps;
+                chooser->YieldToMain();
+            }
+        });
+    }
+
+    void ExpectOneStepPerLoop() {
+        chooser->SelectAutonomous("Count");
+
+        chooser->AwaitStartAutonomous();
+        EXPECT_EQ(steps, 1);
+        EXPECT_TRUE(chooser->IsAutonomousRunning());
+
+        for (int i = 2; i <= kCountSteps; ++i) {
+            chooser->AwaitRunAutonomous();
+            EXPECT_EQ(steps, i);
+        }
+
+        // The last resume returns from the mode
+        chooser->AwaitRunAutonomous();
+        EXPECT_FALSE(chooser->IsAutonomousRunning());
+        EXPECT_EQ(steps, kCountSteps);
+    }
+
+    void ExpectEndRunsModeToCompletion() {
+        chooser->SelectAutonomous("Count");
+        chooser->AwaitStartAutonomous();
+
+        chooser->EndAutonomous();
+        EXPECT_FALSE(chooser->IsAutonomousRunning());
+        EXPECT_EQ(steps, kCountSteps);
+    }
+
+    void ExpectRestartFinishesPreviousRun() {
+        chooser->SelectAutonomous("Count");
+        chooser->AwaitStartAutonomous();
+
+        chooser->AwaitStartAutonomous();
+        EXPECT_EQ(steps, kCountSteps + 1);
+        EXPECT_TRUE(chooser->IsAutonomousRunning());
+
+        chooser->EndAutonomous();
+    }
+};
+
+}  // namespace
+
+TEST_F(AutonomousChooserTest, ListsNamesInOrder) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kFiber);
+    chooser->AddAutonomous("Alpha", [] {});
+
+    EXPECT_EQ(chooser->GetAutonomousNames(),
+              (std::vector<std::string>{"Alpha", "Count", "No-op"}));
+}
+
+TEST_F(AutonomousChooserTest, RunsDefaultMode) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+    chooser->AwaitStartAutonomous();
+
+    EXPECT_FALSE(chooser->IsAutonomousRunning());
+    EXPECT_EQ(steps, 0);
+}
+
+TEST_F(AutonomousChooserTest, ThreadRunsOneStepPerLoop) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+    ExpectOneStepPerLoop();
+}
+
+TEST_F(AutonomousChooserTest, FiberRunsOneStepPerLoop) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kFiber);
+    ExpectOneStepPerLoop();
+}
+
+TEST_F(AutonomousChooserTest, ThreadEndRunsModeToCompletion) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+    ExpectEndRunsModeToCompletion();
+}
+
+TEST_F(AutonomousChooserTest, FiberEndRunsModeToCompletion) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kFiber);
+    ExpectEndRunsModeToCompletion();
+}
+
+TEST_F(AutonomousChooserTest, ThreadRestartFinishesPreviousRun) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+    ExpectRestartFinishesPreviousRun();
+}
+
+TEST_F(AutonomousChooserTest, FiberRestartFinishesPreviousRun) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kFiber);
+    ExpectRestartFinishesPreviousRun();
+}
+
+TEST_F(AutonomousChooserTest, AdvancesSequenceEachLoop) {
+    using Seq = AutonomousSequence;
+
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+
+    int polls = 0;
+    bool finished = false;
+    chooser->AddAutonomous(
+        "Sequence",
+        Seq{Seq::Sequential(Seq::WaitUntil([&] { return ++polls >= 3; }),
+                            Seq::Instant([&] { finished = true; }))});
+    chooser->SelectAutonomous("Sequence");
+
+    chooser->AwaitStartAutonomous();
+    EXPECT_TRUE(chooser->IsAutonomousRunning());
+
+    for (int i = 0; i < 10 && chooser->IsAutonomousRunning(); ++i) {
+        chooser->AwaitRunAutonomous();
+    }
+    EXPECT_FALSE(chooser->IsAutonomousRunning());
+    EXPECT_EQ(polls, 3);
+    EXPECT_TRUE(finished);
+
+    // Sequences don't run on the worker
+    EXPECT_EQ(steps, 0);
+}
+
+TEST_F(AutonomousChooserTest, WarmsUpOnSelectionChange) {
+    CreateChooser(AutonomousChooser::ExecutionMode::kThread);
+
+    int warmUps = 0;
+    chooser->AddAutonomous("Warm", [] {}, [&] { ++warmUps; });
+    chooser->SelectAutonomous("Warm");
+
+    EXPECT_TRUE(chooser->WarmUpSelected());
+    EXPECT_EQ(warmUps, 1);
+
+    // An unchanged selection isn't warmed up again until the period passes
+    EXPECT_FALSE(chooser->WarmUpSelected());
+    EXPECT_EQ(warmUps, 1);
+
+    // Modes without a warm-up are skipped
+    chooser->SelectAutonomous("Count");
+    EXPECT_FALSE(chooser->WarmUpSelected());
+    EXPECT_EQ(warmUps, 1);
+}
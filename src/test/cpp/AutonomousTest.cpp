@@ -0,0 +1,85 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <units/math.h>
+
+#include "AutonomousSimulation.hpp"
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+// Every mode has to finish within the 15 second autonomous period
+AutonomousResult RunToCompletion(wpi::StringRef name) {
+    auto result = SimulateAutonomous(name);
+    EXPECT_TRUE(result.finished)
+        << name.str() << " was still running after "
+        << result.duration.to<double>() << " s";
+    return result;
+}
+
+// Forward is positive distance on both sides
+void ExpectDroveForward(const AutonomousResult& result) {
+    EXPECT_GT(result.leftDistance, 12_in);
+    EXPECT_GT(result.rightDistance, 12_in);
+}
+
+// For modes that turn, where a side's net distance can go either way
+void ExpectDrove(const AutonomousResult& result) {
+    EXPECT_GT(units::math::abs(result.leftDistance), 12_in);
+    EXPECT_GT(units::math::abs(result.rightDistance), 12_in);
+}
+
+void ExpectElevatorAt(const AutonomousResult& result, units::inch_t height) {
+    EXPECT_NEAR(result.elevatorHeight.to<double>(), height.to<double>(), 1.0);
+}
+
+}  // namespace
+
+TEST(AutonomousTest, NoOp) { RunToCompletion("No-op"); }
+
+TEST(AutonomousTest, DriveForward) {
+    auto result = RunToCompletion("DriveForward");
+    ExpectDroveForward(result);
+}
+
+TEST(AutonomousTest, ResetElevator) {
+    auto result = RunToCompletion("ResetElevator");
+    ExpectElevatorAt(result, Elevator::kGroundHeight);
+}
+
+TEST(AutonomousTest, OneCanLeft) {
+    auto result = RunToCompletion("OneCanLeft");
+    ExpectDroveForward(result);
+    ExpectElevatorAt(result, Elevator::kToteHeight4);
+}
+
+TEST(AutonomousTest, OneCanCenter) {
+    auto result = RunToCompletion("OneCanCenter");
+    ExpectDroveForward(result);
+    ExpectElevatorAt(result, Elevator::kToteHeight4);
+}
+
+TEST(AutonomousTest, OneCanRight) {
+    auto result = RunToCompletion("OneCanRight");
+    ExpectElevatorAt(result, Elevator::kToteHeight4);
+}
+
+TEST(AutonomousTest, OneTote) {
+    auto result = RunToCompletion("OneTote");
+    ExpectDrove(result);
+}
+
+TEST(AutonomousTest, DriveForwardTrajectory) {
+    auto result = RunToCompletion("DriveForwardTrajectory");
+
+    // The trajectory ends 3 m ahead of the starting pose. The signs are
+    // checked too, since a sign error in the tracking, the feedforward or
+    // either side's inversion would drive the same distance backward.
+    EXPECT_NEAR(result.pose.X().to<double>(), 3.0, 0.25);
+    EXPECT_NEAR(result.pose.Y().to<double>(), 0.0, 0.25);
+
+    // The path is straight, so both wheels travel its length forward
+    constexpr units::inch_t kLength = 3_m;
+    EXPECT_NEAR(result.leftDistance.to<double>(), kLength.to<double>(), 10.0);
+    EXPECT_NEAR(result.rightDistance.to<double>(), kLength.to<double>(), 10.0);
+}
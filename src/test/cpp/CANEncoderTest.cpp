@@ -0,0 +1,69 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <ctre/phoenix/motorcontrol/can/WPI_TalonSRX.h>
+#include <gtest/gtest.h>
+
+#include "CANEncoder.hpp"
+#include "CANSensorSnapshot.hpp"
+
+namespace {
+
+class CANEncoderTest : public testing::Test {
+protected:
+    static constexpr int kDeviceID = 20;
+    static constexpr double kDistancePerPulse = 0.5;
+
+    ctre::phoenix::motorcontrol::can::WPI_TalonSRX motor{kDeviceID};
+    CANEncoder encoder{motor, kDistancePerPulse};
+
+    // The count the fake Talon reports
+    int position = 0;
+
+    void SetUp() override {
+        CANSensorSnapshot::GetInstance().SetReadingSource([=](int deviceID) {
+            CANSensorSnapshot::Reading reading;
+            if (deviceID == kDeviceID) {
+                reading.quadraturePosition = position;
+            }
+            return reading;
+        });
+    }
+
+    void TearDown() override {
+        CANSensorSnapshot::GetInstance().SetReadingSource(nullptr);
+    }
+};
+
+}  // namespace
+
+TEST_F(CANEncoderTest, ResetHoldsUntilTalonMoves) {
+    position = 1000;
+    CANSensorSnapshot::GetInstance().Update();
+    EXPECT_DOUBLE_EQ(encoder.GetDistance(), 1000 * kDistancePerPulse);
+
+    encoder.Reset();
+    EXPECT_DOUBLE_EQ(encoder.GetDistance(), 0.0);
+
+    // A real Talon keeps sending its old count for a frame or more after a
+    // reset, which must not bring the old distance back
+    CANSensorSnapshot::GetInstance().Update();
+    EXPECT_DOUBLE_EQ(encoder.GetDistance(), 0.0);
+    CANSensorSnapshot::GetInstance().Update();
+    EXPECT_DOUBLE_EQ(encoder.GetDistance(), 0.0);
+
+    position = 1100;
+    CANSensorSnapshot::GetInstance().Update();
+    EXPECT_DOUBLE_EQ(encoder.GetDistance(), 100 * kDistancePerPulse);
+}
+
+TEST_F(CANEncoderTest, SensorPositionIncludesReset) {
+    position = 1000;
+    CANSensorSnapshot::GetInstance().Update();
+    encoder.Reset();
+
+    // Closed-loop goals are in the Talon's unreset count
+    EXPECT_DOUBLE_EQ(encoder.ToSensorPosition(0.0), 1000.0);
+    EXPECT_DOUBLE_EQ(encoder.ToSensorPosition(10.0),
+                     1000.0 + 10.0 / kDistancePerPulse);
+    EXPECT_DOUBLE_EQ(encoder.ToSensorDistance(10.0), 10.0 / kDistancePerPulse);
+}
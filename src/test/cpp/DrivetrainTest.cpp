@@ -0,0 +1,95 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <units/length.h>
+#include <units/math.h>
+
+#include "SimulatedRobotTest.hpp"
+#include "subsystems/Drivetrain.hpp"
+
+namespace {
+
+class DrivetrainTest : public SimulatedRobotTest {
+protected:
+    Drivetrain drivetrain;
+
+    // The open-loop command applied each loop while the controllers are
+    // disabled
+    double throttle = 0.0;
+    double turn = 0.0;
+
+    void MainLoop() override {
+        if (!drivetrain.AreControllersEnabled()) {
+            drivetrain.Drive(throttle, turn, true);
+        }
+    }
+
+    void Controllers() override { drivetrain.UpdateControllers(); }
+
+    void Simulation(units::second_t dt) override {
+        drivetrain.SimulationPeriodic(dt);
+    }
+};
+
+}  // namespace
+
+TEST_F(DrivetrainTest, StartsAtRest) {
+    RunFor(0.5_s);
+
+    EXPECT_NEAR(drivetrain.GetLeftDistance().to<double>(), 0.0, 0.1);
+    EXPECT_NEAR(drivetrain.GetRightDistance().to<double>(), 0.0, 0.1);
+}
+
+TEST_F(DrivetrainTest, DrivesStraight) {
+    throttle = -0.5;
+    RunFor(1_s);
+
+    auto left = drivetrain.GetLeftDistance();
+    auto right = drivetrain.GetRightDistance();
+    EXPECT_GT(units::math::abs(left), 12_in);
+    EXPECT_NEAR(units::math::abs(left).to<double>(),
+                units::math::abs(right).to<double>(), 1.0);
+
+    auto pose = drivetrain.GetSimulatedPose();
+    EXPECT_GT(units::math::abs(pose.X()), 0.3_m);
+    EXPECT_NEAR(pose.Y().to<double>(), 0.0, 0.05);
+}
+
+TEST_F(DrivetrainTest, TurnsInPlace) {
+    turn = 0.5;
+    RunFor(1_s);
+
+    // A quick turn drives the sides in opposite directions
+    auto left = drivetrain.GetLeftDistance();
+    auto right = drivetrain.GetRightDistance();
+    EXPECT_GT(units::math::abs(left), 1_in);
+    EXPECT_LT((left * right).to<double>(), 0.0);
+    EXPECT_NEAR(units::math::abs(left).to<double>(),
+                units::math::abs(right).to<double>(), 1.0);
+}
+
+TEST_F(DrivetrainTest, ResetEncodersZeroesDistance) {
+    throttle = -0.5;
+    RunFor(0.5_s);
+    throttle = 0.0;
+    RunFor(1_s);
+
+    drivetrain.ResetEncoders();
+    RunFor(kLoopPeriod);
+
+    EXPECT_NEAR(drivetrain.GetLeftDistance().to<double>(), 0.0, 0.5);
+    EXPECT_NEAR(drivetrain.GetRightDistance().to<double>(), 0.0, 0.5);
+}
+
+TEST_F(DrivetrainTest, ReachesPositionGoal) {
+    drivetrain.SetSetpointsToMeasurements();
+    drivetrain.SetLeftGoal(3_ft);
+    drivetrain.SetRightGoal(3_ft);
+    drivetrain.SetControllersEnabled(true);
+
+    EXPECT_TRUE(RunUntil(
+        [&] { return drivetrain.LeftAtGoal() && drivetrain.RightAtGoal(); },
+        5_s));
+    EXPECT_NEAR(drivetrain.GetLeftDistance().to<double>(), 36.0, 2.0);
+    EXPECT_NEAR(drivetrain.GetRightDistance().to<double>(), 36.0, 2.0);
+}
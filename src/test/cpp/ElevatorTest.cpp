@@ -0,0 +1,203 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <vector>
+
+#include <frc/RobotController.h>
+#include <gtest/gtest.h>
+#include <units/length.h>
+#include <units/math.h>
+
+#include "LatencyTracer.hpp"
+#include "SimulatedRobotTest.hpp"
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+using frc3512::LatencyTracer;
+
+class ElevatorTest : public SimulatedRobotTest {
+protected:
+    Elevator elevator;
+
+    // The goals the elevator's motion profile was given after SetUp(), in
+    // order. Zeroing on the limit switch retargets the goal by less than the
+    // threshold, so it isn't recorded.
+    static constexpr units::inch_t kGoalThreshold = 0.5_in;
+    std::vector<units::inch_t> goals;
+    units::inch_t lastGoal = 0_in;
+
+    void SetUp() override {
+        SimulatedRobotTest::SetUp();
+
+        // The first controller tick zeroes the encoder at the limit switch
+        RunFor(kLoopPeriod);
+        lastGoal = elevator.GetGoal();
+    }
+
+    void MainLoop() override {
+        elevator.UpdateState();
+
+        units::inch_t goal = elevator.GetGoal();
+        if (units::math::abs(goal - lastGoal) > kGoalThreshold) {
+            goals.push_back(goal);
+            lastGoal = goal;
+        }
+    }
+
+    void Controllers() override { elevator.UpdateController(); }
+
+    void Simulation(units::second_t dt) override {
+        elevator.SimulationPeriodic(dt);
+    }
+
+    /**
+     * Runs until the elevator finishes stacking.
+     *
+     * @return True if it finished before the timeout.
+     */
+    bool RunUntilStacked(units::second_t timeout) {
+        return RunUntil([&] { return !elevator.IsStacking(); }, timeout);
+    }
+
+    /**
+     * Returns the goals of one auto-stack cycle.
+     */
+    std::vector<units::inch_t> StackGoals() const {
+        return {elevator.toteHeight1.Get(),
+                elevator.toteHeight1.Get() - elevator.autoDropHeight.Get(),
+                Elevator::kGroundHeight, elevator.toteHeight2.Get()};
+    }
+
+    void ExpectGoals(const std::vector<units::inch_t>& expected) {
+        ASSERT_EQ(goals.size(), expected.size());
+        for (size_t i = 0; i < goals.size(); ++i) {
+            EXPECT_NEAR(goals[i].to<double>(), expected[i].to<double>(), 1e-6)
+                << "at goal " << i;
+        }
+    }
+};
+
+}  // namespace
+
+TEST_F(ElevatorTest, ReachesGoal) {
+    elevator.RaiseElevator(Elevator::kToteHeight3);
+
+    EXPECT_TRUE(RunUntil([&] { return elevator.AtGoal(); }, 3_s));
+    EXPECT_NEAR(units::inch_t{elevator.GetHeight()}.to<double>(),
+                Elevator::kToteHeight3.to<double>(), 1.0);
+}
+
+TEST_F(ElevatorTest, StacksTote) {
+    ASSERT_TRUE(elevator.StackTotes());
+    EXPECT_EQ(elevator.GetQueuedCommandCount(), 1u);
+
+    EXPECT_TRUE(RunUntilStacked(10_s));
+    ExpectGoals(StackGoals());
+
+    EXPECT_TRUE(elevator.IsElevatorGrabbed());
+    EXPECT_TRUE(elevator.IsIntakeGrabbed());
+    EXPECT_EQ(elevator.GetQueuedCommandCount(), 0u);
+}
+
+TEST_F(ElevatorTest, SkipsInitialHeightWhenAlreadyThere) {
+    elevator.RaiseElevator(elevator.toteHeight1.Get());
+    ASSERT_TRUE(RunUntil([&] { return elevator.AtGoal(); }, 3_s));
+    goals.clear();
+
+    // WAIT_INITIAL_HEIGHT is already satisfied, so the first loop of the
+    // cycle goes straight on to lowering the totes
+    ASSERT_TRUE(elevator.StackTotes());
+    RunFor(kLoopPeriod);
+    ExpectGoals({elevator.toteHeight1.Get() - elevator.autoDropHeight.Get()});
+}
+
+TEST_F(ElevatorTest, RunsQueuedCommandsInOrder) {
+    ASSERT_TRUE(elevator.StackTotes());
+
+    // The commands after the first one queue once it's running
+    RunFor(kLoopPeriod);
+    ASSERT_TRUE(elevator.StackTotes());
+    ASSERT_TRUE(elevator.RaiseElevator(Elevator::kToteHeight4));
+    EXPECT_EQ(elevator.GetQueuedCommandCount(), 2u);
+
+    EXPECT_TRUE(RunUntilStacked(20_s));
+
+    std::vector<units::inch_t> expected;
+    for (int i = 0; i < 2; ++i) {
+        auto cycle = StackGoals();
+        expected.insert(expected.end(), cycle.begin(), cycle.end());
+    }
+    expected.push_back(Elevator::kToteHeight4);
+    ExpectGoals(expected);
+}
+
+TEST_F(ElevatorTest, QueuesMoveBehindCommandFromSameLoop) {
+    // Both are pressed before the state machine runs the stack
+    ASSERT_TRUE(elevator.StackTotes());
+    ASSERT_TRUE(elevator.RaiseElevator(Elevator::kToteHeight4));
+    EXPECT_EQ(elevator.GetQueuedCommandCount(), 2u);
+
+    EXPECT_TRUE(RunUntilStacked(10_s));
+
+    auto expected = StackGoals();
+    expected.push_back(Elevator::kToteHeight4);
+    ExpectGoals(expected);
+}
+
+TEST_F(ElevatorTest, RejectsCommandsWhenQueueIsFull) {
+    for (size_t i = 0; i < Elevator::kMaxQueuedCommands; ++i) {
+        EXPECT_TRUE(elevator.StackTotes());
+    }
+    EXPECT_FALSE(elevator.StackTotes());
+}
+
+TEST_F(ElevatorTest, CancelDropsQueuedCommands) {
+    elevator.StackTotes();
+    elevator.StackTotes();
+    RunFor(kLoopPeriod);
+    EXPECT_TRUE(elevator.IsStacking());
+
+    elevator.CancelStack();
+    EXPECT_FALSE(elevator.IsStacking());
+    EXPECT_EQ(elevator.GetQueuedCommandCount(), 0u);
+
+    RunFor(1_s);
+    EXPECT_FALSE(elevator.IsStacking());
+}
+
+TEST_F(ElevatorTest, TracesQueuedCommandToLiftOutput) {
+    auto& tracer = LatencyTracer::GetInstance();
+    tracer.Reset();
+
+    {
+        LatencyTracer::Scope trace{frc::RobotController::GetFPGATime()};
+        ASSERT_TRUE(elevator.StackTotes());
+    }
+
+    // The state machine sets the first goal in the next loop, and the
+    // controller tick after that drives the lift toward it
+    RunFor(kLoopPeriod);
+    const auto& goal = tracer.GetLatency(LatencyTracer::Output::kLiftGoal);
+    const auto& lift = tracer.GetLatency(LatencyTracer::Output::kLift);
+    EXPECT_EQ(goal.GetCount(), 1u);
+    EXPECT_EQ(lift.GetCount(), 1u);
+    EXPECT_GE(lift.GetMax(), goal.GetMax());
+    EXPECT_LE(lift.GetMax(), kLoopPeriod);
+
+    // Later goals of the cycle aren't traced again
+    EXPECT_TRUE(RunUntilStacked(10_s));
+    EXPECT_EQ(goal.GetCount(), 1u);
+    EXPECT_EQ(lift.GetCount(), 1u);
+}
+
+TEST_F(ElevatorTest, UntracedInputsRecordNothing) {
+    auto& tracer = LatencyTracer::GetInstance();
+    tracer.Reset();
+
+    elevator.ElevatorGrab(true);
+    elevator.RaiseElevator(Elevator::kToteHeight2);
+    RunFor(kLoopPeriod);
+
+    EXPECT_EQ(tracer.GetLatency(LatencyTracer::Output::kTines).GetCount(), 0u);
+    EXPECT_EQ(tracer.GetLatency(LatencyTracer::Output::kLift).GetCount(), 0u);
+}
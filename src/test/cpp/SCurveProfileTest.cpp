@@ -0,0 +1,124 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <units/length.h>
+#include <units/math.h>
+
+#include "SCurveProfile.hpp"
+
+namespace {
+
+using Profile = frc3512::SCurveProfile<units::inches>;
+
+constexpr units::second_t kDt = 1_ms;
+
+// The elevator's up constraints
+constexpr Profile::Constraints kConstraints{
+    88_in / 1_s, 88_in / 1_s / 0.4_s, 88_in / 1_s / 0.4_s / 0.1_s};
+
+/**
+ * Expects the profile to stay within its constraints and to end at rest at
+ * the goal.
+ */
+void ExpectValid(const Profile& profile, units::inch_t goal) {
+    constexpr double kTolerance = 1e-6;
+
+    for (auto t = 0_s; t <= profile.TotalTime(); t += kDt) {
+        auto state = profile.Calculate(t);
+        EXPECT_LE(units::math::abs(state.velocity).to<double>(),
+                  kConstraints.maxVelocity.to<double>() + kTolerance)
+            << "at t = " << t.to<double>();
+        EXPECT_LE(units::math::abs(state.acceleration).to<double>(),
+                  kConstraints.maxAcceleration.to<double>() + kTolerance)
+            << "at t = " << t.to<double>();
+    }
+
+    ASSERT_TRUE(profile.IsFinished(profile.TotalTime()));
+    auto end = profile.Calculate(profile.TotalTime());
+    EXPECT_NEAR(end.position.to<double>(), goal.to<double>(), kTolerance);
+    EXPECT_EQ(end.velocity.to<double>(), 0.0);
+    EXPECT_EQ(end.acceleration.to<double>(), 0.0);
+
+    // The last phase arrives at the goal without a jump
+    auto last = profile.Calculate(profile.TotalTime() - kDt);
+    EXPECT_NEAR(last.position.to<double>(), goal.to<double>(), 1e-3);
+    EXPECT_NEAR(last.velocity.to<double>(), 0.0, 0.1);
+}
+
+}  // namespace
+
+TEST(SCurveProfileTest, ReachesGoalAtRest) {
+    Profile profile{kConstraints, 42_in};
+
+    EXPECT_GT(profile.TotalTime(), 0_s);
+    ExpectValid(profile, 42_in);
+
+    // A move from rest starts without any acceleration
+    auto start = profile.Calculate(0_s);
+    EXPECT_EQ(start.position.to<double>(), 0.0);
+    EXPECT_EQ(start.acceleration.to<double>(), 0.0);
+}
+
+TEST(SCurveProfileTest, StaysAtRestAtGoal) {
+    Profile profile{kConstraints, 16_in, {16_in, 0_in / 1_s, 0_in / 1_s / 1_s}};
+
+    EXPECT_EQ(profile.TotalTime(), 0_s);
+    EXPECT_TRUE(profile.IsFinished(0_s));
+}
+
+TEST(SCurveProfileTest, ReplanningMidMoveIsContinuous) {
+    Profile first{kConstraints, 60_in};
+
+    // Replan to a lower goal while still accelerating toward the first one
+    auto t = 0.2_s;
+    auto initial = first.Calculate(t);
+    ASSERT_GT(initial.acceleration, 0_in / 1_s / 1_s);
+
+    Profile second{kConstraints, 20_in, initial};
+    auto start = second.Calculate(0_s);
+    EXPECT_NEAR(start.position.to<double>(), initial.position.to<double>(),
+                1e-9);
+    EXPECT_NEAR(start.velocity.to<double>(), initial.velocity.to<double>(),
+                1e-9);
+    EXPECT_NEAR(start.acceleration.to<double>(),
+                initial.acceleration.to<double>(), 1e-9);
+
+    // No step is larger than the jerk limit allows
+    auto previous = start;
+    for (auto time = kDt; time <= second.TotalTime(); time += kDt) {
+        auto state = second.Calculate(time);
+        EXPECT_LE(units::math::abs(state.acceleration - previous.acceleration)
+                      .to<double>(),
+                  (kConstraints.maxJerk * kDt).to<double>() + 1e-6)
+            << "at t = " << time.to<double>();
+        previous = state;
+    }
+
+    ExpectValid(second, 20_in);
+}
+
+TEST(SCurveProfileTest, OvershootingStartStopsAndComesBack) {
+    // Moving up at full speed 1 in below the goal can't stop in time
+    Profile profile{kConstraints, 11_in,
+                    {10_in, kConstraints.maxVelocity, 0_in / 1_s / 1_s}};
+
+    units::inch_t highest = 10_in;
+    for (auto t = 0_s; t <= profile.TotalTime(); t += kDt) {
+        highest = units::math::max(highest, profile.Calculate(t).position);
+    }
+    EXPECT_GT(highest, 11_in);
+
+    ExpectValid(profile, 11_in);
+}
+
+TEST(SCurveProfileTest, TimeLeftUntilFindsFirstCrossing) {
+    Profile profile{kConstraints, 30_in};
+
+    auto t = profile.TimeLeftUntil(15_in);
+    EXPECT_GT(t, 0_s);
+    EXPECT_LT(t, profile.TotalTime());
+    EXPECT_NEAR(profile.Calculate(t).position.to<double>(), 15.0, 1e-3);
+
+    // A height the profile never reaches takes the whole profile
+    EXPECT_EQ(profile.TimeLeftUntil(40_in), profile.TotalTime());
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "SimulatedRobotTest.hpp"
+
+#include <cmath>
+
+#include <frc/simulation/DriverStationSim.h>
+#include <frc/simulation/SimHooks.h>
+
+#include "CANSensorSnapshot.hpp"
+#include "Constants.hpp"
+#include "PowerMonitor.hpp"
+
+namespace {
+
+// Returns how many periods fit in a duration. Counting periods instead of
+// summing them keeps floating-point error from adding an extra one.
+int Periods(units::second_t duration, units::second_t period) {
+    return static_cast<int>(std::round((duration / period).to<double>()));
+}
+
+}  // namespace
+
+void SimulatedRobotTest::SetUp() {
+    frc::sim::PauseTiming();
+
+    frc::sim::DriverStationSim::ResetData();
+    frc::sim::DriverStationSim::SetDsAttached(true);
+    frc::sim::DriverStationSim::SetAutonomous(false);
+    frc::sim::DriverStationSim::SetEnabled(true);
+    frc::sim::DriverStationSim::NotifyNewData();
+}
+
+void SimulatedRobotTest::TearDown() {
+    frc::sim::DriverStationSim::SetEnabled(false);
+    frc::sim::DriverStationSim::NotifyNewData();
+
+    frc::sim::ResumeTiming();
+}
+
+bool SimulatedRobotTest::RunUntil(std::function<bool()> condition,
+                                  units::second_t timeout) {
+    for (int i = 0; i < Periods(timeout, kLoopPeriod); ++i) {
+        RunLoop();
+        if (condition()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimulatedRobotTest::RunFor(units::second_t duration) {
+    for (int i = 0; i < Periods(duration, kLoopPeriod); ++i) {
+        RunLoop();
+    }
+}
+
+void SimulatedRobotTest::RunLoop() {
+    CANSensorSnapshot::GetInstance().Update();
+    PowerMonitor::GetInstance().Update();
+    MainLoop();
+
+    Simulation(kLoopPeriod);
+
+    constexpr auto kControllerPeriod = frc3512::Constants::kControllerPeriod;
+    for (int i = 0; i < Periods(kLoopPeriod, kControllerPeriod); ++i) {
+        frc::sim::StepTiming(kControllerPeriod);
+        CANSensorSnapshot::GetInstance().Update();
+        Controllers();
+    }
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "StateMachine.hpp"
+
+namespace {
+
+enum class TestState { kFirst, kSecond, kNumStates };
+
+enum class ChildState { kInner, kNumStates };
+
+enum class ChainState { kA, kB, kC, kNumStates };
+
+/**
+ * Adds states that each record their runs and transition to the next one.
+ *
+ * @param machine The state machine.
+ * @param events  The log the states record their runs to.
+ * @param cyclic  True if the last state transitions back to the first.
+ */
+void AddChain(StateMachine<ChainState>& machine,
+              std::vector<std::string>& events, bool cyclic) {
+    State<ChainState> state;
+    state.run = [e = &events] { e->emplace_back("A run"); };
+    state.transition = [] { return std::optional{ChainState::kB}; };
+    machine.AddState(ChainState::kA, "A", state);
+
+    state.run = [e = &events] { e->emplace_back("B run"); };
+    state.transition = [] { return std::optional{ChainState::kC}; };
+    machine.AddState(ChainState::kB, "B", state);
+
+    state.run = [e = &events] { e->emplace_back("C run"); };
+    if (cyclic) {
+        state.transition = [] { return std::optional{ChainState::kA}; };
+    } else {
+        state.transition = [] { return std::optional<ChainState>{}; };
+    }
+    machine.AddState(ChainState::kC, "C", state);
+
+    machine.SetInitialState(ChainState::kA);
+}
+
+class StateMachineTest : public testing::Test {
+protected:
+    // The callbacks run so far, in order
+    std::vector<std::string> events;
+
+    // Makes the first state transition to the second
+    bool advance = false;
+
+    StateMachine<TestState> machine{"Test"};
+
+    void SetUp() override {
+        State<TestState> state;
+        state.entry = [this] { events.emplace_back("first entry"); };
+        state.run = [this] { events.emplace_back("first run"); };
+        state.transition = [this]() -> std::optional<TestState> {
+            if (advance) {
+                return TestState::kSecond;
+            } else {
+                return std::nullopt;
+            }
+        };
+        state.exit = [this] { events.emplace_back("first exit"); };
+        machine.AddState(TestState::kFirst, "FIRST", state);
+
+        state = State<TestState>{};
+        state.entry = [this] { events.emplace_back("second entry"); };
+        state.exit = [this] { events.emplace_back("second exit"); };
+        machine.AddState(TestState::kSecond, "SECOND", state);
+
+        machine.Validate();
+        machine.SetInitialState(TestState::kFirst);
+    }
+};
+
+}  // namespace
+
+TEST_F(StateMachineTest, RunsNothingBeforeEntered) {
+    machine.Run();
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(machine.GetStateName(), "");
+}
+
+TEST_F(StateMachineTest, RunsCallbacksInOrder) {
+    machine.Enter();
+    machine.Run();
+    advance = true;
+    machine.Run();
+
+    EXPECT_EQ(events, (std::vector<std::string>{"first entry", "first run",
+                                                 "first run", "first exit",
+                                                 "second entry"}));
+    EXPECT_EQ(machine.GetState(), TestState::kSecond);
+    EXPECT_EQ(machine.GetStateName(), "SECOND");
+}
+
+TEST_F(StateMachineTest, TransitionsByName) {
+    machine.Enter();
+
+    EXPECT_TRUE(machine.SetState("SECOND"));
+    EXPECT_EQ(machine.GetState(), TestState::kSecond);
+
+    EXPECT_FALSE(machine.SetState("THIRD"));
+    EXPECT_EQ(machine.GetState(), TestState::kSecond);
+}
+
+TEST_F(StateMachineTest, ExitLeavesCurrentState) {
+    machine.Enter();
+    machine.Exit();
+    machine.Run();
+
+    EXPECT_EQ(events,
+              (std::vector<std::string>{"first entry", "first exit"}));
+}
+
+TEST_F(StateMachineTest, CountsEntriesAndTransitions) {
+    machine.Enter();
+    machine.SetState(TestState::kSecond);
+    machine.SetState(TestState::kFirst);
+
+    EXPECT_EQ(machine.GetStats(TestState::kFirst).entries, 2u);
+    EXPECT_EQ(machine.GetStats(TestState::kSecond).entries, 1u);
+    EXPECT_EQ(machine.GetTransitionCount(), 3u);
+
+    machine.ResetStats();
+    EXPECT_EQ(machine.GetStats(TestState::kFirst).entries, 0u);
+    EXPECT_EQ(machine.GetTransitionCount(), 0u);
+}
+
+TEST(StateMachineValidateTest, ThrowsForMissingState) {
+    StateMachine<TestState> machine{"Incomplete"};
+    machine.AddState(TestState::kFirst, "FIRST", State<TestState>{});
+
+    EXPECT_THROW(machine.Validate(), std::logic_error);
+}
+
+TEST_F(StateMachineTest, EntersAndExitsChild) {
+    StateMachine<ChildState> child{"Child"};
+    State<ChildState> childState;
+    childState.entry = [this] { events.emplace_back("inner entry"); };
+    childState.run = [this] { events.emplace_back("inner run"); };
+    childState.exit = [this] { events.emplace_back("inner exit"); };
+    child.AddState(ChildState::kInner, "INNER", childState);
+    child.SetInitialState(ChildState::kInner);
+
+    StateMachine<TestState> parent{"Parent"};
+    parent.AddState(TestState::kFirst, "FIRST", child,
+                    [this]() -> std::optional<TestState> {
+                        if (advance) {
+                            return TestState::kSecond;
+                        } else {
+                            return std::nullopt;
+                        }
+                    });
+    parent.AddState(TestState::kSecond, "SECOND", State<TestState>{});
+    parent.SetInitialState(TestState::kFirst);
+
+    parent.Enter();
+    parent.Run();
+    advance = true;
+    parent.Run();
+
+    EXPECT_EQ(events, (std::vector<std::string>{"inner entry", "inner run",
+                                                 "inner run", "inner exit"}));
+    EXPECT_EQ(parent.GetState(), TestState::kSecond);
+}
+
+TEST(StateMachineChainTest, TakesOneTransitionPerRunByDefault) {
+    std::vector<std::string> events;
+    StateMachine<ChainState> machine{"Chain"};
+    AddChain(machine, events, false);
+
+    machine.Enter();
+    machine.Run();
+
+    EXPECT_EQ(events, (std::vector<std::string>{"A run"}));
+    EXPECT_EQ(machine.GetState(), ChainState::kB);
+}
+
+TEST(StateMachineChainTest, SettlesWithinOneRun) {
+    std::vector<std::string> events;
+    StateMachine<ChainState> machine{"Chain"};
+    AddChain(machine, events, false);
+    machine.SetMaxTransitionsPerRun(3);
+
+    machine.Enter();
+    machine.Run();
+
+    EXPECT_EQ(events,
+              (std::vector<std::string>{"A run", "B run", "C run"}));
+    EXPECT_EQ(machine.GetState(), ChainState::kC);
+    EXPECT_EQ(machine.GetTransitionCount(), 3u);
+}
+
+TEST(StateMachineChainTest, LimitsTransitionsOfCycle) {
+    std::vector<std::string> events;
+    StateMachine<ChainState> machine{"Cycle"};
+    AddChain(machine, events, true);
+    machine.SetMaxTransitionsPerRun(4);
+
+    machine.Enter();
+    machine.Run();
+
+    // A, B, C and A again run, and the fourth transition stops at B
+    EXPECT_EQ(events, (std::vector<std::string>{"A run", "B run", "C run",
+                                                 "A run"}));
+    EXPECT_EQ(machine.GetState(), ChainState::kB);
+
+    // The cycle continues from there in the next call
+    machine.Run();
+    EXPECT_EQ(machine.GetState(), ChainState::kC);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <functional>
+
+#include <gtest/gtest.h>
+#include <units/time.h>
+
+/**
+ * A fixture that runs subsystems in simulated time without a Robot.
+ *
+ * The HAL's clock is paused and the simulated driver station is enabled, so
+ * the Talons apply their outputs and each loop takes exactly one period. A
+ * derived fixture overrides the hooks to call its subsystems the way Robot and
+ * ControllerScheduler do.
+ *
+ * The HAL's state is global, so the tests of one process run one at a time.
+ * "./gradlew test" runs them all in one process. "./gradlew testParallel"
+ * splits them across one process per core instead.
+ */
+class SimulatedRobotTest : public testing::Test {
+public:
+    // Period of Robot's main loop
+    static constexpr units::second_t kLoopPeriod = 20_ms;
+
+protected:
+    void SetUp() override;
+    void TearDown() override;
+
+    /**
+     * Runs robot loops until a condition is true.
+     *
+     * Each loop runs MainLoop(), then Simulation(), then Controllers() once
+     * every Constants::kControllerPeriod until the loop period has passed. The
+     * condition is checked after each loop.
+     *
+     * @param condition Returns true when the test should stop running loops.
+     * @param timeout   Simulated time after which to give up.
+     * @return True if the condition became true before the timeout.
+     */
+    bool RunUntil(std::function<bool()> condition, units::second_t timeout);
+
+    /**
+     * Runs robot loops for a duration.
+     *
+     * @param duration Simulated time to run for.
+     */
+    void RunFor(units::second_t duration);
+
+    /**
+     * Called at the start of each loop, like TeleopPeriodic().
+     */
+    virtual void MainLoop() {}
+
+    /**
+     * Called each controller period, like the ControllerScheduler callbacks.
+     */
+    virtual void Controllers() {}
+
+    /**
+     * Called once per loop to step the physics models, like
+     * SimulationPeriodic().
+     *
+     * @param dt The time since the last call.
+     */
+    virtual void Simulation(units::second_t dt) {}
+
+private:
+    void RunLoop();
+};
@@ -0,0 +1,28 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+// Generates the trajectory files deployed with the robot program so the robot
+// doesn't have to generate them when it boots.
+//
+// Usage: frcUserProgramTrajectories [directory]
+//
+// Only trajectories whose files are missing or out of date are regenerated.
+
+#include <filesystem>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "Robot.hpp"
+#include "TrajectoryCache.hpp"
+
+int main(int argc, char* argv[]) {
+    std::string directory =
+        argc > 1 ? argv[1] : frc3512::TrajectoryCache::GetDefaultDirectory();
+    std::filesystem::create_directories(directory);
+
+    frc3512::TrajectoryCache cache{directory};
+    Robot::AddTrajectories(cache);
+    int generated = cache.Load();
+
+    fmt::print("Generated {} trajectories in {}\n", generated, directory);
+}
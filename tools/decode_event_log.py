@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Decodes binary event logs written by frc3512::EventLog.
+
+Usage: decode_event_log.py LOG [LOG ...]
+"""
+
+import mmap
+import struct
+import sys
+
+MAGIC = b"F3512EVT"
+VERSION = 1
+
+# Matches FileHeader in EventLog.cpp
+HEADER = struct.Struct("<8sIIII")
+
+# Matches EventRecord in EventLog.hpp
+RECORD = struct.Struct("<QHBBI4d16s")
+
+
+def read_formats(buf, num_events):
+    formats = []
+    offset = HEADER.size
+    for _ in range(num_events):
+        (length,) = struct.unpack_from("<H", buf, offset)
+        offset += 2
+        formats.append(buf[offset : offset + length].decode("utf-8"))
+        offset += length
+    return formats
+
+
+def decode(path):
+    with open(path, "rb") as f:
+        with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as buf:
+            magic, version, record_size, records_offset, num_events = (
+                HEADER.unpack_from(buf, 0)
+            )
+            if magic != MAGIC:
+                raise ValueError(f"{path}: not an event log")
+            if version != VERSION or record_size != RECORD.size:
+                raise ValueError(
+                    f"{path}: unsupported version {version} with "
+                    f"{record_size}-byte records"
+                )
+
+            formats = read_formats(buf, num_events)
+
+            # A partially written record at the end is ignored
+            num_records = (len(buf) - records_offset) // record_size
+            for i in range(num_records):
+                (
+                    timestamp,
+                    event,
+                    num_args,
+                    text_length,
+                    _,
+                    *args,
+                    text,
+                ) = RECORD.unpack_from(buf, records_offset + i * record_size)
+
+                fields = []
+                if text_length > 0:
+                    fields.append(text[:text_length].decode("utf-8", "replace"))
+                fields.extend(args[:num_args])
+
+                if event < len(formats):
+                    message = formats[event].format(*fields)
+                else:
+                    message = f"unknown event {event}: {fields}"
+                print(f"[{timestamp / 1e6:.6f}] {message}")
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        sys.exit(1)
+
+    for path in sys.argv[1:]:
+        decode(path)
+
+
+if __name__ == "__main__":
+    main()
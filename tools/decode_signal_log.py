@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Converts signal files written by frc3512::SignalRecorder to CSV.
+
+Usage: decode_signal_log.py SIG [SIG ...]
+
+Each SIG file is written to a CSV file with the same name next to it.
+"""
+
+import array
+import csv
+import struct
+import sys
+
+MAGIC = b"F3512SIG"
+VERSION = 1
+
+# Matches FileHeader in SignalRecorder.cpp
+HEADER = struct.Struct("<8sIIIIQ")
+
+
+def read_column(f, typecode, count):
+    column = array.array(typecode)
+    column.fromfile(f, count)
+    if sys.byteorder != "little":
+        column.byteswap()
+    return column
+
+
+def decode(path):
+    with open(path, "rb") as f:
+        magic, version, num_signals, num_samples, _, _ = HEADER.unpack(
+            f.read(HEADER.size)
+        )
+        if magic != MAGIC:
+            raise ValueError(f"{path}: not a signal file")
+        if version != VERSION:
+            raise ValueError(f"{path}: unsupported version {version}")
+
+        names = []
+        for _ in range(num_signals):
+            (length,) = struct.unpack("<H", f.read(2))
+            names.append(f.read(length).decode("utf-8"))
+
+        timestamps = read_column(f, "I", num_samples)
+        columns = [read_column(f, "f", num_samples) for _ in names]
+
+    csv_path = path.rsplit(".", 1)[0] + ".csv"
+    with open(csv_path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["Time (s)"] + names)
+        for i in range(num_samples):
+            writer.writerow(
+                [timestamps[i] / 1e6] + [column[i] for column in columns]
+            )
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        sys.exit(1)
+
+    for path in sys.argv[1:]:
+        decode(path)
+
+
+if __name__ == "__main__":
+    main()